@@ -0,0 +1,82 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Allocations per KB of input for a full parse, comparing tokens allocated
+// one by one from the global heap against the arena owned by `ParseResult`,
+// and against a warm `ParseContext` reused across parses.
+
+#include <cstddef>
+#include <cstdio>
+#include <memory_resource>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/token.hpp"
+#include "alloc_counter.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+static void Report(const char* mode, const std::string& doc,
+                   const bench::AllocStats& stats, double ms) {
+  const double kb = doc.size() / 1024.0;
+  std::printf("%-6s %8zu KB  %10.1f allocs/KB  %10.0f bytes/KB  %8.2f ms\n",
+              mode, doc.size() / 1024, stats.count / kb, stats.bytes / kb,
+              ms);
+}
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+
+  for (std::size_t size : {16 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+    const std::string doc = bench::MakeDocument(size);
+
+    // Heap: every token and string is its own global allocation.
+    {
+      bench::AllocStats before = bench::AllocSnapshot();
+      double ms = bench::BestOfMs(
+          [&] {
+            std::string src = doc;
+            aethermark::TokenList tokens(std::pmr::new_delete_resource());
+            aethermark::ParseEnv env;
+            aethermark::StateCore state(src, md, env, tokens);
+            md.core_parser.Process(state);
+            bench::DoNotOptimize(tokens.size());
+          },
+          1);
+      Report("heap", doc, bench::AllocSince(before), ms);
+    }
+
+    // Arena: tokens are bump-allocated from the result's arena.
+    {
+      bench::AllocStats before = bench::AllocSnapshot();
+      double ms = bench::BestOfMs(
+          [&] {
+            aethermark::ParseResult result = md.Parse(doc, {});
+            bench::DoNotOptimize(result.size());
+          },
+          1);
+      Report("arena", doc, bench::AllocSince(before), ms);
+    }
+
+    // Context: the second parse reuses the memory of the first.
+    {
+      aethermark::ParseContext context;
+      md.Parse(doc, {}, context);
+
+      bench::AllocStats before = bench::AllocSnapshot();
+      double ms = bench::BestOfMs(
+          [&] {
+            aethermark::ParseResult& result = md.Parse(doc, {}, context);
+            bench::DoNotOptimize(result.size());
+          },
+          1);
+      Report("reused", doc, bench::AllocSince(before), ms);
+    }
+  }
+
+  return 0;
+}
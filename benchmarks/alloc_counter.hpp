@@ -0,0 +1,68 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Replaces the global allocation functions with counting versions. Include
+// from exactly one translation unit of a benchmark or test executable. Each
+// thread counts its own allocations, so other threads neither race on the
+// counters nor show up in them.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace aethermark::bench {
+
+/// @brief Snapshot of the allocation counters.
+struct AllocStats {
+  std::size_t count = 0;  ///< Number of calls to `operator new`.
+  std::size_t bytes = 0;  ///< Total bytes requested.
+};
+
+inline thread_local AllocStats g_alloc_stats;
+
+/// @brief Current allocation counters of the calling thread.
+inline AllocStats AllocSnapshot() { return g_alloc_stats; }
+
+/// @brief Allocations performed since `since`.
+inline AllocStats AllocSince(const AllocStats& since) {
+  return {g_alloc_stats.count - since.count, g_alloc_stats.bytes - since.bytes};
+}
+
+}  // namespace aethermark::bench
+
+void* operator new(std::size_t size) {
+  aethermark::bench::g_alloc_stats.count++;
+  aethermark::bench::g_alloc_stats.bytes += size;
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+// std::pmr::new_delete_resource() goes through the aligned overloads.
+void* operator new(std::size_t size, std::align_val_t align) {
+  aethermark::bench::g_alloc_stats.count++;
+  aethermark::bench::g_alloc_stats.bytes += size;
+  std::size_t a = static_cast<std::size_t>(align);
+  if (void* p = std::aligned_alloc(a, (size + a - 1) / a * a)) return p;
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+  return ::operator new(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+  std::free(p);
+}
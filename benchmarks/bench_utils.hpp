@@ -0,0 +1,57 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace aethermark::bench {
+
+/// @brief Keep the optimizer from discarding a computed value.
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// @brief Run `fn` repeatedly and report the best wall time of one run.
+/// @param fn Callable to measure.
+/// @param iterations Number of measured runs.
+/// @return Best run time in milliseconds.
+template <typename Fn>
+double BestOfMs(Fn&& fn, int iterations) {
+  double best = 0;
+  for (int i = 0; i < iterations; i++) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto stop = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    if (i == 0 || ms < best) best = ms;
+  }
+  return best;
+}
+
+/// @brief Throughput in MB/s for `bytes` processed in `ms` milliseconds.
+inline double MBps(std::size_t bytes, double ms) {
+  return ms <= 0 ? 0 : (bytes / (1024.0 * 1024.0)) / (ms / 1000.0);
+}
+
+/// @brief Build a mixed markdown document of at least `bytes` bytes, made of
+/// multi-line paragraphs, blockquotes and indented code blocks.
+inline std::string MakeDocument(std::size_t bytes) {
+  std::string doc;
+  doc.reserve(bytes + 256);
+  for (int i = 0; doc.size() < bytes; i++) {
+    doc += "Lorem ipsum dolor sit amet, consectetur adipiscing elit ";
+    doc += std::to_string(i);
+    doc += "\nsed do eiusmod tempor incididunt ut labore et dolore.\n\n";
+    doc += "> quoted line one\n> quoted line two\n\n";
+    doc += "    code line\n    more code\n\n";
+  }
+  return doc;
+}
+
+}  // namespace aethermark::bench
@@ -0,0 +1,48 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Emphasis matching on pathological inputs: single paragraphs made of a
+// delimiter pattern repeated N times. Time per repetition should stay flat
+// as N doubles; a quadratic matcher doubles it instead.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseContext context;
+
+  // Openers that never close, closers without openers, and mixed markers
+  // that defeat the rule of 3 and the per-marker bottoms.
+  const char* patterns[] = {"*a **a ", "a**b ", "**a ",   "a* ",
+                            "*_a ",    "_*a* ", "*a_*b_ ", "**_a*_ "};
+
+  for (const char* pattern : patterns) {
+    double first_ns = 0;
+    for (int n = 12500; n <= 100000; n *= 2) {
+      std::string src;
+      for (int i = 0; i < n; i++) src += pattern;
+
+      double ms = bench::BestOfMs(
+          [&] {
+            aethermark::ParseResult& result = md.Parse(src, {}, context);
+            bench::DoNotOptimize(result.size());
+          },
+          5);
+
+      const double ns_per_rep = ms * 1e6 / n;
+      if (n == 12500) first_ns = ns_per_rep;
+      std::printf("%-8s x%-7d %9.3f ms  %7.1f ns/rep  %5.2fx\n", pattern, n,
+                  ms, ns_per_rep, ns_per_rep / first_ns);
+    }
+  }
+
+  return 0;
+}
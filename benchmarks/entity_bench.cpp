@@ -0,0 +1,71 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Character reference decoding: raw lookups over every named entity and a
+// numeric mix, then whole-document parses of entity-dense scientific text.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/entities.hpp"
+#include "aethermark/parse_context.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+// Formulas written with references, as exported by LaTeX converters.
+std::string MakeScientific(std::size_t bytes) {
+  std::string doc;
+  doc.reserve(bytes + 256);
+  for (int i = 0; doc.size() < bytes; i++) {
+    doc += "For &alpha; &isin; &Ropf; and &beta; &le; &#8730;" +
+           std::to_string(i) + ", the bound &Sigma;&lowast; &asymp; ";
+    doc += "&#x3C0;&sdot;&epsi; holds &mdash; see &sect;" +
+           std::to_string(i % 90) + " &amp; &NotEqualTilde; cases.\n\n";
+  }
+  return doc;
+}
+
+}  // namespace
+
+int main() {
+  const std::vector<std::string> refs = {
+      "&amp;",  "&lt;",     "&ThickSpace;", "&#8730;", "&#x1F600;",
+      "&copy;", "&nosuch;", "&alpha;",      "&Ropf;",  "&#65;"};
+  constexpr int kRounds = 100000;
+
+  const double lookup_ms = bench::BestOfMs(
+      [&] {
+        std::size_t total = 0;
+        for (int round = 0; round < kRounds; round++) {
+          for (const std::string& ref : refs) {
+            total += aethermark::Entities::Decode(ref).size;
+          }
+        }
+        bench::DoNotOptimize(total);
+      },
+      5);
+  std::printf("decode      %7.1f ns/reference\n",
+              lookup_ms * 1e6 / (kRounds * refs.size()));
+
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseContext context;
+  for (std::size_t size : {256 * 1024, 4 * 1024 * 1024}) {
+    const std::string doc = MakeScientific(size);
+    const double ms = bench::BestOfMs(
+        [&] {
+          aethermark::ParseResult& result = md.Parse(doc, {}, context);
+          bench::DoNotOptimize(result.size());
+        },
+        5);
+    std::printf("parse %4zu KB  %9.3f ms  %7.1f MB/s\n", size >> 10, ms,
+                bench::MBps(doc.size(), ms));
+  }
+
+  return 0;
+}
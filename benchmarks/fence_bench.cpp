@@ -0,0 +1,119 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Fenced code block throughput: documents made of a few large fences of log
+// output, against a per-line scan for the closing fence as markdown-it does.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/rules_block/rules_block.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+#include "aethermark/token_list.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+// Fences of `lines` log lines each, with stray markers inside the lines
+std::string MakeFences(std::size_t bytes, int lines) {
+  std::string doc;
+  doc.reserve(bytes + 256);
+  while (doc.size() < bytes) {
+    doc += "Build output:\n\n```text\n";
+    for (int i = 0; i < lines; i++) {
+      doc += "2025-01-01T00:00:";
+      doc += std::to_string(i % 60);
+      doc += " INFO worker ";
+      doc += std::to_string(i);
+      doc += i % 16 == 0 ? " ran `make check` in ~/src\n"
+                         : " processed batch, 0 errors\n";
+    }
+    doc += "```\n\n";
+  }
+  return doc;
+}
+
+// The closing fence search looking at the first character of every line
+int ScanPerLine(const aethermark::StateBlock& state, int start_line) {
+  int next_line = start_line;
+  for (;;) {
+    next_line++;
+    if (next_line >= state.line_max) return next_line;
+    const aethermark::LineInfo& info = state.lines[next_line];
+    if (info.First() < info.e_mark && info.s_count < state.blk_indent) {
+      return next_line;
+    }
+    if (state.src[info.First()] != '`') continue;
+    if (info.s_count - state.blk_indent >= 4) continue;
+    if (state.SkipChars(info.First(), '`') - info.First() < 3) continue;
+    if (state.SkipSpaces(state.SkipChars(info.First(), '`')) < info.e_mark) {
+      continue;
+    }
+    return next_line;
+  }
+}
+
+}  // namespace
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseEnv env;
+
+  for (int lines : {100, 10000}) {
+    for (std::size_t size : {256 * 1024, 16 * 1024 * 1024}) {
+      const std::string doc = MakeFences(size, lines);
+      const int iterations = size < 1024 * 1024 ? 200 : 10;
+
+      double parse_ms = bench::BestOfMs(
+          [&] {
+            aethermark::ParseResult result = md.Parse(doc, {});
+            bench::DoNotOptimize(result.size());
+          },
+          iterations);
+
+      aethermark::TokenList tokens;
+      aethermark::StateBlock state(doc, md, env, tokens);
+      std::vector<int> starts;
+      for (int line = 0; line < state.line_max; line++) {
+        if (doc.compare(state.lines[line].b_mark, 7, "```text") == 0) {
+          starts.push_back(line);
+        }
+      }
+
+      // The fence rule alone, from each opening fence
+      double rule_ms = bench::BestOfMs(
+          [&] {
+            tokens.clear();
+            for (int line : starts) {
+              aethermark::BlockRules::RuleFence(state, line, state.line_max,
+                                                false);
+            }
+            bench::DoNotOptimize(state.line);
+          },
+          iterations);
+
+      double scan_ms = bench::BestOfMs(
+          [&] {
+            int end = 0;
+            for (int line : starts) end += ScanPerLine(state, line);
+            bench::DoNotOptimize(end);
+          },
+          iterations);
+
+      std::printf(
+          "%5d-line fences %8zu KB  parse %7.1f MB/s  rule %8.1f MB/s  "
+          "per-line scan %8.1f MB/s\n",
+          lines, doc.size() / 1024, bench::MBps(doc.size(), parse_ms),
+          bench::MBps(doc.size(), rule_ms), bench::MBps(doc.size(), scan_ms));
+    }
+  }
+
+  return 0;
+}
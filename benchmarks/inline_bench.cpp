@@ -0,0 +1,83 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Inline parsing throughput: the text scanner alone, then whole parses of
+// prose, markup-dense inline content and a mixed document.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/rules_inline/rules_inline.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+// One paragraph per line pair, plain words only.
+std::string MakeProse(std::size_t bytes) {
+  std::string doc;
+  doc.reserve(bytes + 256);
+  while (doc.size() < bytes) {
+    doc += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do ";
+    doc += "eiusmod tempor incididunt ut labore et dolore magna aliqua.\n";
+    doc += "Ut enim ad minim veniam, quis nostrud exercitation ullamco.\n\n";
+  }
+  return doc;
+}
+
+// Paragraphs with code spans, escapes, autolinks, inline HTML and breaks.
+std::string MakeMarkup(std::size_t bytes) {
+  std::string doc;
+  doc.reserve(bytes + 256);
+  while (doc.size() < bytes) {
+    doc += "Call `parse()` on <https://example.com/docs> \\*now\\*  \n";
+    doc += "or mail <team@example.com> with <b>bold</b> & ``a ` b`` text.\n\n";
+  }
+  return doc;
+}
+
+void RunParse(const char* name, const std::string& doc) {
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseContext context;
+  const int iterations = doc.size() < 1024 * 1024 ? 200 : 20;
+
+  double ms = bench::BestOfMs(
+      [&] {
+        aethermark::ParseResult& result = md.Parse(doc, {}, context);
+        bench::DoNotOptimize(result.size());
+      },
+      iterations);
+  std::printf("%-7s %8zu KB  %8.3f ms  %8.1f MB/s\n", name, doc.size() / 1024,
+              ms, bench::MBps(doc.size(), ms));
+}
+
+}  // namespace
+
+int main() {
+  for (std::size_t size : {256 * 1024, 4 * 1024 * 1024}) {
+    const std::string prose = MakeProse(size);
+
+    // Text runs found by the scanner, without tokens
+    double ms = bench::BestOfMs(
+        [&] {
+          std::size_t runs = 0;
+          for (std::size_t pos = 0; pos < prose.size(); pos++, runs++) {
+            pos = aethermark::InlineRules::SkipText(prose, pos);
+          }
+          bench::DoNotOptimize(runs);
+        },
+        size < 1024 * 1024 ? 200 : 20);
+    std::printf("%-7s %8zu KB  %8.3f ms  %8.1f MB/s\n", "scan",
+                prose.size() / 1024, ms, bench::MBps(prose.size(), ms));
+
+    RunParse("prose", prose);
+    RunParse("markup", MakeMarkup(size));
+    RunParse("mixed", bench::MakeDocument(size));
+  }
+
+  return 0;
+}
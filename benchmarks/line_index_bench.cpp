@@ -0,0 +1,40 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Line indexing throughput: the `StateBlock` constructor computing the line
+// metadata of a document, without running any block rule.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+#include "aethermark/token_list.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseEnv env;
+
+  for (std::size_t size : {16 * 1024, 256 * 1024, 4 * 1024 * 1024,
+                           32 * 1024 * 1024}) {
+    const std::string doc = bench::MakeDocument(size);
+    const int iterations = size < 1024 * 1024 ? 200 : 10;
+
+    double ms = bench::BestOfMs(
+        [&] {
+          aethermark::TokenList tokens;
+          aethermark::StateBlock state(doc, md, env, tokens);
+          bench::DoNotOptimize(state.line_max);
+        },
+        iterations);
+    std::printf("%8zu KB  %8.3f ms  %8.1f MB/s\n", doc.size() / 1024, ms,
+                bench::MBps(doc.size(), ms));
+  }
+
+  return 0;
+}
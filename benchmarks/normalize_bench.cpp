@@ -0,0 +1,69 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Input normalization throughput: the normalize core rule on documents with
+// LF, CRLF and NUL-bearing line endings.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/rules_core/rules_core.hpp"
+#include "aethermark/rules_core/state_core.hpp"
+#include "aethermark/token_list.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+// `doc` with every LF replaced by `ending`.
+std::string WithLineEndings(const std::string& doc, const std::string& ending) {
+  std::string out;
+  out.reserve(doc.size() * ending.size());
+  for (char c : doc) {
+    if (c == '\n') {
+      out += ending;
+    } else {
+      out += c;
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+  aethermark::ParseEnv env;
+
+  const char* kinds[] = {"lf", "crlf", "nul"};
+  const std::string endings[] = {"\n", "\r\n", std::string("\0\n", 2)};
+
+  for (std::size_t size : {16 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+    const std::string doc = bench::MakeDocument(size);
+    const int iterations = size < 1024 * 1024 ? 200 : 20;
+
+    for (int k = 0; k < 3; k++) {
+      const std::string input = WithLineEndings(doc, endings[k]);
+      std::string src;
+
+      // the copy restoring the input is part of every iteration
+      double ms = bench::BestOfMs(
+          [&] {
+            src = input;
+            aethermark::TokenList tokens;
+            aethermark::StateCore state(src, md, env, tokens);
+            aethermark::CoreRules::RuleNormalize(state);
+            bench::DoNotOptimize(src.size());
+          },
+          iterations);
+      std::printf("%-4s %8zu KB  %8.3f ms  %8.1f MB/s\n", kinds[k],
+                  input.size() / 1024, ms, bench::MBps(input.size(), ms));
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,106 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Link reference definitions: lookups by raw label (ASCII and not), and
+// documents with thousands of definitions and uses, parsed on their own and
+// against a precompiled shared glossary.
+
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_env.hpp"
+#include "alloc_counter.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+std::string Definitions(int count) {
+  std::string doc;
+  for (int i = 0; i < count; i++) {
+    doc += "[Symbol " + std::to_string(i) + "]: /api/symbol-" +
+           std::to_string(i) + " \"Symbol " + std::to_string(i) + "\"\n";
+  }
+  return doc + "\n";
+}
+
+std::string Uses(int count) {
+  std::string doc;
+  for (int i = 0; i < count; i++) {
+    doc += "Calls [symbol  " + std::to_string(i * 7 % count) +
+           "] and [the docs][SYMBOL " + std::to_string(i) + "].\n\n";
+  }
+  return doc;
+}
+
+}  // namespace
+
+int main() {
+  constexpr int kCount = 5000;
+  aethermark::Aethermark md("commonmark");
+
+  // Raw lookups
+  aethermark::ParseResult defs = md.Parse(Definitions(kCount), {});
+  const aethermark::ParseEnv& env = defs.Env();
+  std::vector<std::string> ascii;
+  std::vector<std::string> folded;
+  for (int i = 0; i < kCount; i++) {
+    ascii.push_back("SYMBOL   " + std::to_string(i));
+    folded.push_back("\xC5\xBF" "ymbol " + std::to_string(i));  // long s
+  }
+
+  for (const auto& [name, labels] :
+       {std::pair{"ascii", &ascii}, std::pair{"unicode", &folded}}) {
+    std::size_t found = 0;
+    const bench::AllocStats before = bench::AllocSnapshot();
+    const double ms = bench::BestOfMs(
+        [&] {
+          for (const std::string& label : *labels) {
+            found += env.FindReference(label) != nullptr;
+          }
+        },
+        5);
+    const bench::AllocStats allocs = bench::AllocSince(before);
+    bench::DoNotOptimize(found);
+    std::printf("lookup %-8s %7.1f ns/label  %5.2f allocs/label\n", name,
+                ms * 1e6 / kCount,
+                static_cast<double>(allocs.count) / (5.0 * kCount));
+  }
+
+  // Whole documents
+  aethermark::ParseContext context;
+  const std::string inline_doc = Definitions(kCount) + Uses(kCount);
+  const double inline_ms = bench::BestOfMs(
+      [&] {
+        aethermark::ParseResult& result = md.Parse(inline_doc, {}, context);
+        bench::DoNotOptimize(result.size());
+      },
+      5);
+  std::printf("parse with definitions   %9.3f ms  %7.1f MB/s\n", inline_ms,
+              bench::MBps(inline_doc.size(), inline_ms));
+
+  aethermark::ParseResult glossary = md.Parse(Definitions(kCount), {});
+  const std::shared_ptr<const aethermark::ReferenceMap> table =
+      glossary.Env().ShareReferences();
+  const std::string uses_doc = Uses(kCount);
+  const double shared_ms = bench::BestOfMs(
+      [&] {
+        aethermark::ParseEnv shared;
+        shared.shared_references = table;
+        aethermark::ParseResult& result =
+            md.Parse(uses_doc, std::move(shared), context);
+        bench::DoNotOptimize(result.size());
+      },
+      5);
+  std::printf("parse with shared table  %9.3f ms  %7.1f MB/s\n", shared_ms,
+              bench::MBps(uses_doc.size(), shared_ms));
+
+  return 0;
+}
@@ -0,0 +1,49 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// Parse throughput of the runtime-configured `Aethermark` against
+// `StaticAethermark`, which binds the "commonmark" rules at compile time.
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/static_aethermark.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+static void Report(const char* mode, const std::string& doc, double ms) {
+  std::printf("%-7s %8zu KB  %8.2f ms  %8.1f MB/s\n", mode, doc.size() / 1024,
+              ms, bench::MBps(doc.size(), ms));
+}
+
+int main() {
+  aethermark::Aethermark dynamic("commonmark");
+  aethermark::StaticAethermark<aethermark::PresetId::kCommonmark> fixed;
+
+  for (std::size_t size : {16 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+    const std::string doc = bench::MakeDocument(size);
+    const int iterations = size < 1024 * 1024 ? 50 : 5;
+
+    double ms = bench::BestOfMs(
+        [&] {
+          aethermark::ParseResult result = dynamic.Parse(doc, {});
+          bench::DoNotOptimize(result.size());
+        },
+        iterations);
+    Report("dynamic", doc, ms);
+
+    ms = bench::BestOfMs(
+        [&] {
+          aethermark::ParseResult result = fixed.Parse(doc, {});
+          bench::DoNotOptimize(result.size());
+        },
+        iterations);
+    Report("static", doc, ms);
+  }
+
+  return 0;
+}
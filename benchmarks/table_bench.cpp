@@ -0,0 +1,126 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+// GFM table throughput and memory on a data export: 100k rows of 30 columns
+// with cells of about 33 bytes, 100 MB in all. Reports the block stage and a
+// full parse, with the bytes allocated, the bytes of the token array and the
+// peak resident memory, per cell.
+
+#include <sys/resource.h>
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+#include "alloc_counter.hpp"
+#include "bench_utils.hpp"
+
+namespace bench = aethermark::bench;
+
+namespace {
+
+constexpr int kRows = 100000;
+constexpr int kColumns = 30;
+constexpr std::size_t kCellBytes = 33;
+
+// A table of `rows` rows of `columns` cells of `width` bytes, pipe and
+// padding included, some of them holding escaped pipes and inline markup.
+std::string MakeTable(int rows, int columns, std::size_t width) {
+  std::string doc;
+  doc.reserve((rows + 2) * (columns * width + 2));
+  for (int c = 0; c < columns; c++) doc += c == 0 ? "| col" : " | col";
+  doc += " |\n";
+  for (int c = 0; c < columns; c++) doc += c % 3 == 0 ? "|:--" : "|---";
+  doc += "|\n";
+
+  for (int row = 0; row < rows; row++) {
+    for (int c = 0; c < columns; c++) {
+      const std::size_t start = doc.size();
+      doc += "| ";
+      doc += std::to_string(row);
+      doc += c % 10 == 0 ? " a \\| b " : c % 10 == 1 ? " *em* " : " ";
+      while (doc.size() - start + 1 < width) doc += 'x';
+      doc += ' ';
+    }
+    doc += "|\n";
+  }
+  return doc;
+}
+
+// Peak resident set size of the process so far.
+std::size_t PeakRssBytes() {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
+
+void Report(const char* mode, std::size_t bytes, std::size_t cells,
+            const bench::AllocStats& stats, std::size_t token_bytes,
+            std::size_t rss, double ms) {
+  std::printf(
+      "%-6s %6zu MB  %8zu cells  %7.1f MB/s  %5.2f allocs/cell  "
+      "%5.0f B/cell allocated  %5.0f B/cell tokens  %5.0f B/cell peak RSS\n",
+      mode, bytes >> 20, cells, bench::MBps(bytes, ms),
+      static_cast<double>(stats.count) / cells,
+      static_cast<double>(stats.bytes) / cells,
+      static_cast<double>(token_bytes) / cells,
+      static_cast<double>(rss) / cells);
+}
+
+}  // namespace
+
+int main() {
+  aethermark::Aethermark md("commonmark");
+  md.Enable({"table"});
+
+  const std::string doc = MakeTable(kRows, kColumns, kCellBytes);
+  const std::size_t cells = static_cast<std::size_t>(kRows) * kColumns;
+  std::printf("sizeof(Token) = %zu\n", sizeof(aethermark::Token));
+
+  // Resident memory past the document, grown by the larger run last
+  const std::size_t baseline = PeakRssBytes();
+
+  // Block stage: table, row and cell tokens, without inline parsing
+  {
+    bench::AllocStats stats;
+    std::size_t token_bytes = 0;
+    double ms = bench::BestOfMs(
+        [&] {
+          aethermark::ParseEnv env;
+          aethermark::TokenList tokens;
+          bench::AllocStats before = bench::AllocSnapshot();
+          md.block_parser.Parse(doc, md, env, tokens);
+          stats = bench::AllocSince(before);
+          token_bytes = tokens.capacity() * sizeof(aethermark::Token);
+          bench::DoNotOptimize(tokens.size());
+        },
+        3);
+    Report("block", doc.size(), cells, stats, token_bytes,
+           PeakRssBytes() - baseline, ms);
+  }
+
+  // Full parse
+  {
+    bench::AllocStats stats;
+    std::size_t token_bytes = 0;
+    double ms = bench::BestOfMs(
+        [&] {
+          bench::AllocStats before = bench::AllocSnapshot();
+          aethermark::ParseResult result = md.Parse(doc, {});
+          stats = bench::AllocSince(before);
+          token_bytes =
+              result.Tokens().capacity() * sizeof(aethermark::Token);
+          bench::DoNotOptimize(result.size());
+        },
+        3);
+    Report("parse", doc.size(), cells, stats, token_bytes,
+           PeakRssBytes() - baseline, ms);
+  }
+
+  return 0;
+}
@@ -3,16 +3,20 @@
 
 #pragma once
 
-#include <deque>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
 #include "aethermark/parser_block.hpp"
 #include "aethermark/parser_core.hpp"
-// #include "aethermark/parser_inline.hpp"
+#include "aethermark/parser_inline.hpp"
 // #include "aethermark/renderer.hpp"
 #include "aethermark/ruler.hpp"
 #include "aethermark/token.hpp"
@@ -80,11 +84,32 @@ struct Preset {
   ComponentConfig components;  ///< Component configuration.
 };
 
+/// @brief Rule chains of every ruler of an `Aethermark`, published together
+/// as one immutable configuration. See `Aethermark::Rules`.
+struct ParserRules {
+  RuleSnapshot<RuleCore> core_rules;        ///< Core rule chains.
+  RuleSnapshot<RuleBlock> block_rules;      ///< Block rule chains.
+  RuleSnapshot<RuleInline> inline_rules;    ///< Inline rule chains.
+  RuleSnapshot<RuleInline2> inline_rules2;  ///< Inline post-processing chains.
+};
+
 /// @brief Main entry for Aethermark.
+///
+/// Concurrency: a configured instance can be shared by any number of threads
+/// calling `Parse` and `ParseInline`. Each parse keeps its state in its own
+/// `StateCore`/`StateBlock` and reads the rule chains of all stages from one
+/// `ParserRules` taken when it starts, the only step that locks. `Enable`,
+/// `Disable`, `Configure` and `Use` publish a single new `ParserRules` by
+/// swapping one pointer once all of their ruler changes are made: parses
+/// already running finish with the rules they started with, and no parse
+/// sees part of a change. A change made directly on one ruler publishes on
+/// its own. Configuration calls must not run concurrently with each other,
+/// and `options` (including `Set`) must not be written while parses are
+/// running.
 class Aethermark {
  public:
   /// @brief Main instance of inline parser.
-  // ParserInline inline_parser;
+  ParserInline inline_parser;
 
   /// @brief Main instance of block parser.
   ParserBlock block_parser;
@@ -107,6 +132,10 @@ class Aethermark {
   explicit Aethermark(std::string preset_name,
                       std::optional<Options> options = std::nullopt);
 
+  // the rulers notify this instance of their changes
+  Aethermark(const Aethermark&) = delete;
+  Aethermark& operator=(const Aethermark&) = delete;
+
   // configure options on existing instance
   Aethermark& Set(const Options& opts);
 
@@ -114,19 +143,63 @@ class Aethermark {
   Aethermark& Configure(const std::string& preset_name);
   Aethermark& Configure(const Preset& preset);
 
-  // enable/disable rules: dispatch into block/core/inline
+  /// @brief Enable rules by name in every ruler that has them.
+  /// @param list Names of the rules.
+  /// @param ignore_invalid set `true` to ignore names no ruler knows.
+  /// @exception `std::runtime_error` if a name is unknown and
+  /// `ignore_invalid` is `false`; no rule is changed then.
   Aethermark& Enable(const std::vector<std::string>& list,
                      bool ignore_invalid = false);
+  /// @brief Disable rules by name in every ruler that has them.
+  /// @param list Names of the rules.
+  /// @param ignore_invalid set `true` to ignore names no ruler knows.
+  /// @exception `std::runtime_error` if a name is unknown and
+  /// `ignore_invalid` is `false`; no rule is changed then.
   Aethermark& Disable(const std::vector<std::string>& list,
                       bool ignore_invalid = false);
 
-  // parse
-  std::deque<Token> Parse(const std::string& src, std::any env);
-  std::deque<Token> ParseInline(const std::string& src, std::any env);
+  // parse: tokens live in the arena owned by the returned result, and the env
+  // is moved into it; rules share it by reference.
+  ParseResult Parse(const std::string& src, ParseEnv env);
+  ParseResult ParseInline(const std::string& src, ParseEnv env);
+
+  /// @brief Parse a document into a caller-owned result, replacing its
+  /// tokens. The source buffer keeps its capacity, and a result built over a
+  /// `BlockCache` also gets its arena blocks back on the next parse.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param out Result to fill.
+  void Parse(const std::string& src, ParseEnv env,
+             ParseResult& out);  // NOLINT(runtime/references)
+
+  /// @brief Parse a single inline string into a caller-owned result,
+  /// replacing its tokens.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param out Result to fill.
+  void ParseInline(const std::string& src, ParseEnv env,
+                   ParseResult& out);  // NOLINT(runtime/references)
+
+  /// @brief Parse a document reusing the memory of a context.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param context Context of the calling thread.
+  /// @return The result held by `context`, valid until its next parse.
+  ParseResult& Parse(const std::string& src, ParseEnv env,
+                     ParseContext& context);  // NOLINT(runtime/references)
+
+  /// @brief Parse a single inline string reusing the memory of a context.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param context Context of the calling thread.
+  /// @return The result held by `context`, valid until its next parse.
+  ParseResult& ParseInline(
+      const std::string& src, ParseEnv env,
+      ParseContext& context);  // NOLINT(runtime/references)
 
   // render
-  std::string Render(const std::string& src, std::any env = nullptr);
-  std::string RenderInline(const std::string& src, std::any env = nullptr);
+  std::string Render(const std::string& src, ParseEnv env = {});
+  std::string RenderInline(const std::string& src, ParseEnv env = {});
 
   // link handling (placeholder for now)
   bool ValidateLink(const std::string& url) const;
@@ -135,6 +208,35 @@ class Aethermark {
 
   // plugins
   Aethermark& Use(std::function<void(Aethermark&)> plugin);
+
+  /// @brief Get the current rule configuration. Safe to call while another
+  /// thread reconfigures the parser.
+  /// @return The configuration, alive while the handle is held.
+  std::shared_ptr<const ParserRules> Rules() const {
+    std::lock_guard<std::mutex> lock(rules_mutex_);
+    return rules_;
+  }
+
+ private:
+  class RuleBatch;
+
+  /// @brief Published configuration, shared with the parses holding it.
+  std::shared_ptr<const ParserRules> rules_;
+
+  /// @brief Guards `rules_` itself. Parses copy the pointer once when they
+  /// start, so this is never held while rules run.
+  mutable std::mutex rules_mutex_;
+
+  /// @brief Number of open `RuleBatch`es. Ruler changes made meanwhile are
+  /// published together when the last one closes.
+  int rule_batches_ = 0;
+
+  /// @brief Republish the configuration when a ruler changes.
+  void WatchRulers();
+
+  /// @brief Publish the current snapshots of all the rulers as one
+  /// configuration.
+  void PublishRules();
 };
 
 }  // namespace aethermark
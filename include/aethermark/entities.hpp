@@ -0,0 +1,65 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace aethermark {
+
+/// @brief HTML5 character reference decoding.
+///
+/// Named references are looked up in a generated `constexpr` minimal perfect
+/// hash table (see `scripts/gen_entities.py`), so nothing is built or
+/// allocated at startup and a lookup is two hashes and one compare.
+class Entities {
+ public:
+  Entities() = delete;
+
+  /// @brief Most UTF-8 bytes a character reference decodes to.
+  static constexpr std::size_t kMaxDecodedSize = 6;
+
+  /// @brief A character reference matched at the start of a string.
+  struct Match {
+    /// @brief Length of the reference, `&` and `;` included; 0 if none.
+    std::size_t length = 0;
+    /// @brief Decoded text, UTF-8.
+    char text[kMaxDecodedSize] = {};
+    /// @brief Number of bytes used in `text`.
+    std::size_t size = 0;
+
+    /// @brief Whether a reference was matched.
+    explicit operator bool() const { return length != 0; }
+
+    /// @brief View of the decoded text, valid as long as the match.
+    std::string_view Text() const { return {text, size}; }
+  };
+
+  /// @brief Look up a named reference.
+  /// @param name Name without the leading `&` and the trailing `;`.
+  /// @return Decoded UTF-8 text in static storage, empty if the name is
+  /// unknown.
+  static std::string_view Named(std::string_view name);
+
+  /// @brief Whether a numeric reference may decode to a code point, as
+  /// markdown-it's `isValidEntityCode`. Surrogates, noncharacters and most
+  /// control characters may not.
+  /// @param code The code point.
+  static bool IsValidCode(char32_t code);
+
+  /// @brief Encode a code point as UTF-8.
+  /// @param code The code point, at most `0x10FFFF`.
+  /// @param out Buffer of at least 4 bytes.
+  /// @return Number of bytes written.
+  static std::size_t EncodeUtf8(char32_t code, char* out);
+
+  /// @brief Match a character reference at the start of a string: `&#123;`,
+  /// `&#x1F;` or `&name;`. Numeric references to invalid code points decode
+  /// to U+FFFD.
+  /// @param s The given string.
+  /// @return The match, empty if `s` does not start with a reference.
+  static Match Decode(std::string_view s);
+};
+
+}  // namespace aethermark
@@ -0,0 +1,67 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "aethermark/rules_inline/state_inline.hpp"
+
+namespace aethermark {
+
+/// @brief Result of `LinkHelpers::ParseLinkDestination`.
+struct LinkDestination {
+  bool ok = false;      ///< Whether a destination was found.
+  std::size_t pos = 0;  ///< Position after the destination.
+  std::string str;      ///< The destination, unescaped.
+};
+
+/// @brief Result of `LinkHelpers::ParseLinkTitle`.
+struct LinkTitle {
+  bool ok = false;            ///< Whether a complete title was found.
+  bool can_continue = false;  ///< Whether the title may go on past `max`.
+  std::size_t pos = 0;        ///< Position after the closing marker.
+  std::string str;            ///< The title so far, unescaped.
+  char marker = 0;            ///< Closing marker.
+};
+
+/// @brief Parsers for the parts of links shared by the block and inline
+/// rules, as markdown-it's `helpers`.
+class LinkHelpers {
+ public:
+  LinkHelpers() = delete;
+
+  /// @brief Find the end of a link label, skipping over the inline tokens
+  /// inside it so that e.g. a `]` in a code span does not close it.
+  /// @param state Inline state; its position is restored.
+  /// @param start Position of the opening `[`.
+  /// @param disable_nested Fail on a nested link.
+  /// @return Position of the closing `]`, `std::string_view::npos` if there
+  /// is none.
+  static std::size_t ParseLinkLabel(
+      StateInline& state,  // NOLINT(runtime/references)
+      std::size_t start, bool disable_nested = false);
+
+  /// @brief Parse a link destination, `<...>` or a run without spaces and
+  /// with balanced parentheses.
+  /// @param str The given string.
+  /// @param start Position of the destination.
+  /// @param max End of the string to consider.
+  static LinkDestination ParseLinkDestination(std::string_view str,
+                                              std::size_t start,
+                                              std::size_t max);
+
+  /// @brief Parse a link title in `"..."`, `'...'` or `(...)`.
+  /// @param str The given string.
+  /// @param start Position of the opening marker, or of the continuation.
+  /// @param max End of the string to consider.
+  /// @param prev Result of the call on the previous line, to continue a
+  /// title spanning lines; null to start a new one.
+  static LinkTitle ParseLinkTitle(std::string_view str, std::size_t start,
+                                  std::size_t max,
+                                  const LinkTitle* prev = nullptr);
+};
+
+}  // namespace aethermark
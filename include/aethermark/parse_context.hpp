@@ -0,0 +1,109 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+#include "aethermark/parse_result.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+
+namespace aethermark {
+
+/// @brief Memory resource keeping the blocks returned to it for the next
+/// request of the same size class.
+///
+/// Requests are rounded up to a power of two, so blocks of nearby sizes are
+/// interchangeable. An arena released and refilled on every parse asks for
+/// the same sequence of block sizes each time, so after the first parse
+/// every request is served from the cache, and the cache never holds more
+/// than the largest arena it served. At most `kMaxCachedBlocks` blocks are
+/// kept; further ones go straight back upstream. Not thread-safe.
+class BlockCache : public std::pmr::memory_resource {
+ public:
+  /// @brief Constructs an empty cache.
+  /// @param upstream Resource blocks are obtained from on a miss.
+  explicit BlockCache(
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+  BlockCache(const BlockCache&) = delete;
+  BlockCache& operator=(const BlockCache&) = delete;
+  ~BlockCache() override;
+
+  /// @brief Maximum number of blocks kept for reuse.
+  static constexpr std::size_t kMaxCachedBlocks = 64;
+
+  /// @brief Return every cached block to the upstream resource. Blocks in use
+  /// are not affected.
+  void Release();
+
+  /// @brief Total size of the cached blocks.
+  std::size_t CachedBytes() const;
+
+ private:
+  struct Block {
+    void* p;
+    std::size_t bytes;
+    std::size_t alignment;
+  };
+
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override;
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::memory_resource* upstream_;
+  std::vector<Block> free_;
+};
+
+/// @brief Memory reused by consecutive parses on one thread.
+///
+/// Pass the same context to `Aethermark::Parse` for a batch of documents:
+/// the result, its arena blocks, its source buffer and the line metadata
+/// arrays of the block stage are recycled, so once the context has seen a
+/// document of similar size parsing does almost no allocation. A context must
+/// not be used by two parses at the same time; use one per thread.
+class ParseContext {
+ public:
+  ParseContext();
+
+  ParseContext(const ParseContext&) = delete;
+  ParseContext& operator=(const ParseContext&) = delete;
+
+  /// @brief Result of the last parse made with the context.
+  ParseResult& Result() { return result_; }
+
+  /// @brief Result of the last parse made with the context (const version).
+  const ParseResult& Result() const { return result_; }
+
+  /// @brief Empty the result for a new parse, keeping its memory. Tokens of
+  /// the previous parse become invalid.
+  /// @return The emptied result.
+  ParseResult& Reset();
+
+  /// @brief Free all memory kept for later parses, including the result.
+  void Trim();
+
+ private:
+  friend class StateBlock;
+
+  BlockCache blocks_;  ///< Declared before `result_`, destroyed after it.
+
+  /// @brief Result whose arena draws on `blocks_`. Its token array bypasses
+  /// the cache: the array keeps its capacity across parses, and the smaller
+  /// ones it outgrows while growing are never asked for again.
+  ParseResult result_;
+
+  /// @brief Line metadata array lent to the `StateBlock` of a parse.
+  std::vector<LineInfo> lines_;
+
+  /// @brief Line undo log lent to the `StateBlock` of a parse.
+  std::vector<SavedLine> line_undo_;
+};
+
+}  // namespace aethermark
@@ -0,0 +1,187 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace aethermark {
+
+/// @brief Hash for string keys that also accepts `std::string_view`, so
+/// lookups by a slice of the source do not build a `std::string`.
+struct StringHash {
+  using is_transparent = void;
+
+  std::size_t operator()(std::string_view s) const noexcept {
+    return std::hash<std::string_view>{}(s);
+  }
+};
+
+/// @brief Hash map keyed by strings, searchable by `std::string_view`.
+template <typename V>
+using StringMap =
+    std::unordered_map<std::string, V, StringHash, std::equal_to<>>;
+
+/// @brief Target of a link reference definition, `[label]: href "title"`.
+struct LinkReference {
+  std::string href;
+  std::string title;
+};
+
+/// @brief Hash of link labels as normalized by `Utils::NormalizeReference`,
+/// computed on the fly for ASCII labels.
+///
+/// Outer whitespace is skipped, inner runs count as one space and ASCII
+/// letters as lowercase, so the hash of a raw ASCII label equals the one of
+/// its normalized form. Other bytes are hashed as they are: keys and labels
+/// with non-ASCII characters must be normalized first.
+struct LabelHash {
+  using is_transparent = void;
+
+  // Not noexcept: libstdc++ then keeps the hash in each node, so a lookup
+  // never rehashes stored keys and compares labels only on a hash match.
+  std::size_t operator()(std::string_view label) const;
+};
+
+/// @brief Equality of link labels matching `LabelHash`.
+struct LabelEqual {
+  using is_transparent = void;
+
+  bool operator()(std::string_view a, std::string_view b) const;
+};
+
+/// @brief Link reference definitions by normalized label.
+using ReferenceMap =
+    std::unordered_map<std::string, LinkReference, LabelHash, LabelEqual>;
+
+/// @brief A footnote referenced from the document.
+struct Footnote {
+  std::string label;  ///< Label as written, empty for inline footnotes.
+  int count = 0;      ///< Number of references to the footnote so far.
+};
+
+/// @brief Footnotes of a document, in order of first reference.
+struct FootnoteTable {
+  StringMap<int> refs;         ///< Index into `list` by label.
+  std::vector<Footnote> list;  ///< Footnotes in order of first reference.
+};
+
+class ParseEnv;
+
+/// @brief Key of a plugin slot in `ParseEnv`.
+///
+/// Declare one per plugin, typically as a static, and use it to reach the
+/// plugin's state during a parse:
+/// @code
+/// static const EnvSlot<MyState> kSlot;
+/// MyState& s = state.env.Get(kSlot);
+/// @endcode
+/// @tparam T Type of the slot value, default-constructed on first use.
+template <typename T>
+class EnvSlot {
+ public:
+  EnvSlot();
+
+  /// @brief Index of the slot in every environment.
+  std::size_t id() const { return id_; }
+
+ private:
+  std::size_t id_;
+};
+
+/// @brief Per-document data shared by the rules of a parse: reference
+/// definitions, footnotes, heading slugs and plugin state.
+///
+/// Rules reach it by reference through `StateCore::env` and
+/// `StateBlock::env`. Tables are typed and hashed, so a lookup during inline
+/// parsing costs one hash of the key and no cast.
+class ParseEnv {
+ public:
+  ParseEnv() = default;
+  ParseEnv(ParseEnv&&) noexcept = default;
+  ParseEnv& operator=(ParseEnv&&) noexcept = default;
+  ParseEnv(const ParseEnv&) = delete;
+  ParseEnv& operator=(const ParseEnv&) = delete;
+  ~ParseEnv() = default;
+
+  /// @brief Link reference definitions of the document, by normalized
+  /// label. The first definition of a label wins.
+  ReferenceMap references;
+
+  /// @brief Definitions compiled once and shared by many documents, e.g. a
+  /// site-wide glossary. The document's own definitions take precedence.
+  std::shared_ptr<const ReferenceMap> shared_references;
+
+  /// @brief Footnotes of the document.
+  FootnoteTable footnotes;
+
+  /// @brief Number of headings using each slug so far.
+  StringMap<int> slugs;
+
+  /// @brief Whether any link reference definition can be found.
+  bool HasReferences() const {
+    return !references.empty() ||
+           (shared_references && !shared_references->empty());
+  }
+
+  /// @brief Find a link reference definition, in the document first and then
+  /// in the shared table. ASCII labels are matched without allocating.
+  /// @param label Label as written, without brackets.
+  /// @return The definition, `nullptr` if there is none.
+  const LinkReference* FindReference(std::string_view label) const;
+
+  /// @brief Add a link reference definition unless the label is defined
+  /// already.
+  /// @param label Label as written, without brackets.
+  /// @param reference Target of the label.
+  /// @return Whether the definition was added.
+  bool AddReference(std::string_view label, LinkReference reference);
+
+  /// @brief Move the document's definitions into a table other documents
+  /// can share through `shared_references`.
+  /// @return The table, immutable from now on.
+  std::shared_ptr<const ReferenceMap> ShareReferences();
+
+  /// @brief Reserve a slug for a heading, suffixing it with `-1`, `-2`, ...
+  /// when it is already used.
+  /// @param slug Slug derived from the heading text.
+  /// @return The slug to use.
+  std::string UniqueSlug(std::string_view slug);
+
+  /// @brief Value of a plugin slot, default-constructed on first use.
+  /// @param slot Key of the slot.
+  template <typename T>
+  T& Get(const EnvSlot<T>& slot);
+
+  /// @brief Empty every table and slot, keeping the table buckets.
+  void Clear();
+
+  /// @brief Allocate the index of a new plugin slot. Thread-safe.
+  static std::size_t RegisterSlot();
+
+ private:
+  /// @brief Plugin slot values by slot index; the type is fixed by the
+  /// `EnvSlot` that created each one.
+  std::vector<std::shared_ptr<void>> slots_;
+};
+
+template <typename T>
+EnvSlot<T>::EnvSlot() : id_(ParseEnv::RegisterSlot()) {}
+
+template <typename T>
+T& ParseEnv::Get(const EnvSlot<T>& slot) {
+  if (slot.id() >= slots_.size()) slots_.resize(slot.id() + 1);
+
+  std::shared_ptr<void>& value = slots_[slot.id()];
+  if (!value) value = std::make_shared<T>();
+  return *static_cast<T*>(value.get());
+}
+
+}  // namespace aethermark
@@ -0,0 +1,105 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string>
+
+#include "aethermark/parse_env.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace aethermark {
+
+/// @brief Token stream produced by a parse, together with the arena and the
+/// source buffer backing it.
+///
+/// Every string and attribute list owned by a token is bump-allocated from a
+/// `std::pmr::monotonic_buffer_resource` owned by the result; inline children
+/// share the flat `TokenList` with block tokens. The token array itself comes
+/// from the upstream resource, or a separate buffer resource, so growing it
+/// frees the old array instead of stranding it in the arena. A parse therefore costs a few large upstream
+/// allocations instead of several per token, and the whole stream is released
+/// in one shot when the result is destroyed. Token text that is a slice of
+/// the normalized source borrows from `Source()`. Tokens must not outlive
+/// their result. The environment the rules filled, e.g. reference
+/// definitions, travels with the tokens in `Env()`.
+class ParseResult {
+ public:
+  /// @brief Constructs an empty result.
+  /// @param size_hint Expected source size in bytes, used to size the first
+  /// arena block.
+  /// @param upstream Resource the arena obtains its blocks from.
+  /// @param buffer Resource of the token array and its bookkeeping, or
+  /// `nullptr` for `upstream`.
+  explicit ParseResult(
+      std::size_t size_hint = 0,
+      std::pmr::memory_resource* upstream = std::pmr::get_default_resource(),
+      std::pmr::memory_resource* buffer = nullptr);
+
+  ParseResult(ParseResult&&) noexcept = default;
+  ParseResult& operator=(ParseResult&&) noexcept = default;
+  ParseResult(const ParseResult&) = delete;
+  ParseResult& operator=(const ParseResult&) = delete;
+  ~ParseResult() = default;
+
+  /// @brief Remove all tokens and clear the source and the environment,
+  /// giving the arena memory back to the upstream resource. The source and
+  /// the token array keep their capacity.
+  void Reset();
+
+  /// @brief Token stream of the result.
+  TokenList& Tokens() { return storage_->tokens; }
+
+  /// @brief Token stream of the result (const version).
+  const TokenList& Tokens() const { return storage_->tokens; }
+
+  /// @brief Normalized source the tokens may refer to.
+  std::string& Source() { return storage_->source; }
+
+  /// @brief Normalized source the tokens may refer to (const version).
+  const std::string& Source() const { return storage_->source; }
+
+  /// @brief Environment of the parse.
+  ParseEnv& Env() { return storage_->env; }
+
+  /// @brief Environment of the parse (const version).
+  const ParseEnv& Env() const { return storage_->env; }
+
+  /// @brief Allocator drawing from the result arena.
+  TokenAllocator Allocator() const { return TokenAllocator(&storage_->arena); }
+
+  /// @brief Number of tokens, children included.
+  std::size_t size() const { return storage_->tokens.size(); }
+
+  /// @brief Whether the result holds no tokens.
+  bool empty() const { return storage_->tokens.empty(); }
+
+  Token& operator[](std::size_t i) { return storage_->tokens[i]; }
+  const Token& operator[](std::size_t i) const { return storage_->tokens[i]; }
+
+  TokenList::iterator begin() { return storage_->tokens.begin(); }
+  TokenList::iterator end() { return storage_->tokens.end(); }
+  TokenList::const_iterator begin() const { return storage_->tokens.begin(); }
+  TokenList::const_iterator end() const { return storage_->tokens.end(); }
+
+ private:
+  /// @brief Heap-pinned arena, source and token list, so moving a result
+  /// never invalidates the memory its tokens point to.
+  struct Storage {
+    Storage(std::size_t initial_size, std::pmr::memory_resource* upstream,
+            std::pmr::memory_resource* buffer);
+
+    std::pmr::monotonic_buffer_resource arena;
+    std::string source;
+    ParseEnv env;
+    TokenList tokens;  ///< Declared after `arena`, destroyed before it.
+  };
+
+  std::unique_ptr<Storage> storage_;
+};
+
+}  // namespace aethermark
@@ -3,32 +3,42 @@
 
 #pragma once
 
-#include <any>
-#include <deque>
 #include <functional>
 #include <string>
 #include <vector>
 
 // #include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
 #include "aethermark/ruler.hpp"
 #include "aethermark/rules_block/state_block.hpp"
 #include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
 
 namespace aethermark {
 
 class Aethermark;
-
-/// @brief Alias for rule functions of the `ParserBlock`.
-using RuleBlock = std::function<bool(StateBlock&, int, int, bool)>;
+class ParseContext;
 
 /// @brief Parser for the block parsing stage.
 class ParserBlock {
  public:
   ParserBlock();
 
+  /// @brief Ids of the alternate chains holding terminator rules.
+  struct Chains {
+    RuleChainId paragraph;   ///< Rules that can interrupt a paragraph.
+    RuleChainId reference;   ///< Rules that can interrupt a reference.
+    RuleChainId blockquote;  ///< Rules that can interrupt a blockquote.
+    RuleChainId list;        ///< Rules that can interrupt a list.
+  };
+
   /// @brief Ruler with block-level rules.
   Ruler<RuleBlock> ruler;
 
+  /// @brief Chain ids resolved once at construction, for rules probing
+  /// terminators in `StateBlock::rules`.
+  Chains chains;
+
   /// @brief Generate tokens for input range.
   /// @param state Reference to the parser state.
   /// @param start_line Index of the starting line.
@@ -36,16 +46,38 @@ class ParserBlock {
   void Tokenize(StateBlock& state,  // NOLINT(runtime/references)
                 int start_line, int end_line);
 
+  /// @brief Line loop of `Tokenize`, with the rules tried on each line
+  /// supplied by the caller. Lets pipelines with a fixed rule set share the
+  /// loop while binding their rules at compile time.
+  /// @param state Reference to the parser state.
+  /// @param start_line Index of the starting line.
+  /// @param end_line Index of the ending line.
+  /// @param max_nesting Nesting level at which parsing stops.
+  /// @param match Called as `match(state, line, end_line)`; runs the first
+  /// matching rule and returns whether one matched.
+  /// @exception `std::runtime_error` if no rule matched or a rule did not
+  /// advance `state.line`.
+  template <typename Matcher>
+  static void TokenizeWith(StateBlock& state,  // NOLINT(runtime/references)
+                           int start_line, int end_line, int max_nesting,
+                           Matcher&& match);
+
   // NOLINTBEGIN(runtime/references)
 
   /// @brief Process the input string fully and push tokens into outTokens.
   /// @param str Source text.
   /// @param md Reference to the parser.
-  /// @param env Environment for parser.
+  /// @param env Environment for parser, shared with the caller.
   /// @param out_tokens Token output list.
-  void Parse(const std::string& str, Aethermark& md, std::any env,
-             std::deque<Token>& out_tokens);
+  /// @param context Buffers to reuse for the line metadata, if any.
+  /// @param rules Block rule chains of the parse, or null for the current
+  /// ones of `md`.
+  void Parse(const std::string& str, Aethermark& md, ParseEnv& env,
+             TokenList& out_tokens, ParseContext* context = nullptr,
+             RuleSnapshot<RuleBlock> rules = nullptr);
   // NOLINTEND
 };
 
 }  // namespace aethermark
+
+#include "parser_block.tpp"
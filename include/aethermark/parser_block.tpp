@@ -0,0 +1,64 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <stdexcept>
+
+#include "parser_block.hpp"
+
+namespace aethermark {
+
+template <typename Matcher>
+void ParserBlock::TokenizeWith(StateBlock& state, int startLine, int endLine,
+                               int maxNesting, Matcher&& match) {
+  int line = startLine;
+  bool has_empty_lines = false;
+
+  while (line < endLine) {
+    // Skip empty lines
+    state.line = state.SkipEmptyLines(line);
+    line = state.line;
+    if (line >= endLine) break;
+
+    // Termination for nested blocks (quotes, lists, etc.)
+    if (state.lines[line].s_count < state.blk_indent) {
+      break;
+    }
+
+    // Max nesting level reached → bail out
+    if (state.level >= maxNesting) {
+      state.line = endLine;
+      break;
+    }
+
+    const int prev_line = state.line;
+
+    // Paragraph rule disabled? → impossible in normal config
+    if (!match(state, line, endLine)) {
+      throw std::runtime_error("none of the block rules matched");
+    }
+    if (state.line <= prev_line) {
+      throw std::runtime_error("block rule didn't increment state.line");
+    }
+
+    // Update state.tight (same logic as JS)
+    state.tight = !has_empty_lines;
+
+    // Paragraphs sometimes consume the trailing newline
+    if (state.IsEmpty(state.line - 1)) {
+      has_empty_lines = true;
+    }
+
+    line = state.line;
+
+    // If next line is empty, mark it
+    if (line < endLine && state.IsEmpty(line)) {
+      has_empty_lines = true;
+      ++line;
+      state.line = line;
+    }
+  }
+}
+
+}  // namespace aethermark
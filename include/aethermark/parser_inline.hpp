@@ -0,0 +1,57 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+
+#include "aethermark/parse_env.hpp"
+#include "aethermark/ruler.hpp"
+#include "aethermark/rules_inline/state_inline.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace aethermark {
+
+class Aethermark;
+
+/// @brief Parser for the inline parsing stage.
+class ParserInline {
+ public:
+  ParserInline();
+
+  /// @brief Ruler with tokenizing rules. Each rule registers the characters
+  /// a match can start with, so only candidates run at each position.
+  Ruler<RuleInline> ruler;
+
+  /// @brief Ruler with post-processing rules.
+  Ruler<RuleInline2> ruler2;
+
+  /// @brief Generate tokens for the content of the state, from `state.pos`
+  /// to `state.pos_max`.
+  /// @param state Reference to the parser state.
+  /// @param rules Tokenizing rule chains to run.
+  void Tokenize(StateInline& state,  // NOLINT(runtime/references)
+                const RuleChains<RuleInline>& rules) const;
+
+  /// @brief Skip the token at `state.pos` without pushing anything, running
+  /// the rules in silent mode. Ends are cached, so a position is matched once
+  /// however many labels skip over it.
+  /// @param state Reference to the parser state.
+  void SkipToken(StateInline& state) const;  // NOLINT(runtime/references)
+
+  // NOLINTBEGIN(runtime/references)
+
+  /// @brief Parse the content of an `inline` token into its children.
+  /// @param tokens Token list holding the token.
+  /// @param parent Index of the token.
+  /// @param md Reference to the parser.
+  /// @param env Environment for parser, shared with the caller.
+  /// @param rules Tokenizing rule chains, snapshotted once per document.
+  /// @param rules2 Post-processing rule chains, snapshotted with `rules`.
+  void Parse(TokenList& tokens, std::size_t parent, Aethermark& md,
+             ParseEnv& env, const RuleChains<RuleInline>& rules,
+             const RuleChains<RuleInline2>& rules2) const;
+  // NOLINTEND
+};
+
+}  // namespace aethermark
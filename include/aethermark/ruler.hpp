@@ -3,10 +3,17 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -16,6 +23,10 @@ namespace aethermark {
 struct RuleOptions {
   /// @brief Array with names of "alternate" chains.
   std::vector<std::string> alt;
+
+  /// @brief Characters a match can start with, e.g. `"#"` for headings.
+  /// Empty if the rule may match on any character.
+  std::string triggers;
 };
 
 /// @brief A rule item for Ruler class.
@@ -33,14 +44,157 @@ struct Rule {
 
   /// @brief Whether the rule is enabled.
   bool enabled = true;
+
+  /// @brief Characters a match can start with, empty for any.
+  std::string triggers;
+};
+
+/// @brief Identifier of a rule chain, see `Ruler::ChainId`.
+using RuleChainId = std::uint32_t;
+
+/// @brief Id of the default chain, holding every enabled rule.
+inline constexpr RuleChainId kDefaultChain = 0;
+
+/// @brief Immutable snapshot of the rule chains of a `Ruler`.
+///
+/// All chains are stored back to back in one array, so fetching a chain is an
+/// index lookup returning a span, and running it walks contiguous memory.
+///
+/// Each chain also has a dispatch table keyed by the character a match would
+/// start with. It lists, in chain order, the rules whose triggers contain
+/// that character plus the rules without triggers, so callers skip rules that
+/// cannot match with a single table lookup.
+/// @tparam T The function type of the rule.
+template <typename T>
+class RuleChains {
+ public:
+  /// @brief Rule functions of a chain, in order.
+  /// @param chain Id of the chain.
+  /// @return The functions, empty for unknown chains.
+  std::span<const T> Get(RuleChainId chain) const {
+    if (chain >= ranges_.size()) return {};
+    return std::span<const T>(fns_).subspan(ranges_[chain].first,
+                                            ranges_[chain].second);
+  }
+
+  /// @brief Rule functions of a chain that may match input starting with a
+  /// given character, in order.
+  /// @param chain Id of the chain.
+  /// @param c The first character of the input.
+  /// @return The functions, empty for unknown chains.
+  std::span<const T> Get(RuleChainId chain, unsigned char c) const {
+    if (chain >= dispatch_.size()) return {};
+    const std::pair<std::uint32_t, std::uint32_t>& range = dispatch_[chain][c];
+    return std::span<const T>(dispatch_fns_).subspan(range.first,
+                                                     range.second);
+  }
+
+  /// @brief Look up a chain by name.
+  /// @param chain_name Name of the chain.
+  /// @return Id of the chain, or `std::nullopt` if it is unknown.
+  std::optional<RuleChainId> Find(std::string_view chain_name) const {
+    for (std::size_t i = 0; i < chain_names_.size(); i++) {
+      if (chain_names_[i] == chain_name) return static_cast<RuleChainId>(i);
+    }
+    return std::nullopt;
+  }
+
+  /// @brief Rule names of a chain, parallel to `Get`.
+  /// @param chain Id of the chain.
+  /// @return The names, empty for unknown chains.
+  std::span<const std::string> Names(RuleChainId chain) const {
+    if (chain >= ranges_.size()) return {};
+    return std::span<const std::string>(names_).subspan(
+        ranges_[chain].first, ranges_[chain].second);
+  }
+
+ private:
+  template <typename>
+  friend class Ruler;
+
+  std::vector<std::string> chain_names_;  ///< Index is the chain id.
+  std::vector<T> fns_;
+  std::vector<std::string> names_;
+  /// @brief `( offset, size )` of each chain, indexed by chain id.
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> ranges_;
+
+  /// @brief Per-character rule lists of all chains. Characters with the same
+  /// list share its storage.
+  std::vector<T> dispatch_fns_;
+
+  /// @brief `( offset, size )` into `dispatch_fns_`, per chain and character.
+  std::vector<std::array<std::pair<std::uint32_t, std::uint32_t>, 256>>
+      dispatch_;
+};
+
+/// @brief Reader's handle on a `RuleChains` snapshot, see `Ruler::Snapshot`.
+///
+/// The snapshot stays alive while a handle on it exists, even if the ruler is
+/// reconfigured or destroyed meanwhile, and is freed with its last handle.
+/// @tparam T The function type of the rule.
+template <typename T>
+using RuleSnapshot = std::shared_ptr<const RuleChains<T>>;
+
+/// @brief Rule functions of one chain, together with the snapshot holding
+/// them, see `Ruler::GetChain`. The functions stay valid while the handle
+/// exists, however the ruler changes meanwhile.
+/// @tparam T The function type of the rule.
+template <typename T>
+class RuleChain {
+ public:
+  using iterator = typename std::span<const T>::iterator;
+
+  RuleChain() = default;
+
+  /// @param snapshot The snapshot holding the functions.
+  /// @param fns The functions, a chain of `snapshot`.
+  RuleChain(RuleSnapshot<T> snapshot, std::span<const T> fns)
+      : snapshot_(std::move(snapshot)), fns_(fns) {}
+
+  iterator begin() const { return fns_.begin(); }
+  iterator end() const { return fns_.end(); }
+  std::size_t size() const { return fns_.size(); }
+  bool empty() const { return fns_.empty(); }
+  const T* data() const { return fns_.data(); }
+  const T& operator[](std::size_t i) const { return fns_[i]; }
+
+ private:
+  RuleSnapshot<T> snapshot_;
+  std::span<const T> fns_;
 };
 
 /// @brief A rule manager.
+///
+/// Every modification compiles the rules into a new `RuleChains` snapshot and
+/// publishes it by swapping the pointer to it under a mutex. Readers take the
+/// current snapshot with `Snapshot()`, a pointer copy under the same mutex,
+/// and keep it for the duration of their work: it never changes, and it stays
+/// alive while they hold it even if the ruler is reconfigured meanwhile.
+/// Reading is therefore safe from any number of threads. Modifications must
+/// not run concurrently with each other.
+///
+/// Each snapshot is freed when its last reader releases it, however busy the
+/// ruler is with newer ones.
 /// @tparam T The function type of the rule.
 template <typename T>
 class Ruler {
  public:
-  Ruler() = default;
+  Ruler() { Publish(); }
+
+  /// @brief Copy the rules. The copy compiles its own snapshot, and has no
+  /// publish listener.
+  Ruler(const Ruler& other) : rules_(other.rules_), chains_(other.chains_) {
+    Publish();
+  }
+
+  Ruler& operator=(const Ruler& other) {
+    if (this != &other) {
+      rules_ = other.rules_;
+      chains_ = other.chains_;
+      Publish();
+    }
+    return *this;
+  }
 
   /// @brief Replace rule by name with new function & options.
   /// @param name The name of the rule to replace.
@@ -124,7 +278,54 @@ class Ruler {
   std::vector<std::pair<std::string, T>> GetRules(
       const std::string& chain_name) const;
 
-  /// @brief Find rule by name.
+  /// @brief Get the id of a chain, registering the name if unknown. Ids stay
+  /// valid for the lifetime of the ruler, so callers resolve them once.
+  /// @param chain_name Name of the chain, empty for the default chain.
+  /// @return Id of the chain.
+  RuleChainId ChainId(const std::string& chain_name);
+
+  /// @brief Get the current snapshot of the chains. Safe to call while
+  /// another thread modifies the ruler.
+  /// @return Handle on the snapshot.
+  RuleSnapshot<T> Snapshot() const {
+    std::lock_guard<std::mutex> lock(current_mutex_);
+    return current_;
+  }
+
+  /// @brief Get enabled rule functions of a chain without copying them.
+  /// @param chain Id of the chain.
+  /// @return The functions, with the snapshot holding them.
+  RuleChain<T> GetChain(RuleChainId chain) const {
+    RuleSnapshot<T> snapshot = Snapshot();
+    std::span<const T> fns = snapshot->Get(chain);
+    return RuleChain<T>(std::move(snapshot), fns);
+  }
+
+  /// @brief Get enabled rule functions of a chain that may match input
+  /// starting with a given character.
+  /// @param chain Id of the chain.
+  /// @param c The first character of the input.
+  /// @return The functions, with the snapshot holding them.
+  RuleChain<T> GetChain(RuleChainId chain, unsigned char c) const {
+    RuleSnapshot<T> snapshot = Snapshot();
+    std::span<const T> fns = snapshot->Get(chain, c);
+    return RuleChain<T>(std::move(snapshot), fns);
+  }
+
+  /// @brief Get enabled rule functions of a chain without copying them.
+  /// @param chain_name Name of the chain.
+  /// @return The functions, with the snapshot holding them.
+  RuleChain<T> GetChain(const std::string& chain_name) const;
+
+  /// @brief Set a function called after each snapshot is published, e.g. by
+  /// an owner combining the snapshots of several rulers.
+  /// @param listener The function, or `nullptr` for none.
+  void OnPublish(std::function<void()> listener) {
+    on_publish_ = std::move(listener);
+  }
+
+  /// @brief Find rule by name. Changes made through the pointer take effect
+  /// with the next modification of the ruler.
   /// @param name Name of the rule.
   /// @return Pointer to the rule if found, `nullptr` otherwise.
   Rule<T>* FindRule(const std::string& name);
@@ -136,12 +337,29 @@ class Ruler {
 
  private:
   std::vector<Rule<T>> rules_;
-  mutable std::unordered_map<std::string,
-                             std::vector<std::pair<std::string, T>>>
-      cache_;
+  std::vector<std::string> chains_ = {""};  ///< Index is the chain id.
+
+  /// @brief Published snapshot, shared with the readers holding it.
+  RuleSnapshot<T> current_;
+
+  /// @brief Guards `current_` itself, not the snapshot it points to.
+  mutable std::mutex current_mutex_;
+
+  /// @brief Called after each publish, see `OnPublish`.
+  std::function<void()> on_publish_;
+
+  void RegisterChains(const std::vector<std::string>& names);
+
+  /// @brief Throw `std::runtime_error` naming the first unknown rule, so
+  /// `Enable` and `Disable` fail before changing anything.
+  void CheckRuleNames(const std::vector<std::string>& names) const;
+
+  /// @brief Compile the rules into a new snapshot.
+  std::shared_ptr<RuleChains<T>> Compile() const;
 
-  void Compile() const;
-  void Touch() const { cache_.clear(); }
+  /// @brief Compile and publish a new snapshot. The replaced one is freed by
+  /// its last reader.
+  void Publish();
 };
 
 }  // namespace aethermark
@@ -4,10 +4,18 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "ruler.hpp"
@@ -31,26 +39,45 @@ const Rule<T>* Ruler<T>::FindRule(const std::string& name) const {
 }
 
 template <typename T>
-void Ruler<T>::Compile() const {
-  std::vector<std::string> chains;
-  chains.push_back("");  // default chain
-
-  // collect unique alt-chains
-  for (typename std::vector<Rule<T>>::const_reference r : rules_) {
-    if (!r.enabled) continue;
+void Ruler<T>::CheckRuleNames(const std::vector<std::string>& names) const {
+  for (const std::string& name : names) {
+    if (!FindRule(name)) {
+      throw std::runtime_error("Invalid rule name: " + name);
+    }
+  }
+}
 
-    for (typename std::vector<std::string>::const_reference alt : r.alt) {
-      if (std::find(chains.begin(), chains.end(), alt) == chains.end()) {
-        chains.push_back(alt);
-      }
+template <typename T>
+void Ruler<T>::RegisterChains(const std::vector<std::string>& names) {
+  for (typename std::vector<std::string>::const_reference name : names) {
+    if (std::find(chains_.begin(), chains_.end(), name) == chains_.end()) {
+      chains_.push_back(name);
     }
   }
+}
 
-  cache_.clear();
+template <typename T>
+RuleChainId Ruler<T>::ChainId(const std::string& chainName) {
+  auto it = std::find(chains_.begin(), chains_.end(), chainName);
+  if (it != chains_.end()) {
+    return static_cast<RuleChainId>(it - chains_.begin());
+  }
+  chains_.push_back(chainName);
+  Publish();
+  return static_cast<RuleChainId>(chains_.size() - 1);
+}
+
+template <typename T>
+std::shared_ptr<RuleChains<T>> Ruler<T>::Compile() const {
+  auto compiled = std::make_shared<RuleChains<T>>();
+  RuleChains<T>& frozen = *compiled;
+  frozen.chain_names_ = chains_;
+  frozen.ranges_.reserve(chains_.size());
 
-  // build cache for each chain
-  for (typename std::vector<std::string>::const_reference chain : chains) {
-    std::vector<std::pair<std::string, T>> seq;
+  // build every chain into the shared arrays
+  for (typename std::vector<std::string>::const_reference chain : chains_) {
+    const auto offset = static_cast<std::uint32_t>(frozen.fns_.size());
+    std::vector<const Rule<T>*> members;
 
     for (typename std::vector<Rule<T>>::const_reference r : rules_) {
       if (!r.enabled) continue;
@@ -62,11 +89,75 @@ void Ruler<T>::Compile() const {
         }
       }
 
-      seq.push_back(std::pair<std::string, T>(r.name, r.fn));
+      frozen.fns_.push_back(r.fn);
+      frozen.names_.push_back(r.name);
+      members.push_back(&r);
+    }
+
+    frozen.ranges_.emplace_back(
+        offset, static_cast<std::uint32_t>(frozen.fns_.size()) - offset);
+
+    // build the dispatch table, storing each distinct rule list once
+    std::array<std::pair<std::uint32_t, std::uint32_t>, 256>& table =
+        frozen.dispatch_.emplace_back();
+    std::map<std::vector<std::size_t>,
+             std::pair<std::uint32_t, std::uint32_t>>
+        lists;
+
+    auto list_for = [&](unsigned char c) {
+      std::vector<std::size_t> list;
+      for (std::size_t i = 0; i < members.size(); i++) {
+        const std::string& triggers = members[i]->triggers;
+        if (triggers.empty() ||
+            triggers.find(static_cast<char>(c)) != std::string::npos) {
+          list.push_back(i);
+        }
+      }
+
+      auto it = lists.find(list);
+      if (it == lists.end()) {
+        std::vector<T>& fns = frozen.dispatch_fns_;
+        const auto start = static_cast<std::uint32_t>(fns.size());
+        for (std::size_t i : list) fns.push_back(members[i]->fn);
+        const auto size = static_cast<std::uint32_t>(fns.size()) - start;
+        it = lists.emplace(std::move(list), std::make_pair(start, size)).first;
+      }
+      return it->second;
+    };
+
+    // characters no rule is triggered by all get the untriggered rules
+    std::array<bool, 256> triggered{};
+    for (const Rule<T>* r : members) {
+      for (char c : r->triggers) {
+        triggered[static_cast<unsigned char>(c)] = true;
+      }
+    }
+
+    std::optional<std::pair<std::uint32_t, std::uint32_t>> untriggered;
+    for (std::size_t c = 0; c < table.size(); c++) {
+      const auto ch = static_cast<unsigned char>(c);
+      if (triggered[c]) {
+        table[c] = list_for(ch);
+      } else {
+        if (!untriggered.has_value()) untriggered = list_for(ch);
+        table[c] = *untriggered;
+      }
     }
+  }
 
-    cache_[chain] = seq;
+  return compiled;
+}
+
+template <typename T>
+void Ruler<T>::Publish() {
+  RuleSnapshot<T> next = Compile();
+  {
+    std::lock_guard<std::mutex> lock(current_mutex_);
+    current_.swap(next);
   }
+  // `next` holds the replaced snapshot now; release it outside the lock
+  next.reset();
+  if (on_publish_) on_publish_();
 }
 
 template <typename T>
@@ -76,8 +167,10 @@ void Ruler<T>::At(const std::string& name, T fn, const RuleOptions& options) {
 
   r->fn = fn;
   r->alt = options.alt;
+  r->triggers = options.triggers;
+  RegisterChains(options.alt);
 
-  Touch();
+  Publish();
 }
 
 template <typename T>
@@ -92,9 +185,11 @@ void Ruler<T>::Before(const std::string& beforeName,
     return r.name == beforeName;
   });
 
-  rules_.insert(it, Rule<T>{ruleName, fn, options.alt, true});
+  rules_.insert(it,
+                Rule<T>{ruleName, fn, options.alt, true, options.triggers});
+  RegisterChains(options.alt);
 
-  Touch();
+  Publish();
 }
 
 template <typename T>
@@ -106,34 +201,38 @@ void Ruler<T>::After(const std::string& afterName, const std::string& ruleName,
   auto it = std::find_if(rules_.begin(), rules_.end(),
                          [&](const Rule<T>& r) { return r.name == afterName; });
 
-  rules_.insert(it + 1, Rule<T>{ruleName, fn, options.alt, true});
+  rules_.insert(it + 1,
+                Rule<T>{ruleName, fn, options.alt, true, options.triggers});
+  RegisterChains(options.alt);
 
-  Touch();
+  Publish();
 }
 
 template <typename T>
 void Ruler<T>::Push(const std::string& ruleName, T fn,
                     const RuleOptions& options) {
-  rules_.push_back(Rule<T>{ruleName, fn, options.alt, true});
-  Touch();
+  rules_.push_back(
+      Rule<T>{ruleName, fn, options.alt, true, options.triggers});
+  RegisterChains(options.alt);
+  Publish();
 }
 
 template <typename T>
 std::vector<std::string> Ruler<T>::Enable(const std::vector<std::string>& list,
                                           bool ignoreInvalid) {
+  // fail before changing anything
+  if (!ignoreInvalid) CheckRuleNames(list);
+
   std::vector<std::string> res;
 
   for (auto& name : list) {
     Rule<T>* r = FindRule(name);
-    if (!r) {
-      if (ignoreInvalid) continue;
-      throw std::runtime_error("Invalid rule name: " + name);
-    }
+    if (!r) continue;
     r->enabled = true;
     res.push_back(name);
   }
 
-  Touch();
+  Publish();
   return res;
 }
 
@@ -146,6 +245,8 @@ std::vector<std::string> Ruler<T>::Enable(const std::string& name,
 template <typename T>
 void Ruler<T>::EnableOnly(const std::vector<std::string>& list,
                           bool ignoreInvalid) {
+  if (!ignoreInvalid) CheckRuleNames(list);
+
   // disable everything
   for (auto& r : rules_) r.enabled = false;
 
@@ -156,19 +257,19 @@ void Ruler<T>::EnableOnly(const std::vector<std::string>& list,
 template <typename T>
 std::vector<std::string> Ruler<T>::Disable(const std::vector<std::string>& list,
                                            bool ignoreInvalid) {
+  // fail before changing anything
+  if (!ignoreInvalid) CheckRuleNames(list);
+
   std::vector<std::string> res;
 
   for (auto& name : list) {
     Rule<T>* r = FindRule(name);
-    if (!r) {
-      if (ignoreInvalid) continue;
-      throw std::runtime_error("Invalid rule name: " + name);
-    }
+    if (!r) continue;
     r->enabled = false;
     res.push_back(name);
   }
 
-  Touch();
+  Publish();
   return res;
 }
 
@@ -181,12 +282,28 @@ std::vector<std::string> Ruler<T>::Disable(const std::string& name,
 template <typename T>
 std::vector<std::pair<std::string, T>> Ruler<T>::GetRules(
     const std::string& chainName) const {
-  if (cache_.empty()) Compile();
+  RuleSnapshot<T> snapshot = Snapshot();
+  std::optional<RuleChainId> chain = snapshot->Find(chainName);
+  if (!chain.has_value()) return {};
 
-  auto it = cache_.find(chainName);
-  if (it == cache_.end()) return {};
+  std::span<const T> fns = snapshot->Get(*chain);
+  std::span<const std::string> names = snapshot->Names(*chain);
 
-  return it->second;
+  std::vector<std::pair<std::string, T>> rules;
+  rules.reserve(fns.size());
+  for (std::size_t i = 0; i < fns.size(); i++) {
+    rules.emplace_back(names[i], fns[i]);
+  }
+  return rules;
+}
+
+template <typename T>
+RuleChain<T> Ruler<T>::GetChain(const std::string& chainName) const {
+  RuleSnapshot<T> chains = Snapshot();
+  std::optional<RuleChainId> chain = chains->Find(chainName);
+  if (!chain.has_value()) return {};
+  std::span<const T> fns = chains->Get(*chain);
+  return RuleChain<T>(std::move(chains), fns);
 }
 
 }  // namespace aethermark
@@ -7,6 +7,20 @@
 
 namespace aethermark {
 
+/// @brief Characters a match of each block rule can start with. Shared by
+/// `ParserBlock` and `StaticAethermark`, so both skip the same rules.
+struct BlockTriggers {
+  BlockTriggers() = delete;
+
+  static constexpr char kFence[] = "`~";
+  static constexpr char kBlockquote[] = ">";
+  static constexpr char kHr[] = "*-_";
+  static constexpr char kList[] = "*+-0123456789";
+  static constexpr char kReference[] = "[";
+  static constexpr char kHtmlBlock[] = "<";
+  static constexpr char kHeading[] = "#";
+};
+
 /// @brief Static class for all the block parser rules.
 class BlockRules {
  public:
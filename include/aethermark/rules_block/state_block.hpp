@@ -3,17 +3,70 @@
 
 #pragma once
 
-#include <any>
-#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "aethermark/parse_env.hpp"
+#include "aethermark/ruler.hpp"
 #include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
 #include "aethermark/utils.hpp"
 
 namespace aethermark {
 
 class Aethermark;
+class ParseContext;
+class StateBlock;
+
+/// @brief Alias for rule functions of the `ParserBlock`.
+using RuleBlock = std::function<bool(StateBlock&, int, int, bool)>;
+
+/// @brief Offset into the source of a block parse. 64 bits wide when built
+/// with `AETHERMARK_64BIT_OFFSETS`, for sources of 2 GB and more.
+#if defined(AETHERMARK_64BIT_OFFSETS)
+using SourcePos = std::int64_t;
+#else
+using SourcePos = int;
+#endif
+
+/// @brief Metadata of one source line. Rules inspecting a line read several
+/// fields at once, so they are kept together in one record.
+struct LineInfo {
+  /// @brief beginning offset.
+  SourcePos b_mark;
+
+  /// @brief ending offset.
+  SourcePos e_mark;
+
+  /// @brief first non-space char (tabs not expanded), relative to `b_mark`.
+  int t_shift;
+
+  /// @brief indent count (tabs expanded).
+  int s_count;
+
+  /// @brief special tab-expansion offset (for blockquotes).
+  int bs_count;
+
+  /// @brief Offset of the first non-space char.
+  SourcePos First() const { return b_mark + t_shift; }
+};
+
+static_assert(sizeof(LineInfo) <= 32, "two line records per cache line");
+
+/// @brief Line record saved by `StateBlock::SaveLine`.
+struct SavedLine {
+  int line;       ///< Index of the line.
+  LineInfo info;  ///< The record before it was changed.
+};
+
+/// @brief Position in the line undo log of a `StateBlock`.
+using LineCheckpoint = std::size_t;
 
 /// @brief Represents the parent type in aethermark.
 enum class ParentType {
@@ -21,50 +74,55 @@ enum class ParentType {
   kList,        ///< List.
   kRoot,        ///< Root.
   kParagraph,   ///< Paragraph.
-  kReference    ///< Reference.
+  kReference,   ///< Reference.
+  kTable        ///< Table.
 };
 
 /// @brief Represents the state object in the block parsing stage.
 class StateBlock {
  public:
   /// @brief Constructs a new block state object.
-  /// @param src Document source.
+  /// @param src Document source. Tokens may borrow text from it, so it must
+  /// outlive them.
   /// @param md Reference to the parser.
-  /// @param env Environment for parser.
+  /// @param env Environment for parser, shared with the caller.
   /// @param tokens List of tokens.
+  /// @param context Buffers to reuse for the line metadata, if any. The
+  /// state borrows them until it is destroyed.
+  /// @param rules Block rule chains of the parse, or null for the current
+  /// ones of `md`.
   StateBlock(const std::string& src,
              Aethermark& md,  // NOLINT(runtime/references)
-             std::any env,
-             std::deque<Token>& tokens);  // NOLINT(runtime/references)
+             ParseEnv& env,  // NOLINT(runtime/references)
+             TokenList& tokens,  // NOLINT(runtime/references)
+             ParseContext* context = nullptr,
+             RuleSnapshot<RuleBlock> rules = nullptr);
+
+  StateBlock(const StateBlock&) = delete;
+  StateBlock& operator=(const StateBlock&) = delete;
+
+  /// @brief Gives the line metadata buffers back to the context, if any.
+  ~StateBlock();
 
   /// @brief Source string.
-  std::string src;
+  const std::string& src;
 
   /// @brief Reference to the parser.
   Aethermark& md;
 
-  /// @brief Environment for parser.
-  std::any env;
+  /// @brief Environment for parser, owned by the caller of the parse.
+  ParseEnv& env;  // NOLINT(runtime/references)
 
   /// @brief Token stream (block-level).
-  std::deque<Token>& tokens;
-
-  // line metadata
-
-  /// @brief beginning offsets.
-  std::vector<int> b_marks;
-
-  /// @brief ending offsets.
-  std::vector<int> e_marks;
+  TokenList& tokens;
 
-  /// @brief first non-space char (tabs not expanded).
-  std::vector<int> t_shift;
+  /// @brief Block rule chains of the parse's configuration, so that the
+  /// whole document sees one configuration.
+  RuleSnapshot<RuleBlock> rules;
 
-  /// @brief indent count (tabs expanded).
-  std::vector<int> s_count;
-
-  /// @brief special tab-expansion offset (for blockquotes).
-  std::vector<int> bs_count;
+  /// @brief Line metadata, one record per line plus a sentinel for the end
+  /// of the source.
+  std::vector<LineInfo> lines;
 
   // parser state vars
 
@@ -96,8 +154,24 @@ class StateBlock {
   /// @param type Type of token.
   /// @param tag Tag of token.
   /// @param nesting Nesting level of token.
-  /// @return Reference to the pushed token.
-  Token& Push(const std::string& type, const std::string& tag, Nesting nesting);
+  /// @return Reference to the pushed token, valid until the next push.
+  Token& Push(TokenType type, TokenTag tag, Nesting nesting);
+
+  /// @brief Mark the current position in the line undo log. Container rules
+  /// take a checkpoint before changing line records for their contents.
+  /// @return Position to pass to `Rollback`.
+  LineCheckpoint Checkpoint() const { return line_undo_.size(); }
+
+  /// @brief Save a line record so that `Rollback` can restore it, before
+  /// changing it.
+  /// @param line Index of line.
+  /// @return The record, to change in place.
+  LineInfo& SaveLine(int line);
+
+  /// @brief Restore every line record saved since a checkpoint and drop them
+  /// from the log. Checkpoints must be rolled back innermost first.
+  /// @param checkpoint Position returned by `Checkpoint`.
+  void Rollback(LineCheckpoint checkpoint);
 
   /// @brief Whether line is empty.
   /// @param line Index of line.
@@ -111,26 +185,26 @@ class StateBlock {
   /// @brief Skip spaces from given position.
   /// @param pos index in source.
   /// @return index of first non-space character.
-  int SkipSpaces(int pos) const;
+  SourcePos SkipSpaces(SourcePos pos) const;
 
   /// @brief Skip spaces from given position in reverse.
   /// @param pos Index of position (right).
   /// @param min Index where the skipping will stop (left).
   /// @return New index of the non-space character.
-  int SkipSpacesBack(int pos, int min) const;
+  SourcePos SkipSpacesBack(SourcePos pos, SourcePos min) const;
 
   /// @brief Skip give character from given position.
   /// @param pos Initial index.
   /// @param code Character to be escaped.
   /// @return Index of first non-code character.
-  int SkipChars(int pos, int code) const;
+  SourcePos SkipChars(SourcePos pos, int code) const;
 
   /// @brief Skip characters from given position in reverse.
   /// @param pos Initial index (right).
   /// @param code Character to be escaped.
   /// @param min Index where the skipping will stop (left).
   /// @return Index of first non-code character.
-  int SkipCharsBack(int pos, int code, int min) const;
+  SourcePos SkipCharsBack(SourcePos pos, int code, SourcePos min) const;
 
   /// @brief Cut lines range from source.
   /// @param begin The first line index to include (inclusive).
@@ -140,6 +214,41 @@ class StateBlock {
   /// extracted line.
   /// @return A single string containing the concatenated lines.
   std::string GetLines(int begin, int end, int indent, bool keep_last_lf) const;
+
+  /// @brief Cut lines range from source, appending it to a buffer. The buffer
+  /// grows at most once and every byte is copied once.
+  /// @param begin The first line index to include (inclusive).
+  /// @param end The line index to stop at (exclusive).
+  /// @param indent The amount of indentation to remove from each line.
+  /// @param keep_last_lf If true, keeps the final newline character of the last
+  /// extracted line.
+  /// @param out Buffer to append to.
+  void AppendLines(int begin, int end, int indent, bool keep_last_lf,
+                   std::string& out) const;  // NOLINT(runtime/references)
+
+  /// @brief Cut lines range from source, appending it to a buffer, e.g. token
+  /// text allocated from the parse arena. See the `std::string` overload.
+  void AppendLines(int begin, int end, int indent, bool keep_last_lf,
+                   std::pmr::string& out) const;  // NOLINT(runtime/references)
+
+  /// @brief Cut lines range from source without copying, if possible.
+  /// @param begin The first line index to include (inclusive).
+  /// @param end The line index to stop at (exclusive).
+  /// @param indent The amount of indentation to remove from each line.
+  /// @param keep_last_lf If true, keeps the final newline character of the last
+  /// extracted line.
+  /// @return View of the source equal to `GetLines` with the same arguments,
+  /// or `std::nullopt` if removing indentation leaves gaps between lines or
+  /// needs partial tab expansion.
+  std::optional<std::string_view> GetLinesView(int begin, int end, int indent,
+                                               bool keep_last_lf) const;
+
+ private:
+  /// @brief Context the line metadata buffers are borrowed from.
+  ParseContext* context_;
+
+  /// @brief Saved line records, shared by all container rules of the parse.
+  std::vector<SavedLine> line_undo_;
 };
 
 }  // namespace aethermark
@@ -3,42 +3,55 @@
 
 #pragma once
 
-#include <any>
-#include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "aethermark/parse_env.hpp"
 #include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
 
 namespace aethermark {
 
 class Aethermark;
+class ParseContext;
+struct ParserRules;
 
 /// @brief Represents the state object in the core parsing stage.
 class StateCore {
  public:
   /// @brief Constructs a new core state object.
-  /// @param src Document source.
+  /// @param src Document source, normalized in place. Tokens may borrow text
+  /// from it, so it must outlive them.
   /// @param md Reference to the parser.
-  /// @param env Environment for parser.
-  StateCore(const std::string& src,
+  /// @param env Environment for parser, shared with the caller.
+  /// @param tokens Token stream to fill.
+  StateCore(std::string& src,  // NOLINT(runtime/references)
             Aethermark& md,  // NOLINT(runtime/references)
-            std::any env);
+            ParseEnv& env,  // NOLINT(runtime/references)
+            TokenList& tokens);  // NOLINT(runtime/references)
 
   /// @brief Source string being parsed.
-  std::string src;
+  std::string& src;  // NOLINT(runtime/references)
 
-  /// @brief Environment data.
-  std::any env;
+  /// @brief Environment data, owned by the caller of the parse.
+  ParseEnv& env;  // NOLINT(runtime/references)
 
   /// @brief List of tokens generated during parsing.
-  std::deque<Token> tokens;
+  TokenList& tokens;
 
   /// @brief Whether the state is for inline mode.
   bool inline_mode = false;
 
   /// @brief Reference to the main Aethermark instance.
   Aethermark& md;  // NOLINT(runtime/references)
+
+  /// @brief Buffers reused across parses, if the caller supplied them.
+  ParseContext* context = nullptr;
+
+  /// @brief Rule configuration of the parse, taken from `md` when the core
+  /// chain starts unless the caller set one.
+  std::shared_ptr<const ParserRules> rules;
 };
 
 }  // namespace aethermark
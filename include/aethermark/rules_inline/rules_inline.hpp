@@ -0,0 +1,66 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "aethermark/rules_inline/state_inline.hpp"
+
+namespace aethermark {
+
+/// @brief Static class for all the inline parser rules.
+class InlineRules {
+ public:
+  InlineRules() = delete;
+
+  /// @brief Whether a character can start a markup construct, and so ends a
+  /// run of plain text. Not all of them start one in CommonMark; the rest are
+  /// kept for plugins, like in markdown-it.
+  /// @param c The character.
+  static bool IsTerminator(unsigned char c);
+
+  /// @brief Find the end of the run of plain text starting at `pos`.
+  /// @param src The content.
+  /// @param pos Start of the run.
+  /// @return Position of the first terminator at or after `pos`, or
+  /// `src.size()`.
+  static std::size_t SkipText(std::string_view src, std::size_t pos);
+
+  // NOLINTBEGIN(runtime/references)
+
+  // Tokenizing rules, run at each position of the content.
+
+  static bool RuleAutolink(StateInline& state, bool silent);
+
+  static bool RuleBackticks(StateInline& state, bool silent);
+
+  static bool RuleEmphasis(StateInline& state, bool silent);
+
+  static bool RuleEntity(StateInline& state, bool silent);
+
+  static bool RuleEscape(StateInline& state, bool silent);
+
+  static bool RuleHtmlInline(StateInline& state, bool silent);
+
+  static bool RuleImage(StateInline& state, bool silent);
+
+  static bool RuleLink(StateInline& state, bool silent);
+
+  static bool RuleNewline(StateInline& state, bool silent);
+
+  static bool RuleText(StateInline& state, bool silent);
+
+  // Post-processing rules, run once over the children.
+
+  static void RuleBalancePairs(StateInline& state);
+
+  static void RuleEmphasisPost(StateInline& state);
+
+  static void RuleFragmentsJoin(StateInline& state);
+
+  // NOLINTEND
+};
+
+}  // namespace aethermark
@@ -0,0 +1,196 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "aethermark/parse_env.hpp"
+#include "aethermark/ruler.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace aethermark {
+
+class Aethermark;
+class StateInline;
+
+/// @brief Alias for tokenizing rule functions of the `ParserInline`.
+using RuleInline = std::function<bool(StateInline&, bool)>;
+
+/// @brief Alias for post-processing rule functions of the `ParserInline`.
+using RuleInline2 = std::function<void(StateInline&)>;
+
+/// @brief A marker of an emphasis-like delimiter run, recorded by the
+/// tokenizing rules and paired by `balance_pairs`.
+struct Delimiter {
+  /// @brief Marker character, e.g. `*`.
+  char marker;
+
+  /// @brief Length of the run the marker belongs to.
+  int length;
+
+  /// @brief Index of the marker's `text` token among the children.
+  std::size_t token;
+
+  /// @brief Index of the matching closer in the same list, -1 if none.
+  int end;
+
+  /// @brief Whether the marker can open emphasis.
+  bool open;
+
+  /// @brief Whether the marker can close emphasis.
+  bool close;
+};
+
+/// @brief Delimiters of one nesting level, in document order.
+using DelimiterList = std::pmr::vector<Delimiter>;
+
+/// @brief Result of `StateInline::ScanDelims`.
+struct DelimiterRun {
+  bool can_open;       ///< Whether the run is left-flanking enough to open.
+  bool can_close;      ///< Whether the run is right-flanking enough to close.
+  std::size_t length;  ///< Number of markers in the run.
+};
+
+/// @brief Represents the state object in the inline parsing stage.
+///
+/// Tokens are appended straight to the children of the parent `inline`
+/// token in the document `TokenList`. Text that is a slice of the parent's
+/// content is borrowed when that content is itself borrowed from the source,
+/// and copied otherwise.
+class StateInline {
+ public:
+  /// @brief Constructs a new inline state object.
+  /// @param src Content to parse. Must stay valid and in place for the
+  /// whole parse.
+  /// @param md Reference to the parser.
+  /// @param env Environment for parser, shared with the caller.
+  /// @param tokens Token list holding the parent token.
+  /// @param parent Index of the parent `inline` token.
+  /// @param stable_src Whether `src` outlives the tokens, so that they may
+  /// borrow slices of it.
+  StateInline(std::string_view src,
+              Aethermark& md,  // NOLINT(runtime/references)
+              ParseEnv& env,  // NOLINT(runtime/references)
+              TokenList& tokens,  // NOLINT(runtime/references)
+              std::size_t parent, bool stable_src);
+
+  StateInline(const StateInline&) = delete;
+  StateInline& operator=(const StateInline&) = delete;
+
+  /// @brief Content being parsed.
+  std::string_view src;
+
+  /// @brief Reference to the parser.
+  Aethermark& md;
+
+  /// @brief Environment for parser, owned by the caller of the parse.
+  ParseEnv& env;  // NOLINT(runtime/references)
+
+  /// @brief Token list the children are appended to.
+  TokenList& tokens;
+
+  /// @brief Index of the parent `inline` token in `tokens`.
+  std::size_t parent;
+
+  /// @brief Tokenizing rule chains of the parse, for rules tokenizing nested
+  /// content like link texts.
+  const RuleChains<RuleInline>* rules = nullptr;
+
+  /// @brief Current position in `src`.
+  std::size_t pos = 0;
+
+  /// @brief End of the content to parse.
+  std::size_t pos_max;
+
+  /// @brief Nesting level of the next token.
+  int level = 0;
+
+  /// @brief Nesting level of the pending text.
+  int pending_level = 0;
+
+  /// @brief Start of the pending text in `src`.
+  std::size_t pending_begin = 0;
+
+  /// @brief End of the pending text in `src`, equal to `pending_begin` when
+  /// there is none.
+  std::size_t pending_end = 0;
+
+  /// @brief Counter used to disable inline linkify-it execution inside
+  /// `<a>` and markdown links.
+  int link_level = 0;
+
+  /// @brief End of the token starting at each position, filled by
+  /// `ParserInline::SkipToken`.
+  std::pmr::unordered_map<std::size_t, std::size_t> cache;
+
+  /// @brief Smallest position of a closing backtick run, by run length,
+  /// past which no closer of that length exists. Zero if not known.
+  std::vector<std::size_t> backticks;
+
+  /// @brief Whether `backticks` covers the whole content.
+  bool backticks_scanned = false;
+
+  /// @brief Delimiters of the current nesting level. Opening tokens start a
+  /// new list; closing tokens move it to `nested_delimiters` and go back to
+  /// the enclosing one, so pairs never cross e.g. a link boundary.
+  DelimiterList delimiters;
+
+  /// @brief Delimiter lists of closed nesting levels, e.g. link texts.
+  std::pmr::vector<DelimiterList> nested_delimiters;
+
+  /// @brief Whether there is pending text.
+  bool HasPending() const { return pending_end > pending_begin; }
+
+  /// @brief Add `src[begin..end)` to the pending text. Text not following the
+  /// current pending text is flushed to its own token first.
+  /// @param begin Start of the text in `src`.
+  /// @param end End of the text in `src`.
+  void AddPending(std::size_t begin, std::size_t end);
+
+  /// @brief Flush pending text to a `text` token.
+  /// @return Reference to the token, valid until the next push.
+  Token& PushPending();
+
+  /// @brief Push a new token, flushing the pending text first.
+  /// @param type Type of token.
+  /// @param tag Tag of token.
+  /// @param nesting Nesting of token.
+  /// @return Reference to the pushed token, valid until the next push.
+  Token& Push(TokenType type, TokenTag tag, Nesting nesting);
+
+  /// @brief Set the content of a token to a slice of `src`, borrowing it when
+  /// the content outlives the tokens.
+  /// @param token Token to fill.
+  /// @param begin Start of the slice in `src`.
+  /// @param end End of the slice in `src`.
+  void SetContent(Token& token,  // NOLINT(runtime/references)
+                  std::size_t begin, std::size_t end) const;
+
+  /// @brief Scan a run of identical markers, like `*` or `_`, and tell
+  /// whether it can open or close emphasis, using the flanking rules of
+  /// CommonMark.
+  /// @param start Position of the first marker.
+  /// @param can_split_word Whether the marker may open or close inside a
+  /// word, true for `*` and false for `_`.
+  DelimiterRun ScanDelims(std::size_t start, bool can_split_word) const;
+
+  /// @brief Children of the parent token.
+  std::span<Token> Children() { return tokens.Children(tokens[parent]); }
+
+ private:
+  /// @brief Whether `src` outlives the tokens.
+  bool stable_src_;
+
+  /// @brief Delimiter lists of the enclosing nesting levels.
+  std::pmr::vector<DelimiterList> prev_delimiters_;
+};
+
+}  // namespace aethermark
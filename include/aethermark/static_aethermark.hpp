@@ -0,0 +1,243 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <string>
+#include <utility>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/parser_block.hpp"
+#include "aethermark/rules_block/rules_block.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+#include "aethermark/rules_core/rules_core.hpp"
+#include "aethermark/rules_core/state_core.hpp"
+
+namespace aethermark {
+
+/// @brief Presets a `StaticAethermark` can be specialized for.
+enum class PresetId {
+  kZero,        ///< The "zero" preset.
+  kCommonmark,  ///< The "commonmark" preset.
+};
+
+/// @brief Block rule bound at compile time.
+/// @tparam Fn The rule function.
+/// @tparam Triggers Characters a match can start with, from `BlockTriggers`,
+/// or null for any.
+template <auto Fn, const char* Triggers = nullptr>
+struct StaticBlockRule {
+  /// @brief Whether the rule can match a line starting with `c`.
+  static constexpr bool Accepts(unsigned char c) {
+    if constexpr (Triggers == nullptr) {
+      return true;
+    } else {
+      for (const char* t = Triggers; *t != '\0'; t++) {
+        if (c == static_cast<unsigned char>(*t)) return true;
+      }
+      return false;
+    }
+  }
+
+  /// @brief Run the rule on a line, if it can match it.
+  static bool Run(StateBlock& state,  // NOLINT(runtime/references)
+                  unsigned char first, int line, int end_line) {
+    return Accepts(first) && Fn(state, line, end_line, false);
+  }
+};
+
+/// @brief Block rule chain bound at compile time, tried in order.
+/// @tparam Rules `StaticBlockRule` instances.
+template <typename... Rules>
+struct StaticBlockChain {
+  /// @brief Run the first rule matching a line. Matcher for
+  /// `ParserBlock::TokenizeWith`.
+  static bool Match(StateBlock& state,  // NOLINT(runtime/references)
+                    int line, int end_line) {
+    const unsigned char first = state.src[state.lines[line].First()];
+    return (Rules::Run(state, first, line, end_line) || ...);
+  }
+
+  /// @brief Core rule running the chain over the whole document, in place of
+  /// `CoreRules::RuleBlock`.
+  static void RuleBlock(StateCore& state) {  // NOLINT(runtime/references)
+    if (state.inline_mode) {
+      CoreRules::RuleBlock(state);
+      return;
+    }
+    if (state.src.empty()) return;
+
+    StateBlock block(state.src, state.md, state.env, state.tokens,
+                     state.context, state.rules->block_rules);
+    ParserBlock::TokenizeWith(block, block.line, block.line_max,
+                              state.md.options.max_nesting, &Match);
+  }
+};
+
+/// @brief Core rule chain bound at compile time, run in order.
+/// @tparam Rules The rule functions.
+template <auto... Rules>
+struct StaticCoreChain {
+  /// @brief Run every rule on the state, then drop the children merged away
+  /// by the rules, as `ParserCore::Process` does.
+  static void Process(StateCore& state) {  // NOLINT(runtime/references)
+    if (!state.rules) state.rules = state.md.Rules();
+    (Rules(state), ...);
+    state.tokens.Compact();
+  }
+};
+
+/// @brief Rule chains of a preset, in `Ruler` order with disabled rules left
+/// out.
+template <PresetId P>
+struct StaticPreset;
+
+template <>
+struct StaticPreset<PresetId::kZero> {
+  static constexpr const char* kName = "zero";
+
+  using Block =
+      StaticBlockChain<StaticBlockRule<&BlockRules::RuleParagraph>>;
+
+  using Core = StaticCoreChain<&CoreRules::RuleNormalize, &Block::RuleBlock,
+                               &CoreRules::RuleInline,
+                               &CoreRules::RuleTextJoin>;
+};
+
+template <>
+struct StaticPreset<PresetId::kCommonmark> {
+  static constexpr const char* kName = "commonmark";
+
+  using Block = StaticBlockChain<
+      StaticBlockRule<&BlockRules::RuleCode>,
+      StaticBlockRule<&BlockRules::RuleFence, BlockTriggers::kFence>,
+      StaticBlockRule<&BlockRules::RuleBlockquote, BlockTriggers::kBlockquote>,
+      StaticBlockRule<&BlockRules::RuleHr, BlockTriggers::kHr>,
+      StaticBlockRule<&BlockRules::RuleList, BlockTriggers::kList>,
+      StaticBlockRule<&BlockRules::RuleReference, BlockTriggers::kReference>,
+      StaticBlockRule<&BlockRules::RuleHtmlBlock, BlockTriggers::kHtmlBlock>,
+      StaticBlockRule<&BlockRules::RuleHeading, BlockTriggers::kHeading>,
+      StaticBlockRule<&BlockRules::RuleLheading>,
+      StaticBlockRule<&BlockRules::RuleParagraph>>;
+
+  using Core = StaticCoreChain<&CoreRules::RuleNormalize, &Block::RuleBlock,
+                               &CoreRules::RuleInline,
+                               &CoreRules::RuleTextJoin>;
+};
+
+/// @brief Parser specialized at compile time for a fixed preset.
+///
+/// The top-level core and block rule loops call the built-in rule functions
+/// directly, so the compiler can inline them instead of going through
+/// `std::function` and the enable flags of a `Ruler`. The token stream is
+/// the same as the one of `Aethermark` configured with the preset. Nested
+/// blocks, terminator probing and the inline stage still run through the
+/// rulers of an internal `Aethermark` configured with the same preset. That
+/// instance is never reconfigured after construction, so its rules always
+/// match the compile-time chains.
+/// @tparam P The preset.
+template <PresetId P>
+class StaticAethermark {
+ public:
+  /// @brief Rule chains of the preset.
+  using Traits = StaticPreset<P>;
+
+  StaticAethermark() : md_(Traits::kName) {}
+
+  /// @brief Constructs a parser overriding the preset options.
+  /// @param options Options to use.
+  explicit StaticAethermark(const Options& options)
+      : md_(Traits::kName, options) {}
+
+  /// @brief Options of the parser.
+  const Options& options() const { return md_.options; }
+
+  /// @brief Parse a document.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @return Tokens, living in the arena owned by the result.
+  ParseResult Parse(const std::string& src, ParseEnv env) {
+    ParseResult result(src.size());
+    ParseInto(src, std::move(env), result, false, nullptr);
+    return result;
+  }
+
+  /// @brief Parse a single inline string.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @return Tokens, living in the arena owned by the result.
+  ParseResult ParseInline(const std::string& src, ParseEnv env) {
+    ParseResult result(src.size());
+    ParseInto(src, std::move(env), result, true, nullptr);
+    return result;
+  }
+
+  /// @brief Parse a document into a caller-owned result, replacing its
+  /// tokens.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param out Result to fill.
+  void Parse(const std::string& src, ParseEnv env,
+             ParseResult& out) {  // NOLINT(runtime/references)
+    out.Reset();
+    ParseInto(src, std::move(env), out, false, nullptr);
+  }
+
+  /// @brief Parse a single inline string into a caller-owned result,
+  /// replacing its tokens.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param out Result to fill.
+  void ParseInline(const std::string& src, ParseEnv env,
+                   ParseResult& out) {  // NOLINT(runtime/references)
+    out.Reset();
+    ParseInto(src, std::move(env), out, true, nullptr);
+  }
+
+  /// @brief Parse a document reusing the memory of a context.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param context Context of the calling thread.
+  /// @return The result held by `context`, valid until its next parse.
+  ParseResult& Parse(const std::string& src, ParseEnv env,
+                     ParseContext& context) {  // NOLINT(runtime/references)
+    ParseResult& result = context.Reset();
+    ParseInto(src, std::move(env), result, false, &context);
+    return result;
+  }
+
+  /// @brief Parse a single inline string reusing the memory of a context.
+  /// @param src Source text.
+  /// @param env Environment for the parser, moved into the result.
+  /// @param context Context of the calling thread.
+  /// @return The result held by `context`, valid until its next parse.
+  ParseResult& ParseInline(
+      const std::string& src, ParseEnv env,
+      ParseContext& context) {  // NOLINT(runtime/references)
+    ParseResult& result = context.Reset();
+    ParseInto(src, std::move(env), result, true, &context);
+    return result;
+  }
+
+ private:
+  // Runs the core chain over a copy of `src` held by the emptied `result`,
+  // which takes over `env`.
+  void ParseInto(const std::string& src, ParseEnv&& env,
+                 ParseResult& result,  // NOLINT(runtime/references)
+                 bool inline_mode, ParseContext* context) {
+    result.Source() = src;
+    result.Env() = std::move(env);
+    StateCore state(result.Source(), md_, result.Env(), result.Tokens());
+    state.inline_mode = inline_mode;
+    state.context = context;
+    Traits::Core::Process(state);
+  }
+
+  /// @brief Frozen at construction: nothing reaches its rulers afterwards.
+  Aethermark md_;
+};
+
+}  // namespace aethermark
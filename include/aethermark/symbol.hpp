@@ -0,0 +1,137 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <ostream>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace aethermark {
+
+/// @brief Thread-safe table of interned names.
+///
+/// Built-in names are supplied at construction and keep the ids given by their
+/// position; further names get the next free id when first interned. Names of
+/// built-in ids are resolved without locking.
+class SymbolTable {
+ public:
+  /// @brief Constructs a table pre-populated with built-in names.
+  /// @param builtins Names for ids `0 .. builtins.size() - 1`. Must outlive the
+  /// table.
+  explicit SymbolTable(std::span<const std::string_view> builtins);
+
+  SymbolTable(const SymbolTable&) = delete;
+  SymbolTable& operator=(const SymbolTable&) = delete;
+
+  /// @brief Get the id of a name, registering it if unknown.
+  /// @param name Name to intern.
+  /// @return Id of the name.
+  /// @exception `std::runtime_error` if the table is full.
+  std::uint16_t Intern(std::string_view name);
+
+  /// @brief Get the id of a name without registering it.
+  /// @param name Name to look up.
+  /// @return Id of the name, or `std::nullopt` if unknown.
+  std::optional<std::uint16_t> Find(std::string_view name) const;
+
+  /// @brief Get the name of an id.
+  /// @param id Id returned by `Intern` or a built-in id.
+  /// @return Name of the id, empty if the id is unknown.
+  std::string_view Name(std::uint16_t id) const;
+
+ private:
+  std::span<const std::string_view> builtins_;
+  mutable std::shared_mutex mutex_;
+  std::deque<std::string> names_;  ///< Runtime names, stable addresses.
+  std::unordered_map<std::string_view, std::uint16_t> ids_;
+};
+
+/// @brief Interned name: a 16-bit id standing for a string.
+///
+/// Symbols compare, hash and switch as integers. Built-in names are members of
+/// `Traits::Kind` and convert implicitly; other names are registered at
+/// runtime through `Register`.
+/// @tparam Traits Provides `Kind`, an enum of built-in names, and `Table()`,
+/// the `SymbolTable` holding them.
+template <typename Traits>
+class Symbol {
+ public:
+  /// @brief Enum of built-in names.
+  using Kind = typename Traits::Kind;
+
+  /// @brief Constructs the empty symbol (id 0).
+  constexpr Symbol() = default;
+
+  /// @brief Constructs a symbol for a built-in name.
+  /// @param kind The built-in name.
+  constexpr Symbol(Kind kind)  // NOLINT(runtime/explicit)
+      : id_(static_cast<std::uint16_t>(kind)) {}
+
+  /// @brief Constructs a symbol by interning a name.
+  /// @param name The name.
+  explicit Symbol(std::string_view name) : id_(Traits::Table().Intern(name)) {}
+
+  /// @brief Register a name, or get the symbol it already has.
+  /// @param name The name.
+  /// @return Symbol for the name.
+  static Symbol Register(std::string_view name) { return Symbol(name); }
+
+  /// @brief Look up a name without registering it.
+  /// @param name The name.
+  /// @return Symbol for the name, or `std::nullopt` if it is unknown.
+  static std::optional<Symbol> Find(std::string_view name) {
+    std::optional<std::uint16_t> id = Traits::Table().Find(name);
+    if (!id.has_value()) return std::nullopt;
+    return FromId(*id);
+  }
+
+  /// @brief Id of the symbol.
+  constexpr std::uint16_t Id() const { return id_; }
+
+  /// @brief Built-in name of the symbol, suitable for `switch`. Runtime
+  /// symbols yield values past the last enumerator.
+  constexpr Kind GetKind() const { return static_cast<Kind>(id_); }
+
+  /// @brief Name of the symbol.
+  std::string_view Name() const { return Traits::Table().Name(id_); }
+
+  /// @brief Whether this is the empty symbol.
+  constexpr bool empty() const { return id_ == 0; }
+
+  friend constexpr bool operator==(Symbol a, Symbol b) {
+    return a.id_ == b.id_;
+  }
+
+  friend bool operator==(Symbol a, std::string_view name) {
+    return a.Name() == name;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, Symbol s) {
+    return os << s.Name();
+  }
+
+ private:
+  static constexpr Symbol FromId(std::uint16_t id) {
+    Symbol s;
+    s.id_ = id;
+    return s;
+  }
+
+  std::uint16_t id_ = 0;
+};
+
+}  // namespace aethermark
+
+template <typename Traits>
+struct std::hash<aethermark::Symbol<Traits>> {
+  std::size_t operator()(aethermark::Symbol<Traits> s) const noexcept {
+    return s.Id();
+  }
+};
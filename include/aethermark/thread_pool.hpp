@@ -0,0 +1,95 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aethermark {
+
+/// @brief Fixed set of worker threads running index loops with work
+/// stealing.
+///
+/// `ParallelFor` splits the tasks into one contiguous range per participating
+/// thread, the caller included. A thread takes tasks from the front of its
+/// own range; once it is empty it steals the back half of another range. One
+/// loop runs at a time: a `ParallelFor` started while another is running
+/// runs its tasks on the calling thread instead of waiting.
+class ThreadPool {
+ public:
+  /// @brief Task function, called as `fn(task, slot)`. `slot` identifies the
+  /// thread running the task among the participants of the loop, from 0 (the
+  /// caller) to the slot count minus one, for per-thread scratch state.
+  using Task = std::function<void(std::size_t, std::size_t)>;
+
+  /// @brief Starts the workers.
+  /// @param workers Number of worker threads, not counting the callers.
+  explicit ThreadPool(std::size_t workers);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /// @brief Stops and joins the workers.
+  ~ThreadPool();
+
+  /// @brief Pool shared by the process, with one worker per core besides the
+  /// caller. Started on first use.
+  static ThreadPool& Shared();
+
+  /// @brief Number of worker threads.
+  std::size_t Workers() const { return workers_.size(); }
+
+  /// @brief Run `fn` for every task in `[0, count)` and wait for all of them.
+  /// @param count Number of tasks.
+  /// @param max_slots Most threads to use, the caller included; 0 for all.
+  /// @param fn Task function.
+  /// @return Number of slots used, so `slot` is below it.
+  /// @exception Rethrows the first exception thrown by a task, once every
+  /// running task has returned. Tasks not started by then are skipped.
+  std::size_t ParallelFor(std::size_t count, std::size_t max_slots,
+                          const Task& fn);
+
+ private:
+  // Remaining tasks of one participant, aligned to keep slots off each
+  // other's cache lines.
+  struct alignas(64) Range {
+    std::mutex mutex;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  void WorkerLoop(std::size_t slot);
+  void RunSlot(std::size_t slot);
+  bool NextTask(std::size_t slot, std::size_t* task);
+
+  std::vector<std::thread> workers_;
+  std::unique_ptr<Range[]> ranges_;
+
+  // Held for the whole of a `ParallelFor`.
+  std::mutex loop_mutex_;
+
+  // Guards the fields below and the two condition variables.
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  std::uint64_t generation_ = 0;
+  bool stop_ = false;
+  const Task* fn_ = nullptr;
+  std::size_t slots_ = 0;
+  std::size_t running_ = 0;
+  std::exception_ptr error_;
+
+  // Set once a task threw, so the others stop taking tasks.
+  std::atomic<bool> failed_ = false;
+};
+
+}  // namespace aethermark
@@ -4,25 +4,250 @@
 #pragma once
 
 #include <any>
-#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
 #include <optional>
+#include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#include "aethermark/token_type.hpp"
+
 namespace aethermark {
 
 /// @brief Represents the type of nesting type of a token.
-enum Nesting {
+enum Nesting : std::int8_t {
   kClosing = -1,     ///< Represents a closing token.
   kSelfClosing = 0,  ///< Represents a self-closing token.
   kOpening = 1,      ///< Represents an opening token.
 };
 
+class Token;
+
+/// @brief Allocator shared by a token and everything it owns.
+using TokenAllocator = std::pmr::polymorphic_allocator<std::byte>;
+
+/// @brief HTML attribute of a token, as a `( name, value )` pair.
+using TokenAttr = std::pair<AttrName, std::pmr::string>;
+
+/// @brief Half-open range `[begin, end)` of token indices into a
+/// `TokenList`.
+struct TokenRange {
+  std::uint32_t begin = 0;  ///< Index of the first token.
+  std::uint32_t end = 0;    ///< Index past the last token.
+
+  /// @brief Number of tokens in the range.
+  constexpr std::uint32_t size() const { return end - begin; }
+
+  /// @brief Whether the range holds no tokens.
+  constexpr bool empty() const { return begin == end; }
+
+  friend constexpr bool operator==(TokenRange, TokenRange) = default;
+};
+
+/// @brief Text of a token: either a view of the parse source or owned
+/// storage.
+///
+/// Text that is a contiguous slice of the (normalized) source is borrowed, so
+/// producing it costs no copy; the source buffer is kept alive by the
+/// `ParseResult` holding the token. Text that had to be assembled, e.g. after
+/// stripping indentation, is owned and allocated with the token allocator.
+class TokenString {
+ public:
+  /// @brief Allocator type, enables uses-allocator construction.
+  using allocator_type = TokenAllocator;
+
+  TokenString() = default;
+  TokenString(const TokenString&) = default;
+  TokenString(TokenString&&) noexcept = default;
+  TokenString& operator=(const TokenString&) = default;
+  TokenString& operator=(TokenString&&) noexcept = default;
+  ~TokenString() = default;
+
+  /// @brief Constructs empty text.
+  /// @param alloc Allocator for owned storage.
+  explicit TokenString(const allocator_type& alloc) : owned_(alloc) {}
+
+  /// @brief Allocator-extended copy constructor.
+  TokenString(const TokenString& other, const allocator_type& alloc);
+
+  /// @brief Allocator-extended move constructor.
+  TokenString(TokenString&& other, const allocator_type& alloc);
+
+  /// @brief Copy text into owned storage.
+  /// @param text Text to copy.
+  TokenString& operator=(std::string_view text);
+
+  /// @brief Copy text into owned storage.
+  /// @param text Text to copy.
+  TokenString& operator=(const char* text) {
+    return *this = std::string_view(text);
+  }
+
+  /// @brief Refer to text without copying it. The text must outlive the
+  /// token, which holds for slices of the parse source.
+  /// @param text Text to borrow.
+  void Borrow(std::string_view text);
+
+  /// @brief Take over already built owned text.
+  /// @param text Text to adopt, moved if it shares the allocator.
+  void Assign(std::pmr::string&& text);
+
+  /// @brief Append text, moving borrowed text into owned storage first.
+  /// @param text Text to append.
+  void Append(std::string_view text);
+
+  /// @brief The text.
+  std::string_view View() const {
+    return IsBorrowed() ? view_ : std::string_view(owned_);
+  }
+
+  operator std::string_view() const { return View(); }  // NOLINT
+
+  /// @brief Whether the text is a view of external storage.
+  bool IsBorrowed() const { return view_.data() != nullptr; }
+
+  bool empty() const { return View().empty(); }
+  std::size_t size() const { return View().size(); }
+
+  /// @brief Get the allocator used for owned storage.
+  allocator_type get_allocator() const { return owned_.get_allocator(); }
+
+  friend bool operator==(const TokenString& a, const TokenString& b) {
+    return a.View() == b.View();
+  }
+
+  friend bool operator==(const TokenString& a, std::string_view b) {
+    return a.View() == b;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const TokenString& s) {
+    return os << s.View();
+  }
+
+ private:
+  std::pmr::string owned_;
+  std::string_view view_;  ///< Null unless borrowed.
+};
+
+/// @brief Attribute list of a token, as a pointer to an array allocated
+/// with the list allocator.
+///
+/// Most tokens carry no attributes, so the list only takes three words in
+/// each token. The first attribute allocates room for `kInitialCapacity`,
+/// enough for links (`href`, `title`) and images (`src`, `alt`, `title`).
+/// Attribute values are allocated with the list allocator too.
+class TokenAttrs {
+ public:
+  /// @brief Allocator type, enables uses-allocator construction.
+  using allocator_type = TokenAllocator;
+  using value_type = TokenAttr;
+  using iterator = TokenAttr*;
+  using const_iterator = const TokenAttr*;
+
+  /// @brief Capacity allocated for the first attribute.
+  static constexpr std::size_t kInitialCapacity = 3;
+
+  TokenAttrs() = default;
+  ~TokenAttrs();
+
+  /// @brief Constructs an empty list.
+  /// @param alloc Allocator for values and overflow storage.
+  explicit TokenAttrs(const allocator_type& alloc) : alloc_(alloc) {}
+
+  /// @brief Copy constructor. Like standard containers, the copy uses the
+  /// default allocator.
+  TokenAttrs(const TokenAttrs& other) : TokenAttrs(other, allocator_type()) {}
+
+  /// @brief Move constructor. Keeps the allocator of `other`.
+  TokenAttrs(TokenAttrs&& other) noexcept;
+
+  /// @brief Allocator-extended copy constructor.
+  TokenAttrs(const TokenAttrs& other, const allocator_type& alloc);
+
+  /// @brief Allocator-extended move constructor.
+  TokenAttrs(TokenAttrs&& other, const allocator_type& alloc);
+
+  TokenAttrs& operator=(const TokenAttrs& other);
+  TokenAttrs& operator=(TokenAttrs&& other);
+
+  std::size_t size() const { return size_; }
+  std::size_t capacity() const { return capacity_; }
+  bool empty() const { return size_ == 0; }
+
+  TokenAttr* data() { return data_; }
+  const TokenAttr* data() const { return data_; }
+
+  iterator begin() { return data_; }
+  iterator end() { return data_ + size_; }
+  const_iterator begin() const { return data_; }
+  const_iterator end() const { return data_ + size_; }
+
+  TokenAttr& operator[](std::size_t i) { return data_[i]; }
+  const TokenAttr& operator[](std::size_t i) const { return data_[i]; }
+
+  /// @brief Attribute at an index, with bounds checking.
+  /// @exception `std::out_of_range` if `i` is not below `size()`.
+  TokenAttr& at(std::size_t i);
+
+  /// @brief Attribute at an index, with bounds checking (const version).
+  /// @exception `std::out_of_range` if `i` is not below `size()`.
+  const TokenAttr& at(std::size_t i) const;
+
+  TokenAttr& front() { return data_[0]; }
+  const TokenAttr& front() const { return data_[0]; }
+  TokenAttr& back() { return data_[size_ - 1]; }
+  const TokenAttr& back() const { return data_[size_ - 1]; }
+
+  /// @brief Get the allocator of the list.
+  allocator_type get_allocator() const { return alloc_; }
+
+  /// @brief Ensure room for `n` attributes.
+  void reserve(std::size_t n);
+
+  /// @brief Append an attribute.
+  /// @param name Name of the attribute.
+  /// @param value Value of the attribute.
+  /// @return Reference to the new attribute.
+  TokenAttr& emplace_back(AttrName name, std::string_view value);
+
+  /// @brief Append a copy of an attribute.
+  void push_back(const TokenAttr& attr) {
+    emplace_back(attr.first, attr.second);
+  }
+
+  /// @brief Remove all attributes, keeping the capacity.
+  void clear();
+
+ private:
+  /// @brief Take over the elements of `other`, leaving it empty.
+  void StealFrom(TokenAttrs& other);
+
+  /// @brief Destroy the elements and release overflow storage.
+  void Release();
+
+  allocator_type alloc_;
+  TokenAttr* data_ = nullptr;
+  std::uint32_t size_ = 0;
+  std::uint32_t capacity_ = 0;
+};
+
 /// @brief Represents a token in the Aethermark markdown flavor.
+///
+/// Tokens are allocator-aware: when emplaced into a `TokenList` they and all
+/// of their strings and attributes are allocated from the list's memory
+/// resource. Children are not owned by the token: they live in the same
+/// `TokenList` and the token only records their index range, so copying a
+/// token never copies a subtree.
 class Token {
  public:
+  /// @brief Allocator type, enables uses-allocator construction.
+  using allocator_type = TokenAllocator;
+
   Token() = default;
   Token(const Token&) = default;
   Token(Token&&) noexcept = default;
@@ -30,16 +255,45 @@ class Token {
   Token& operator=(Token&&) noexcept = default;
   ~Token() = default;
 
+  /// @brief Allocator-extended copy constructor.
+  /// @param other Token to copy.
+  /// @param alloc Allocator for the copy.
+  Token(const Token& other, const allocator_type& alloc);
+
+  /// @brief Allocator-extended move constructor.
+  /// @param other Token to move from.
+  /// @param alloc Allocator for the new token.
+  Token(Token&& other, const allocator_type& alloc);
+
   /// @brief Constructs a new Token.
   /// @param type Type of the token.
   /// @param tag Tag of the token.
   /// @param nesting Nesting type of the token.
-  Token(std::string type, std::string tag, Nesting nesting);
+  /// @param alloc Allocator for the token storage.
+  Token(TokenType type, TokenTag tag, Nesting nesting,
+        const allocator_type& alloc = {});
+
+  /// @brief Constructs a new Token, interning type and tag names.
+  /// @param type Name of the token type.
+  /// @param tag Name of the token tag.
+  /// @param nesting Nesting type of the token.
+  /// @param alloc Allocator for the token storage.
+  Token(std::string_view type, std::string_view tag, Nesting nesting,
+        const allocator_type& alloc = {});
+
+  /// @brief Get the allocator backing this token.
+  /// @return The token allocator.
+  allocator_type get_allocator() const { return content.get_allocator(); }
 
   /// @brief Get the attribute index by name.
   /// @param name Name of the attribute.
-  /// @return Index of the attribute.
-  int AttrIndex(const std::string& name);
+  /// @return Index of the attribute, or -1 if it does not exist.
+  int AttrIndex(AttrName name) const;
+
+  /// @brief Get the attribute index by name. Unknown names are not interned.
+  /// @param name Name of the attribute.
+  /// @return Index of the attribute, or -1 if it does not exist.
+  int AttrIndex(std::string_view name) const;
 
   /// @brief Push attributes to the token.
   /// @param attr_data Attribute data to be pushed. ( name, value ) pairs.
@@ -49,66 +303,94 @@ class Token {
   /// @brief Set an attribute to the token. Override old value if exists.
   /// @param name Name of attribute.
   /// @param value Value of attribute.
-  void AttrSet(const std::string& name, const std::string& value);
+  void AttrSet(AttrName name, std::string_view value);
+
+  /// @brief Set an attribute to the token, interning its name.
+  /// @param name Name of attribute.
+  /// @param value Value of attribute.
+  void AttrSet(std::string_view name, std::string_view value) {
+    AttrSet(AttrName(name), value);
+  }
 
   /// @brief Get the value of attribute by name, or null if it does not exist
   /// @param name Name of the attribute.
-  /// @return Value of the attribute or null.
-  std::optional<std::string> AttrGet(const std::string& name);
+  /// @return View of the value, valid until the attribute is modified, or
+  /// null.
+  std::optional<std::string_view> AttrGet(AttrName name) const;
+
+  /// @brief Get the value of attribute by name, or null if it does not exist.
+  /// Unknown names are not interned.
+  /// @param name Name of the attribute.
+  /// @return View of the value, valid until the attribute is modified, or
+  /// null.
+  std::optional<std::string_view> AttrGet(std::string_view name) const;
 
   /// @brief Join value to existing attribute via space.
   /// Or create new attribute if not exists. Useful to operate with token
   /// classes.
   /// @param name Name of the attribute.
   /// @param value Value of the attribute.
-  void AttrJoin(const std::string& name, const std::string& value);
-
-  /// @brief Type of the token, e.g. "paragraph_open".
-  std::string type;
+  void AttrJoin(AttrName name, std::string_view value);
 
-  /// @brief Tag of the token, e.g. "p".
-  std::string tag;
+  /// @brief Join value to existing attribute via space, interning its name.
+  /// @param name Name of the attribute.
+  /// @param value Value of the attribute.
+  void AttrJoin(std::string_view name, std::string_view value) {
+    AttrJoin(AttrName(name), value);
+  }
 
-  /// @brief HTML attributes. Format: `[ [ name1, value1 ], [ name2, value2 ]
-  /// ]`.
-  std::optional<std::vector<std::pair<std::string, std::string>>> attrs;
+  /// @brief Type of the token, e.g. `TokenKind::kParagraphOpen`.
+  TokenType type;
 
-  /// @brief Source map info. Format: `[ line_begin, line_end ]`
-  std::optional<std::pair<float, float>> map;
+  /// @brief Tag of the token, e.g. `HtmlTag::kP`.
+  TokenTag tag;
 
   /// @brief Level change in the token.
   Nesting nesting;
 
+  /// @brief True for block-level tokens, false for inline tokens.
+  /// Used in renderer to calculate line breaks.
+  bool block;
+
+  /// @brief If it's true, ignore this element when rendering. Used for tight
+  /// lists to hide paragraphs.
+  bool hidden;
+
+  /// @brief HTML attributes, empty and unallocated until the first one is
+  /// set. Format: `[ [ name1, value1 ], [ name2, value2 ] ]`.
+  TokenAttrs attrs;
+
+  /// @brief Source map info. Format: `[ line_begin, line_end ]`
+  std::optional<std::pair<float, float>> map;
+
   /// @brief Nesting level, the same as `state.level`.
   float level;
 
-  /// @brief An array of child nodes (inline and img tokens)
-  std::optional<std::deque<Token>> children;
+  /// @brief Child nodes (inline and img tokens), as an index range into the
+  /// `TokenList` holding this token. See `TokenList::Children`.
+  TokenRange children;
 
   /// @brief Contents of the tag. If it is a self-closing tag (code, html,
   /// fence, etc.)
-  std::string content;
+  TokenString content;
 
   /// @brief '*' or '_' for emphasis, fence string for fence, etc.
-  std::string markup;
+  std::pmr::string markup;
 
   /// @brief One of 3 things:
   /// - Info string for "fence" tokens
   /// - The value "auto" for autolink "link_open" and "link_close" tokens
   /// - The string value of the item marker for ordered-list "list_item_open"
   /// tokens
-  std::string info;
+  std::pmr::string info;
 
   /// @brief A place for plugins to store an arbitrary data.
   std::any meta;
-
-  /// @brief True for block-level tokens, false for inline tokens.
-  /// Used in renderer to calculate line breaks.
-  bool block;
-
-  /// @brief If it's true, ignore this element when rendering. Used for tight
-  /// lists to hide paragraphs.
-  bool hidden;
 };
 
+// Every token of a document pays for each byte, open, close and text tokens
+// included. Attributes are the only members kept out of line, as a pointer
+// in `TokenAttrs`; the small members share the first word.
+static_assert(sizeof(Token) <= 216, "keep tokens small");
+
 }  // namespace aethermark
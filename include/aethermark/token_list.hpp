@@ -0,0 +1,330 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "aethermark/token.hpp"
+
+namespace aethermark {
+
+/// @brief Allocator of the `TokenList` buffers. The arrays come from a buffer
+/// resource, while elements are constructed with the token allocator, so the
+/// strings a token owns still go to its arena.
+///
+/// A buffer that grows leaves its old storage behind in a monotonic arena;
+/// taken from the arena's upstream resource it is freed on every growth.
+/// @tparam T Element type.
+template <typename T>
+class TokenBufferAllocator {
+ public:
+  using value_type = T;
+
+  TokenBufferAllocator() = default;
+
+  /// @brief Constructs an allocator.
+  /// @param buffer Resource the arrays are allocated from.
+  /// @param elements Allocator the elements are constructed with.
+  TokenBufferAllocator(std::pmr::memory_resource* buffer,
+                       const TokenAllocator& elements)
+      : buffer_(buffer), elements_(elements) {}
+
+  template <typename U>
+  TokenBufferAllocator(const TokenBufferAllocator<U>& other)  // NOLINT
+      : buffer_(other.Buffer()), elements_(other.Elements()) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(buffer_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) {
+    buffer_->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    std::uninitialized_construct_using_allocator(p, elements_,
+                                                 std::forward<Args>(args)...);
+  }
+
+  /// @brief Copies use the default resource, as with `std::pmr` containers.
+  TokenBufferAllocator select_on_container_copy_construction() const {
+    return TokenBufferAllocator();
+  }
+
+  /// @brief Resource the arrays are allocated from.
+  std::pmr::memory_resource* Buffer() const { return buffer_; }
+
+  /// @brief Allocator the elements are constructed with.
+  const TokenAllocator& Elements() const { return elements_; }
+
+  template <typename U>
+  friend bool operator==(const TokenBufferAllocator& a,
+                         const TokenBufferAllocator<U>& b) {
+    return *a.Buffer() == *b.Buffer() && a.Elements() == b.Elements();
+  }
+
+ private:
+  std::pmr::memory_resource* buffer_ = std::pmr::get_default_resource();
+  TokenAllocator elements_;
+};
+
+/// @brief Flat token tree stored in one contiguous buffer.
+///
+/// Block-level (root) tokens and the children of inline tokens share a single
+/// array; a parent records its children as a `TokenRange` into it. Children of
+/// a parent are appended in one go between `BeginChildren` and `EndChildren`,
+/// normally after all root tokens, so traversal is a linear walk over memory
+/// and copying tokens never copies subtrees.
+///
+/// Rules that merge or replace children leave the dropped tokens in the
+/// buffer; `Compact` removes them, and the core parser runs it once all rules
+/// are done. The buffer itself is exposed with a vector-like interface, in
+/// storage order. `Roots`, `Children` and `Walk` give the tree view in
+/// document order. Like with `std::vector`, appending invalidates references
+/// to tokens; hold indices across appends.
+class TokenList {
+ public:
+  /// @brief Allocator type, enables uses-allocator construction.
+  using allocator_type = TokenAllocator;
+  using value_type = Token;
+  using Buffer = std::vector<Token, TokenBufferAllocator<Token>>;
+  using iterator = Buffer::iterator;
+  using const_iterator = Buffer::const_iterator;
+
+  /// @brief Sentinel index meaning "no token".
+  static constexpr std::size_t kNoParent = static_cast<std::size_t>(-1);
+
+  /// @brief Forward iterator over root tokens in document order.
+  /// @tparam Const Whether the iterator yields const tokens.
+  template <bool Const>
+  class RootIterator {
+   public:
+    using List = std::conditional_t<Const, const TokenList, TokenList>;
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Token;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<Const, const Token*, Token*>;
+    using reference = std::conditional_t<Const, const Token&, Token&>;
+
+    RootIterator() = default;
+    RootIterator(List* list, std::size_t run) : list_(list), run_(run) {
+      if (list_ != nullptr && run_ < list_->root_runs_.size()) {
+        index_ = list_->root_runs_[run_].begin;
+      }
+    }
+
+    reference operator*() const { return list_->tokens_[index_]; }
+    pointer operator->() const { return &list_->tokens_[index_]; }
+
+    /// @brief Buffer index of the current token.
+    std::size_t Index() const { return index_; }
+
+    RootIterator& operator++() {
+      if (++index_ >= list_->root_runs_[run_].end) {
+        ++run_;
+        index_ = run_ < list_->root_runs_.size()
+                     ? list_->root_runs_[run_].begin
+                     : 0;
+      }
+      return *this;
+    }
+
+    RootIterator operator++(int) {
+      RootIterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const RootIterator& a, const RootIterator& b) {
+      return a.run_ == b.run_ && a.index_ == b.index_;
+    }
+
+   private:
+    List* list_ = nullptr;
+    std::size_t run_ = 0;
+    std::uint32_t index_ = 0;
+  };
+
+  /// @brief Range of root tokens, usable in range-for.
+  /// @tparam Const Whether the range yields const tokens.
+  template <bool Const>
+  class RootRange {
+   public:
+    using List = typename RootIterator<Const>::List;
+
+    explicit RootRange(List* list) : list_(list) {}
+
+    RootIterator<Const> begin() const { return {list_, 0}; }
+    RootIterator<Const> end() const {
+      return {list_, list_->root_runs_.size()};
+    }
+
+   private:
+    List* list_;
+  };
+
+  TokenList() = default;
+  TokenList(const TokenList&) = default;
+  TokenList(TokenList&&) noexcept = default;
+  TokenList& operator=(const TokenList&) = default;
+  TokenList& operator=(TokenList&&) noexcept = default;
+  ~TokenList() = default;
+
+  /// @brief Constructs an empty list.
+  /// @param alloc Allocator for the tokens and what they own.
+  /// @param buffer Resource for the token array and bookkeeping; give the
+  /// upstream resource of a monotonic `alloc`.
+  explicit TokenList(
+      const allocator_type& alloc,
+      std::pmr::memory_resource* buffer = std::pmr::get_default_resource());
+
+  /// @brief Allocator-extended copy constructor. Children ranges stay valid;
+  /// the token array comes from the default resource.
+  TokenList(const TokenList& other, const allocator_type& alloc);
+
+  /// @brief Allocator-extended move constructor. The token array keeps its
+  /// resource.
+  TokenList(TokenList&& other, const allocator_type& alloc);
+
+  // ---- Flat buffer ----
+
+  std::size_t size() const { return tokens_.size(); }
+  bool empty() const { return tokens_.empty(); }
+  void reserve(std::size_t n) { tokens_.reserve(n); }
+  std::size_t capacity() const { return tokens_.capacity(); }
+
+  Token& operator[](std::size_t i) { return tokens_[i]; }
+  const Token& operator[](std::size_t i) const { return tokens_[i]; }
+  Token& front() { return tokens_.front(); }
+  const Token& front() const { return tokens_.front(); }
+  Token& back() { return tokens_.back(); }
+  const Token& back() const { return tokens_.back(); }
+
+  iterator begin() { return tokens_.begin(); }
+  iterator end() { return tokens_.end(); }
+  const_iterator begin() const { return tokens_.begin(); }
+  const_iterator end() const { return tokens_.end(); }
+
+  /// @brief Get the allocator of the tokens.
+  allocator_type get_allocator() const {
+    return tokens_.get_allocator().Elements();
+  }
+
+  /// @brief Resource the token array is allocated from.
+  std::pmr::memory_resource* BufferResource() const {
+    return tokens_.get_allocator().Buffer();
+  }
+
+  /// @brief Append a token constructed from `args`. Outside of
+  /// `BeginChildren`/`EndChildren` the token is a root.
+  /// @return Reference to the new token, valid until the next append.
+  template <typename... Args>
+  Token& emplace_back(Args&&... args) {
+    Token& token = tokens_.emplace_back(std::forward<Args>(args)...);
+    Appended();
+    return token;
+  }
+
+  /// @brief Append a copy of a token.
+  void push_back(const Token& token) { emplace_back(token); }
+
+  /// @brief Append a token.
+  void push_back(Token&& token) { emplace_back(std::move(token)); }
+
+  /// @brief Remove all tokens.
+  void clear();
+
+  // ---- Tree ----
+
+  /// @brief Root tokens in document order.
+  RootRange<false> Roots() { return RootRange<false>(this); }
+
+  /// @brief Root tokens in document order (const version).
+  RootRange<true> Roots() const { return RootRange<true>(this); }
+
+  /// @brief Runs of consecutive root tokens, in document order.
+  std::span<const TokenRange> RootRuns() const { return root_runs_; }
+
+  /// @brief Children of a token of this list.
+  std::span<Token> Children(const Token& parent) {
+    return std::span<Token>(tokens_).subspan(parent.children.begin,
+                                             parent.children.size());
+  }
+
+  /// @brief Children of a token of this list (const version).
+  std::span<const Token> Children(const Token& parent) const {
+    return std::span<const Token>(tokens_).subspan(parent.children.begin,
+                                                   parent.children.size());
+  }
+
+  /// @brief Start appending the children of a token. Tokens appended until
+  /// `EndChildren` become its children, replacing any previous ones.
+  /// @param parent Index of the parent token.
+  /// @exception `std::runtime_error` if children of another token are being
+  /// appended.
+  void BeginChildren(std::size_t parent);
+
+  /// @brief Finish appending children started with `BeginChildren`.
+  /// @exception `std::runtime_error` if no children are being appended.
+  void EndChildren();
+
+  /// @brief Shrink the children range of a token, dropping trailing children
+  /// from the tree. Used by rules that merge children in place.
+  /// @param parent Index of the parent token.
+  /// @param size New number of children, not above the current one.
+  void TruncateChildren(std::size_t parent, std::uint32_t size);
+
+  /// @brief Merge each run of adjacent `text` children of a token into its
+  /// first token, in place, and drop the rest. Borrowed slices following each
+  /// other in the source stay a view; other runs are copied once into a
+  /// buffer sized for the whole run.
+  /// @param parent Index of the parent token.
+  void JoinTextChildren(std::size_t parent);
+
+  /// @brief Remove the tokens no longer reachable from a root, e.g. children
+  /// dropped by `TruncateChildren`, and renumber the children ranges and root
+  /// runs. Relative order is kept. Does nothing if no token was dropped.
+  /// @exception `std::runtime_error` if children are being appended.
+  void Compact();
+
+  /// @brief Visit every token in document order, children right after their
+  /// parent.
+  /// @param visitor Called as `visitor(token, depth)`; roots have depth 0.
+  template <typename Visitor>
+  void Walk(Visitor&& visitor) const {
+    for (const Token& token : Roots()) WalkFrom(token, 0, visitor);
+  }
+
+ private:
+  template <typename Visitor>
+  void WalkFrom(const Token& token, int depth, Visitor& visitor) const {
+    visitor(token, depth);
+    for (const Token& child : Children(token)) {
+      WalkFrom(child, depth + 1, visitor);
+    }
+  }
+
+  void Appended();
+
+  Buffer tokens_;
+  std::vector<TokenRange, TokenBufferAllocator<TokenRange>> root_runs_;
+  std::size_t open_parent_ = kNoParent;
+  std::size_t dropped_ = 0;  ///< Tokens left unreachable since `Compact`.
+
+  /// @brief Scratch of `Compact`, new index of each token. Kept so a reused
+  /// list compacts without allocating.
+  std::vector<std::uint32_t, TokenBufferAllocator<std::uint32_t>>
+      compact_index_;
+};
+
+}  // namespace aethermark
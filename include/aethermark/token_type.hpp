@@ -0,0 +1,133 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+
+#include "aethermark/symbol.hpp"
+
+namespace aethermark {
+
+/// @brief Built-in token types. Plugins register further types at runtime.
+enum class TokenKind : std::uint16_t {
+  kNone,              ///< (no type)
+  kInline,            ///< "inline"
+  kText,              ///< "text"
+  kTextSpecial,       ///< "text_special"
+  kSoftbreak,         ///< "softbreak"
+  kHardbreak,         ///< "hardbreak"
+  kParagraphOpen,     ///< "paragraph_open"
+  kParagraphClose,    ///< "paragraph_close"
+  kBlockquoteOpen,    ///< "blockquote_open"
+  kBlockquoteClose,   ///< "blockquote_close"
+  kCodeBlock,         ///< "code_block"
+  kFence,             ///< "fence"
+  kHeadingOpen,       ///< "heading_open"
+  kHeadingClose,      ///< "heading_close"
+  kHr,                ///< "hr"
+  kHtmlBlock,         ///< "html_block"
+  kBulletListOpen,    ///< "bullet_list_open"
+  kBulletListClose,   ///< "bullet_list_close"
+  kOrderedListOpen,   ///< "ordered_list_open"
+  kOrderedListClose,  ///< "ordered_list_close"
+  kListItemOpen,      ///< "list_item_open"
+  kListItemClose,     ///< "list_item_close"
+  kTableOpen,         ///< "table_open"
+  kTableClose,        ///< "table_close"
+  kTheadOpen,         ///< "thead_open"
+  kTheadClose,        ///< "thead_close"
+  kTbodyOpen,         ///< "tbody_open"
+  kTbodyClose,        ///< "tbody_close"
+  kTrOpen,            ///< "tr_open"
+  kTrClose,           ///< "tr_close"
+  kThOpen,            ///< "th_open"
+  kThClose,           ///< "th_close"
+  kTdOpen,            ///< "td_open"
+  kTdClose,           ///< "td_close"
+  kCodeInline,        ///< "code_inline"
+  kEmOpen,            ///< "em_open"
+  kEmClose,           ///< "em_close"
+  kStrongOpen,        ///< "strong_open"
+  kStrongClose,       ///< "strong_close"
+  kSOpen,             ///< "s_open"
+  kSClose,            ///< "s_close"
+  kLinkOpen,          ///< "link_open"
+  kLinkClose,         ///< "link_close"
+  kImage,             ///< "image"
+  kHtmlInline,        ///< "html_inline"
+};
+
+/// @brief Built-in token tags. Plugins register further tags at runtime.
+enum class HtmlTag : std::uint16_t {
+  kNone,        ///< (no tag)
+  kP,           ///< "p"
+  kBlockquote,  ///< "blockquote"
+  kCode,        ///< "code"
+  kPre,         ///< "pre"
+  kH1,          ///< "h1"
+  kH2,          ///< "h2"
+  kH3,          ///< "h3"
+  kH4,          ///< "h4"
+  kH5,          ///< "h5"
+  kH6,          ///< "h6"
+  kHr,          ///< "hr"
+  kUl,          ///< "ul"
+  kOl,          ///< "ol"
+  kLi,          ///< "li"
+  kTable,       ///< "table"
+  kThead,       ///< "thead"
+  kTbody,       ///< "tbody"
+  kTr,          ///< "tr"
+  kTh,          ///< "th"
+  kTd,          ///< "td"
+  kEm,          ///< "em"
+  kStrong,      ///< "strong"
+  kS,           ///< "s"
+  kA,           ///< "a"
+  kImg,         ///< "img"
+  kBr,          ///< "br"
+};
+
+/// @brief Built-in attribute names, the ones set by core rules and renderers.
+/// Other names are registered at runtime.
+enum class AttrKind : std::uint16_t {
+  kNone,   ///< (no name)
+  kHref,   ///< "href"
+  kSrc,    ///< "src"
+  kAlt,    ///< "alt"
+  kTitle,  ///< "title"
+  kClass,  ///< "class"
+  kId,     ///< "id"
+  kStart,  ///< "start"
+  kStyle,  ///< "style"
+};
+
+/// @brief Symbol traits for token types.
+struct TokenTypeTraits {
+  using Kind = TokenKind;
+  static SymbolTable& Table();
+};
+
+/// @brief Symbol traits for token tags.
+struct TokenTagTraits {
+  using Kind = HtmlTag;
+  static SymbolTable& Table();
+};
+
+/// @brief Symbol traits for attribute names.
+struct AttrNameTraits {
+  using Kind = AttrKind;
+  static SymbolTable& Table();
+};
+
+/// @brief Interned token type, e.g. `TokenKind::kParagraphOpen`.
+using TokenType = Symbol<TokenTypeTraits>;
+
+/// @brief Interned token tag, e.g. `HtmlTag::kP`.
+using TokenTag = Symbol<TokenTagTraits>;
+
+/// @brief Interned attribute name, e.g. `AttrKind::kHref`.
+using AttrName = Symbol<AttrNameTraits>;
+
+}  // namespace aethermark
@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 
 namespace aethermark {
 
@@ -17,10 +19,57 @@ class Utils {
   /// @return String without leading or trailing whitespace.
   static std::string Trim(const std::string& s);
 
+  /// @brief Remove leading and trailing whitespace without copying.
+  /// @param s The given string.
+  /// @return View of `s` without leading or trailing whitespace.
+  static std::string_view TrimView(std::string_view s);
+
   /// @brief Whether a character is "space" or not.
   /// @param ch The given character
   /// @return `true` if "space".
   static bool IsSpace(int ch);
+
+  /// @brief Whether a code point is Unicode whitespace, as markdown-it's
+  /// `isWhiteSpace`.
+  /// @param ch The code point.
+  static bool IsWhiteSpace(char32_t ch);
+
+  /// @brief Whether a code point is ASCII punctuation.
+  /// @param ch The code point.
+  static bool IsMdAsciiPunct(char32_t ch);
+
+  /// @brief Whether a code point is Unicode punctuation or a symbol, i.e. of
+  /// a general category P* or S*, as markdown-it's `ucmicro.P || ucmicro.S`.
+  /// @param ch The code point.
+  static bool IsPunctChar(char32_t ch);
+
+  /// @brief Match an inline HTML tag, comment, processing instruction,
+  /// declaration or CDATA section at the start of a string, as CommonMark
+  /// defines them.
+  /// @param s The given string, starting with `<`.
+  /// @return Length of the match, 0 if there is none.
+  static std::size_t MatchHtmlTag(std::string_view s);
+
+  /// @brief Whether a character is whitespace inside a link label: space,
+  /// tab, line feed, carriage return, form feed or vertical tab.
+  /// @param c The character.
+  static constexpr bool IsLabelSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+           c == '\v';
+  }
+
+  /// @brief Normalize a link label for matching, as CommonMark: strip the
+  /// surrounding whitespace, collapse inner runs to one space and apply
+  /// Unicode full case folding.
+  /// @param label The label, without brackets.
+  /// @return The normalized label.
+  static std::string NormalizeReference(std::string_view label);
+
+  /// @brief Replace backslash escapes and character references by the
+  /// characters they stand for, as markdown-it's `unescapeAll`.
+  /// @param s The given string.
+  /// @return The unescaped string.
+  static std::string UnescapeAll(std::string_view s);
 };
 
 }  // namespace aethermark
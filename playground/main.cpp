@@ -3,7 +3,6 @@
 
 #include <algorithm>
 #include <any>
-#include <deque>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -15,11 +14,12 @@
 
 #include "aethermark/aethermark.hpp"
 #include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
 
 using TableRow = std::vector<std::string>;
 using TableData = std::vector<TableRow>;
 
-inline void Print(const std::deque<aethermark::Token>& tokens);
+inline void Print(const aethermark::TokenList& tokens);
 inline std::string Repeat(const std::string& str, size_t times);
 inline std::string Center(const std::string& s, size_t w);
 inline std::string Normalize(const std::string& s);
@@ -46,21 +46,24 @@ int main(int argc, char** argv) {
   }
 
   aethermark::Aethermark am("commonmark");
-  Print(am.Parse(input, {}));
+  aethermark::ParseResult result = am.Parse(input, {});
+  Print(result.Tokens());
   return 0;
 }
 
-inline void Print(const std::deque<aethermark::Token>& tokens) {
+inline void Print(const aethermark::TokenList& tokens) {
   TableData rows;
   TableRow headers = {"Index", "Type", "Content", "Tag", "Map", "Nesting"};
 
-  for (size_t i = 0; i < tokens.size(); ++i) {
-    const auto& token = tokens[i];
+  size_t index = 0;
+  tokens.Walk([&](const aethermark::Token& token, int depth) {
     TableRow row;
-    row.push_back(std::to_string(i));
-    row.push_back(token.type);
-    row.push_back(token.content.empty() ? "-" : Normalize(token.content));
-    row.push_back(token.tag);
+    row.push_back(std::to_string(index++));
+    row.push_back(Repeat("  ", depth) + std::string(token.type.Name()));
+    row.push_back(token.content.empty()
+                      ? "-"
+                      : Normalize(std::string(token.content)));
+    row.push_back(std::string(token.tag.Name()));
 
     if (token.map) {
       row.push_back("[" + std::to_string(token.map->first) + ", " +
@@ -86,7 +89,7 @@ inline void Print(const std::deque<aethermark::Token>& tokens) {
     }
     row.push_back(nesting);
     rows.push_back(row);
-  }
+  });
 
   if (rows.empty()) return;
 
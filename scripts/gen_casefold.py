@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+# Copyright 2025 Aethermark Contributors
+# All rights reserved.
+
+"""Generate src/casefold_table.inc, the Unicode full case folding table.
+
+Lists every non-ASCII code point whose full case folding (as Python's
+`str.casefold`) differs from itself, sorted by code point, with the folded
+text in UTF-8. ASCII is folded in code.
+
+Run from the repository root:
+
+    python3 scripts/gen_casefold.py > src/casefold_table.inc
+"""
+
+import unicodedata
+
+
+def literal_lines(pieces, indent="    ", width=80):
+    lines = []
+    line = indent + '"'
+    for piece in pieces:
+        if len(line) + len(piece) + 1 > width:
+            lines.append(line + '"')
+            line = indent + '"'
+        line += piece
+    lines.append(line + '"')
+    return lines
+
+
+def main():
+    folds = []
+    for code in range(0x80, 0x110000):
+        if 0xD800 <= code <= 0xDFFF:
+            continue
+        folded = chr(code).casefold()
+        if folded != chr(code):
+            # Normalizing twice must not change the key
+            assert folded.casefold() == folded
+            folds.append((code, folded.encode("utf-8")))
+
+    offsets = {}
+    data = b""
+    for _, folded in folds:
+        if folded not in offsets:
+            offsets[folded] = len(data)
+            data += folded
+
+    out = []
+    out.append("// Copyright 2025 Aethermark Contributors")
+    out.append("// All rights reserved.")
+    out.append("")
+    out.append("// Generated by scripts/gen_casefold.py, do not edit.")
+    out.append(f"// Unicode {unicodedata.unidata_version}.")
+    out.append("")
+    out.append("constexpr std::string_view kCaseFoldText =")
+    out.extend(literal_lines([f"\\x{b:02x}" for b in data]))
+    out[-1] += ";"
+    out.append("")
+    out.append(f"constexpr CaseFold kCaseFolds[{len(folds)}] = {{")
+    line = "   "
+    for code, folded in folds:
+        entry = f" {{0x{code:X}, {offsets[folded]}, {len(folded)}}},"
+        if len(line) + len(entry) > 80:
+            out.append(line)
+            line = "   "
+        line += entry
+    out.append(line)
+    out.append("};")
+
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
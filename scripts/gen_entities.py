@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+# Copyright 2025 Aethermark Contributors
+# All rights reserved.
+
+"""Generate src/entities_table.inc, the named HTML5 entity table.
+
+The table is a minimal perfect hash over the names terminated by `;` in the
+WHATWG list (as shipped in Python's `html.entities.html5`). Names are hashed
+into buckets; each bucket stores the seed that sends all of its names to free
+slots, so a lookup is two hashes and one string compare.
+
+Run from the repository root:
+
+    python3 scripts/gen_entities.py > src/entities_table.inc
+"""
+
+from html.entities import html5
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+MASK = 0xFFFFFFFF
+
+
+# Must match EntityHash in src/entities.cpp
+def entity_hash(name: bytes, seed: int) -> int:
+    h = FNV_BASIS ^ seed
+    for byte in name:
+        h ^= byte
+        h = (h * FNV_PRIME) & MASK
+    h ^= h >> 15
+    h = (h * 0x2C1B3C6D) & MASK
+    h ^= h >> 12
+    return h
+
+
+def build(names):
+    slots = len(names)
+    buckets = (slots + 3) // 4
+
+    members = [[] for _ in range(buckets)]
+    for name in names:
+        members[entity_hash(name, 0) % buckets].append(name)
+
+    seeds = [0] * buckets
+    table = [None] * slots
+    order = sorted(range(buckets), key=lambda b: -len(members[b]))
+    for bucket in order:
+        keys = members[bucket]
+        if not keys:
+            continue
+        for seed in range(1, 1 << 16):
+            picked = [entity_hash(key, seed) % slots for key in keys]
+            if len(set(picked)) == len(picked) and all(
+                    table[slot] is None for slot in picked):
+                break
+        else:
+            raise SystemExit(f"no seed for bucket {bucket}")
+        seeds[bucket] = seed
+        for key, slot in zip(keys, picked):
+            table[slot] = key
+    return seeds, table
+
+
+def literal_lines(pieces, indent="    ", width=80):
+    lines = []
+    line = indent + '"'
+    for piece in pieces:
+        if len(line) + len(piece) + 1 > width:
+            lines.append(line + '"')
+            line = indent + '"'
+        line += piece
+    lines.append(line + '"')
+    return lines
+
+
+def number_lines(values, indent="    ", width=80):
+    lines = []
+    line = indent
+    for value in values:
+        text = f"{value},"
+        if len(line) + len(text) + 1 > width:
+            lines.append(line.rstrip())
+            line = indent
+        line += text + " "
+    lines.append(line.rstrip())
+    return lines
+
+
+def main():
+    decoded = {
+        key[:-1].encode(): value.encode("utf-8")
+        for key, value in html5.items() if key.endswith(";")
+    }
+    names = sorted(decoded)
+    seeds, table = build(names)
+
+    name_offsets = {}
+    name_data = b""
+    for name in table:
+        name_offsets[name] = len(name_data)
+        name_data += name
+
+    value_offsets = {}
+    value_data = b""
+    for name in table:
+        value = decoded[name]
+        if value not in value_offsets:
+            value_offsets[value] = len(value_data)
+            value_data += value
+
+    out = []
+    out.append("// Copyright 2025 Aethermark Contributors")
+    out.append("// All rights reserved.")
+    out.append("")
+    out.append("// Generated by scripts/gen_entities.py, do not edit.")
+    out.append("")
+    out.append(f"constexpr std::size_t kEntitySlots = {len(table)};")
+    out.append(f"constexpr std::size_t kEntityBuckets = {len(seeds)};")
+    out.append("")
+    out.append("constexpr std::uint16_t kEntitySeeds[kEntityBuckets] = {")
+    out.extend(number_lines(seeds))
+    out.append("};")
+    out.append("")
+    out.append("constexpr std::string_view kEntityNames =")
+    out.extend(literal_lines([chr(b) for b in name_data]))
+    out[-1] += ";"
+    out.append("")
+    out.append("constexpr std::string_view kEntityValues =")
+    out.extend(literal_lines([f"\\x{b:02x}" for b in value_data]))
+    out[-1] += ";"
+    out.append("")
+    out.append("constexpr EntityEntry kEntityEntries[kEntitySlots] = {")
+    for name in table:
+        value = decoded[name]
+        out.append(f"    {{{name_offsets[name]}, {len(name)}, "
+                   f"{value_offsets[value]}, {len(value)}}},")
+    out.append("};")
+
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
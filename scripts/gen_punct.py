@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+# Copyright 2025 Aethermark Contributors
+# All rights reserved.
+
+"""Generate src/punct_table.inc, the Unicode punctuation table.
+
+Lists the non-ASCII code points of the general categories P* (punctuation)
+and S* (symbols) as sorted, disjoint ranges, the set markdown-it checks with
+`ucmicro.P || ucmicro.S` for emphasis flanking. ASCII is handled in code.
+
+Run from the repository root:
+
+    python3 scripts/gen_punct.py > src/punct_table.inc
+"""
+
+import unicodedata
+
+
+def main():
+    ranges = []
+    for code in range(0x80, 0x110000):
+        if unicodedata.category(chr(code))[0] not in "PS":
+            continue
+        if ranges and ranges[-1][1] == code - 1:
+            ranges[-1][1] = code
+        else:
+            ranges.append([code, code])
+
+    out = []
+    out.append("// Copyright 2025 Aethermark Contributors")
+    out.append("// All rights reserved.")
+    out.append("")
+    out.append("// Generated by scripts/gen_punct.py, do not edit.")
+    out.append(f"// Unicode {unicodedata.unidata_version}.")
+    out.append("")
+    out.append(f"constexpr CodeRange kPunctRanges[{len(ranges)}] = {{")
+    line = "   "
+    for first, last in ranges:
+        entry = f" {{0x{first:04X}, 0x{last:04X}}},"
+        if len(line) + len(entry) > 80:
+            out.append(line)
+            line = "   "
+        line += entry
+    out.append(line)
+    out.append("};")
+
+    print("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()
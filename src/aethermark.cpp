@@ -3,18 +3,25 @@
 
 #include "aethermark/aethermark.hpp"
 
-#include <deque>
+#include <cctype>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 // #include "aethermark/parser_block.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
 #include "aethermark/parser_core.hpp"
-// #include "aethermark/parser_inline.hpp"
+#include "aethermark/parser_inline.hpp"
 // #include "aethermark/renderer.hpp"
 #include "aethermark/ruler.hpp"
 #include "aethermark/token.hpp"
+#include "aethermark/utils.hpp"
 
 namespace aethermark {
 
@@ -94,19 +101,38 @@ const std::unordered_map<std::string, Preset> Aethermark::presets = {
                               .rules_2 = {"balance_pairs", "emphasis",
                                           "fragments_join"}}}}}};
 
+// Holds back publishing while several rulers change, so that parses see
+// either all of the changes or none of them.
+class Aethermark::RuleBatch {
+ public:
+  explicit RuleBatch(Aethermark& md) : md_(md) { md_.rule_batches_++; }
+  ~RuleBatch() {
+    if (--md_.rule_batches_ == 0) md_.PublishRules();
+  }
+
+  RuleBatch(const RuleBatch&) = delete;
+  RuleBatch& operator=(const RuleBatch&) = delete;
+
+ private:
+  Aethermark& md_;
+};
+
 Aethermark::Aethermark()
-    : /*inlineParser(),*/ block_parser(), core_parser() /* , renderer(),*/ {
+    : inline_parser(), block_parser(), core_parser() /* , renderer(),*/ {
+  WatchRulers();
   Configure("default");
 }
 
 Aethermark::Aethermark(const Options& opts)
-    : /*inlineParser(),*/ block_parser(), core_parser() /*, renderer(), */ {
+    : inline_parser(), block_parser(), core_parser() /*, renderer(), */ {
+  WatchRulers();
   Configure("default");
   Set(opts);
 }
 
 Aethermark::Aethermark(std::string preset_name, std::optional<Options> options)
-    : /*inlineParser(),*/ block_parser(), core_parser() /*, renderer(), */ {
+    : inline_parser(), block_parser(), core_parser() /*, renderer(), */ {
+  WatchRulers();
   Configure(preset_name);
 
   if (options.has_value()) {
@@ -134,113 +160,136 @@ Aethermark& Aethermark::Configure(const std::string& preset_name) {
 Aethermark& Aethermark::Configure(const Preset& preset) {
   Set(preset.options);
 
+  RuleBatch batch(*this);
+
   core_parser.ruler.EnableOnly(preset.components.core_config.rules);
   block_parser.ruler.EnableOnly(preset.components.block_config.rules);
-  // inline_parser.ruler.EnableOnly(preset.components.inline_config.rules_1);
-  // inline_parser.rule2.EnableOnly(preset.components.inline_config.rules_2);
+  inline_parser.ruler.EnableOnly(preset.components.inline_config.rules_1);
+  inline_parser.ruler2.EnableOnly(preset.components.inline_config.rules_2);
 
   return *this;
 }
 
-// Aethermark& Aethermark::Enable(const std::vector<std::string>& list,
-//                                bool ignoreInvalid) {
-//   std::vector<std::string> enabled;
-//
-//   for (auto* chain :
-//        {&core_parser.ruler, &block_parser.ruler /*, &inline_parser.ruler*/})
-//        {
-//     auto r = chain->enable(list, true);
-//     enabled.insert(enabled.end(), r.begin(), r.end());
-//   }
-//
-//   // inline ruler2
-//   // if (inline_parser.ruler2.has_value()) {
-//   //   auto r2 = inline_parser.ruler2->enable(list, true);
-//   //   enabled.insert(enabled.end(), r2.begin(), r2.end());
-//   // }
-//
-//   for (const auto& name : list) {
-//     if (std::find(enabled.begin(), enabled.end(), name) == enabled.end()) {
-//       if (!ignoreInvalid) {
-//         throw std::runtime_error("Unknown rule: " + name);
-//       }
-//     }
-//   }
-//   return *this;
-// }
-//
-// Aethermark& Aethermark::disable(const std::vector<std::string>& list,
-//                                 bool ignoreInvalid) {
-//   std::vector<std::string> disabled;
-//
-//   for (auto* chain :
-//        {&coreParser.ruler, &blockParser.ruler, &inlineParser.ruler}) {
-//     auto r = chain->disable(list, true);
-//     disabled.insert(disabled.end(), r.begin(), r.end());
-//   }
-//
-//   if (inlineParser.ruler2.has_value()) {
-//     auto r2 = inlineParser.ruler2->disable(list, true);
-//     disabled.insert(disabled.end(), r2.begin(), r2.end());
-//   }
-//
-//   for (const auto& name : list) {
-//     if (std::find(disabled.begin(), disabled.end(), name) == disabled.end())
-//     {
-//       if (!ignoreInvalid) {
-//         throw std::runtime_error("Unknown rule: " + name);
-//       }
-//     }
-//   }
-//   return *this;
-// }
+// Throws for names that no ruler knows. Runs before any change so that
+// a failing call leaves the configuration untouched.
+static void CheckRuleNames(const Aethermark& md,
+                           const std::vector<std::string>& list) {
+  for (const std::string& name : list) {
+    if (md.core_parser.ruler.FindRule(name) == nullptr &&
+        md.block_parser.ruler.FindRule(name) == nullptr &&
+        md.inline_parser.ruler.FindRule(name) == nullptr &&
+        md.inline_parser.ruler2.FindRule(name) == nullptr) {
+      throw std::runtime_error("Unknown rule: " + name);
+    }
+  }
+}
+
+Aethermark& Aethermark::Enable(const std::vector<std::string>& list,
+                               bool ignore_invalid) {
+  if (!ignore_invalid) CheckRuleNames(*this, list);
 
-std::deque<Token> Aethermark::Parse(const std::string& src, std::any env) {
-  StateCore state(src, *this, env);
-  core_parser.Process(state);
-  return state.tokens;
+  RuleBatch batch(*this);
+  core_parser.ruler.Enable(list, true);
+  block_parser.ruler.Enable(list, true);
+  inline_parser.ruler.Enable(list, true);
+  inline_parser.ruler2.Enable(list, true);
+  return *this;
+}
+
+Aethermark& Aethermark::Disable(const std::vector<std::string>& list,
+                                bool ignore_invalid) {
+  if (!ignore_invalid) CheckRuleNames(*this, list);
+
+  RuleBatch batch(*this);
+  core_parser.ruler.Disable(list, true);
+  block_parser.ruler.Disable(list, true);
+  inline_parser.ruler.Disable(list, true);
+  inline_parser.ruler2.Disable(list, true);
+  return *this;
 }
 
-std::deque<Token> Aethermark::ParseInline(const std::string& src,
-                                          std::any env) {
-  StateCore state(src, *this, env);
-  state.inline_mode = true;
-  core_parser.Process(state);
-  return state.tokens;
+// Runs the core chain over a copy of `src` held by the emptied `result`,
+// which takes over `env`.
+static void ParseInto(Aethermark& md, const std::string& src, ParseEnv&& env,
+                      ParseResult& result, bool inline_mode,
+                      ParseContext* context) {
+  result.Source() = src;
+  result.Env() = std::move(env);
+  StateCore state(result.Source(), md, result.Env(), result.Tokens());
+  state.inline_mode = inline_mode;
+  state.context = context;
+  md.core_parser.Process(state);
 }
 
-// std::string Aethermark::render(const std::string& src, std::any env) {
+ParseResult Aethermark::Parse(const std::string& src, ParseEnv env) {
+  ParseResult result(src.size());
+  ParseInto(*this, src, std::move(env), result, false, nullptr);
+  return result;
+}
+
+ParseResult Aethermark::ParseInline(const std::string& src, ParseEnv env) {
+  ParseResult result(src.size());
+  ParseInto(*this, src, std::move(env), result, true, nullptr);
+  return result;
+}
+
+void Aethermark::Parse(const std::string& src, ParseEnv env,
+                       ParseResult& out) {
+  out.Reset();
+  ParseInto(*this, src, std::move(env), out, false, nullptr);
+}
+
+void Aethermark::ParseInline(const std::string& src, ParseEnv env,
+                             ParseResult& out) {
+  out.Reset();
+  ParseInto(*this, src, std::move(env), out, true, nullptr);
+}
+
+ParseResult& Aethermark::Parse(const std::string& src, ParseEnv env,
+                               ParseContext& context) {
+  ParseResult& result = context.Reset();
+  ParseInto(*this, src, std::move(env), result, false, &context);
+  return result;
+}
+
+ParseResult& Aethermark::ParseInline(const std::string& src, ParseEnv env,
+                                     ParseContext& context) {
+  ParseResult& result = context.Reset();
+  ParseInto(*this, src, std::move(env), result, true, &context);
+  return result;
+}
+
+// std::string Aethermark::render(const std::string& src, ParseEnv env) {
 //   auto tokens = parse(src, env);
 //   return renderer.render(tokens, options, env);
 // }
 
-// std::string Aethermark::renderInline(const std::string& src, std::any env) {
+// std::string Aethermark::renderInline(const std::string& src, ParseEnv env) {
 //   auto tokens = parseInline(src, env);
 //   return renderer.render(tokens, options, env);
 // }
 
-// bool Aethermark::validateLink(const std::string& url) const {
-//   // Basic match to Markdown-It’s behavior
-//   std::string lower;
-//   lower.reserve(url.size());
-//   for (char c : url) lower.push_back(std::tolower(c));
-
-//   if (lower.starts_with("javascript:") || lower.starts_with("vbscript:") ||
-//       lower.starts_with("file:")) {
-//     return false;
-//   }
-
-//   if (lower.starts_with("data:")) {
-//     if (lower.starts_with("data:image/gif") ||
-//         lower.starts_with("data:image/png") ||
-//         lower.starts_with("data:image/jpeg") ||
-//         lower.starts_with("data:image/webp")) {
-//       return true;
-//     }
-//     return false;
-//   }
-//   return true;
-// }
+bool Aethermark::ValidateLink(const std::string& url) const {
+  // Same check as markdown-it: script and file urls are refused, data urls
+  // only for a few image types
+  std::string lower(Utils::TrimView(url));
+  for (char& c : lower) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+
+  if (lower.starts_with("javascript:") || lower.starts_with("vbscript:") ||
+      lower.starts_with("file:")) {
+    return false;
+  }
+
+  if (lower.starts_with("data:")) {
+    return lower.starts_with("data:image/gif;") ||
+           lower.starts_with("data:image/png;") ||
+           lower.starts_with("data:image/jpeg;") ||
+           lower.starts_with("data:image/webp;");
+  }
+  return true;
+}
 
 std::string Aethermark::NormalizeLink(const std::string& url) const {
   // TODO(MukulWaval): add proper mdurl + punycode equivalent
@@ -253,8 +302,33 @@ std::string Aethermark::NormalizeLinkText(const std::string& url) const {
 }
 
 Aethermark& Aethermark::Use(std::function<void(Aethermark&)> plugin) {
+  RuleBatch batch(*this);
   plugin(*this);
   return *this;
 }
 
+void Aethermark::WatchRulers() {
+  auto publish = [this] {
+    if (rule_batches_ == 0) PublishRules();
+  };
+  core_parser.ruler.OnPublish(publish);
+  block_parser.ruler.OnPublish(publish);
+  inline_parser.ruler.OnPublish(publish);
+  inline_parser.ruler2.OnPublish(publish);
+  PublishRules();
+}
+
+void Aethermark::PublishRules() {
+  auto rules = std::make_shared<ParserRules>();
+  rules->core_rules = core_parser.ruler.Snapshot();
+  rules->block_rules = block_parser.ruler.Snapshot();
+  rules->inline_rules = inline_parser.ruler.Snapshot();
+  rules->inline_rules2 = inline_parser.ruler2.Snapshot();
+  std::shared_ptr<const ParserRules> next = std::move(rules);
+  {
+    std::lock_guard<std::mutex> lock(rules_mutex_);
+    rules_.swap(next);
+  }
+}
+
 }  // namespace aethermark
@@ -0,0 +1,170 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/entities.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace aethermark {
+
+namespace {
+
+// One named reference: offsets and sizes in kEntityNames and kEntityValues
+struct EntityEntry {
+  std::uint16_t name;
+  std::uint8_t name_size;
+  std::uint16_t value;
+  std::uint8_t value_size;
+};
+
+#include "entities_table.inc"
+
+// FNV-1a with a finalizer; must match entity_hash in the generator
+constexpr std::uint32_t EntityHash(std::string_view s, std::uint32_t seed) {
+  std::uint32_t h = 2166136261u ^ seed;
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 16777619u;
+  }
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return h;
+}
+
+constexpr std::string_view FindNamed(std::string_view name) {
+  if (name.size() < 2 || name.size() > 32) return {};
+
+  const std::uint32_t seed = kEntitySeeds[EntityHash(name, 0) % kEntityBuckets];
+  const EntityEntry& entry =
+      kEntityEntries[EntityHash(name, seed) % kEntitySlots];
+  if (kEntityNames.substr(entry.name, entry.name_size) != name) return {};
+  return kEntityValues.substr(entry.value, entry.value_size);
+}
+
+// Every name hashes back to its own slot
+constexpr bool TableIsPerfect() {
+  for (const EntityEntry& entry : kEntityEntries) {
+    const std::string_view name =
+        kEntityNames.substr(entry.name, entry.name_size);
+    if (FindNamed(name).data() != kEntityValues.data() + entry.value) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(TableIsPerfect());
+static_assert(FindNamed("amp") == "&");
+static_assert(FindNamed("nbsp") == "\xc2\xa0");
+static_assert(FindNamed("ampx").empty());
+
+bool IsAsciiAlpha(char c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+
+bool IsAsciiDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Value of a hex digit, -1 for other characters
+int HexValue(char c) {
+  if (IsAsciiDigit(c)) return c - '0';
+  const char lower = static_cast<char>(c | 0x20);
+  if (lower >= 'a' && lower <= 'f') return lower - 'a' + 10;
+  return -1;
+}
+
+}  // namespace
+
+std::string_view Entities::Named(std::string_view name) {
+  return FindNamed(name);
+}
+
+bool Entities::IsValidCode(char32_t code) {
+  // Broken sequence
+  if (code >= 0xD800 && code <= 0xDFFF) return false;
+  // Never used
+  if (code >= 0xFDD0 && code <= 0xFDEF) return false;
+  if ((code & 0xFFFF) == 0xFFFF || (code & 0xFFFF) == 0xFFFE) return false;
+  // Control codes
+  if (code <= 0x08) return false;
+  if (code == 0x0B) return false;
+  if (code >= 0x0E && code <= 0x1F) return false;
+  if (code >= 0x7F && code <= 0x9F) return false;
+  // Out of range
+  if (code > 0x10FFFF) return false;
+  return true;
+}
+
+std::size_t Entities::EncodeUtf8(char32_t code, char* out) {
+  if (code < 0x80) {
+    out[0] = static_cast<char>(code);
+    return 1;
+  }
+  if (code < 0x800) {
+    out[0] = static_cast<char>(0xC0 | (code >> 6));
+    out[1] = static_cast<char>(0x80 | (code & 0x3F));
+    return 2;
+  }
+  if (code < 0x10000) {
+    out[0] = static_cast<char>(0xE0 | (code >> 12));
+    out[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out[2] = static_cast<char>(0x80 | (code & 0x3F));
+    return 3;
+  }
+  out[0] = static_cast<char>(0xF0 | (code >> 18));
+  out[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+  out[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+  out[3] = static_cast<char>(0x80 | (code & 0x3F));
+  return 4;
+}
+
+Entities::Match Entities::Decode(std::string_view s) {
+  Match match;
+  if (s.size() < 3 || s[0] != '&') return match;
+
+  std::size_t pos = 1;
+
+  if (s[pos] == '#') {
+    // ^&#((?:x[a-f0-9]{1,6}|[0-9]{1,7}));
+    pos++;
+    char32_t code = 0;
+    std::size_t digits = 0;
+    if (pos < s.size() && (s[pos] | 0x20) == 'x') {
+      pos++;
+      while (pos < s.size() && digits < 6 && HexValue(s[pos]) >= 0) {
+        code = code * 16 + static_cast<char32_t>(HexValue(s[pos]));
+        pos++;
+        digits++;
+      }
+    } else {
+      while (pos < s.size() && digits < 7 && IsAsciiDigit(s[pos])) {
+        code = code * 10 + static_cast<char32_t>(s[pos] - '0');
+        pos++;
+        digits++;
+      }
+    }
+    if (digits == 0 || pos >= s.size() || s[pos] != ';') return match;
+
+    match.size = EncodeUtf8(IsValidCode(code) ? code : 0xFFFD, match.text);
+    match.length = pos + 1;
+    return match;
+  }
+
+  // ^&([a-z][a-z0-9]{1,31});
+  if (!IsAsciiAlpha(s[pos])) return match;
+  const std::size_t end = std::min(s.size(), pos + 33);
+  pos++;
+  while (pos < end && (IsAsciiAlpha(s[pos]) || IsAsciiDigit(s[pos]))) pos++;
+  if (pos >= end || s[pos] != ';') return match;
+
+  const std::string_view decoded = FindNamed(s.substr(1, pos - 1));
+  if (decoded.empty()) return match;
+
+  decoded.copy(match.text, decoded.size());
+  match.size = decoded.size();
+  match.length = pos + 1;
+  return match;
+}
+
+}  // namespace aethermark
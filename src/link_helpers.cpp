@@ -0,0 +1,161 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/link_helpers.hpp"
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/utils.hpp"
+
+namespace aethermark {
+
+std::size_t LinkHelpers::ParseLinkLabel(StateInline& state, std::size_t start,
+                                        bool disable_nested) {
+  const std::size_t max = state.pos_max;
+  const std::size_t old_pos = state.pos;
+  bool found = false;
+
+  state.pos = start + 1;
+  int level = 1;
+
+  while (state.pos < max) {
+    const char marker = state.src[state.pos];
+    if (marker == ']') {
+      level--;
+      if (level == 0) {
+        found = true;
+        break;
+      }
+    }
+
+    const std::size_t prev_pos = state.pos;
+    state.md.inline_parser.SkipToken(state);
+    if (marker == '[') {
+      if (prev_pos == state.pos - 1) {
+        // increase level if we find text `[`, which is not a part of any
+        // token
+        level++;
+      } else if (disable_nested) {
+        state.pos = old_pos;
+        return std::string_view::npos;
+      }
+    }
+  }
+
+  const std::size_t label_end = found ? state.pos : std::string_view::npos;
+
+  // restore old state
+  state.pos = old_pos;
+  return label_end;
+}
+
+LinkDestination LinkHelpers::ParseLinkDestination(std::string_view str,
+                                                  std::size_t start,
+                                                  std::size_t max) {
+  LinkDestination result;
+  std::size_t pos = start;
+
+  if (pos < max && str[pos] == '<') {
+    pos++;
+    while (pos < max) {
+      const char c = str[pos];
+      if (c == '\n' || c == '<') return result;
+      if (c == '>') {
+        result.pos = pos + 1;
+        result.str = Utils::UnescapeAll(str.substr(start + 1, pos - start - 1));
+        result.ok = true;
+        return result;
+      }
+      if (c == '\\' && pos + 1 < max) {
+        pos += 2;
+        continue;
+      }
+      pos++;
+    }
+
+    // no closing '>'
+    return result;
+  }
+
+  int level = 0;
+  while (pos < max) {
+    const auto c = static_cast<unsigned char>(str[pos]);
+    if (c == ' ') break;
+
+    // ascii control characters
+    if (c < 0x20 || c == 0x7F) break;
+
+    if (c == '\\' && pos + 1 < max) {
+      if (str[pos + 1] == ' ') break;
+      pos += 2;
+      continue;
+    }
+
+    if (c == '(') {
+      level++;
+      if (level > 32) return result;
+    }
+
+    if (c == ')') {
+      if (level == 0) break;
+      level--;
+    }
+
+    pos++;
+  }
+
+  if (start == pos || level != 0) return result;
+
+  result.str = Utils::UnescapeAll(str.substr(start, pos - start));
+  result.pos = pos;
+  result.ok = true;
+  return result;
+}
+
+LinkTitle LinkHelpers::ParseLinkTitle(std::string_view str, std::size_t start,
+                                      std::size_t max, const LinkTitle* prev) {
+  LinkTitle result;
+  std::size_t pos = start;
+
+  if (prev != nullptr) {
+    // continuation of the title on the next line, for references only
+    result.str = prev->str;
+    result.marker = prev->marker;
+  } else {
+    if (pos >= max) return result;
+
+    const char marker = str[pos];
+    if (marker != '"' && marker != '\'' && marker != '(') return result;
+
+    start++;
+    pos++;
+
+    // if opening marker is "(", switch it to closing marker ")"
+    result.marker = marker == '(' ? ')' : marker;
+  }
+
+  while (pos < max) {
+    const char c = str[pos];
+    if (c == result.marker) {
+      result.pos = pos + 1;
+      result.str += Utils::UnescapeAll(str.substr(start, pos - start));
+      result.ok = true;
+      return result;
+    } else if (c == '(' && result.marker == ')') {
+      return result;
+    } else if (c == '\\' && pos + 1 < max) {
+      pos++;
+    }
+    pos++;
+  }
+
+  // no closing marker found, but the title may continue on the next line
+  result.can_continue = true;
+  result.str += Utils::UnescapeAll(str.substr(start, pos - start));
+  return result;
+}
+
+}  // namespace aethermark
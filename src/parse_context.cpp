@@ -0,0 +1,81 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/parse_context.hpp"
+
+#include <bit>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "aethermark/parse_result.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace aethermark {
+
+BlockCache::BlockCache(std::pmr::memory_resource* upstream)
+    : upstream_(upstream) {}
+
+BlockCache::~BlockCache() { Release(); }
+
+void BlockCache::Release() {
+  for (const Block& block : free_) {
+    upstream_->deallocate(block.p, block.bytes, block.alignment);
+  }
+  free_.clear();
+}
+
+std::size_t BlockCache::CachedBytes() const {
+  std::size_t bytes = 0;
+  for (const Block& block : free_) bytes += block.bytes;
+  return bytes;
+}
+
+void* BlockCache::do_allocate(std::size_t bytes, std::size_t alignment) {
+  bytes = std::bit_ceil(bytes);
+
+  // few blocks are cached at a time, a linear search is enough
+  for (std::size_t i = 0; i < free_.size(); i++) {
+    if (free_[i].bytes == bytes && free_[i].alignment == alignment) {
+      void* p = free_[i].p;
+      free_[i] = free_.back();
+      free_.pop_back();
+      return p;
+    }
+  }
+  return upstream_->allocate(bytes, alignment);
+}
+
+void BlockCache::do_deallocate(void* p, std::size_t bytes,
+                               std::size_t alignment) {
+  bytes = std::bit_ceil(bytes);
+  if (free_.size() >= kMaxCachedBlocks) {
+    upstream_->deallocate(p, bytes, alignment);
+    return;
+  }
+  free_.push_back(Block{p, bytes, alignment});
+}
+
+ParseContext::ParseContext()
+    : blocks_(), result_(0, &blocks_, std::pmr::get_default_resource()) {}
+
+ParseResult& ParseContext::Reset() {
+  result_.Reset();
+  return result_;
+}
+
+void ParseContext::Trim() {
+  result_.Reset();
+  // the token array and its bookkeeping live outside the arena, and keep
+  // their capacity through Reset
+  TokenList& tokens = result_.Tokens();
+  tokens = TokenList(tokens.get_allocator(), tokens.BufferResource());
+  result_.Source().shrink_to_fit();
+  blocks_.Release();
+  lines_ = std::vector<LineInfo>();
+  line_undo_ = std::vector<SavedLine>();
+}
+
+}  // namespace aethermark
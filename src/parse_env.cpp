@@ -0,0 +1,180 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/parse_env.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "aethermark/utils.hpp"
+
+namespace aethermark {
+
+namespace {
+
+// Class of each byte for IsNormalizedAscii: bit 0 for a space, bit 1 for
+// characters normalization changes (uppercase letters, other whitespace)
+constexpr std::array<std::uint8_t, 256> kLabelClass = [] {
+  std::array<std::uint8_t, 256> table{};
+  for (int c = 0; c < 256; c++) {
+    if (c >= 'A' && c <= 'Z') table[c] = 2;
+    if (Utils::IsLabelSpace(static_cast<char>(c))) {
+      table[c] = c == ' ' ? 1 : 2;
+    }
+  }
+  return table;
+}();
+
+// Whether ASCII normalization leaves a label unchanged: no outer or
+// repeated whitespace, no whitespace but spaces and no uppercase letter
+bool IsNormalizedAscii(std::string_view s) {
+  if (s.empty()) return true;
+
+  unsigned changed = kLabelClass[static_cast<unsigned char>(s.front())] |
+                     kLabelClass[static_cast<unsigned char>(s.back())];
+  unsigned prev = 0;
+  for (char c : s) {
+    const unsigned k = kLabelClass[static_cast<unsigned char>(c)];
+    changed |= k & (2 | prev);
+    prev = k & 1;
+  }
+  return changed == 0;
+}
+
+// ASCII normalization of a label, as `Utils::NormalizeReference` without
+// the Unicode case folding. Kept on the stack unless the label is longer
+// than any sane one.
+class AsciiLabel {
+ public:
+  explicit AsciiLabel(std::string_view label) {
+    if (IsNormalizedAscii(label)) {
+      view_ = label;
+      return;
+    }
+
+    char* out = buffer_;
+    if (label.size() > sizeof(buffer_)) {
+      large_.resize(label.size());
+      out = large_.data();
+    }
+
+    std::size_t size = 0;
+    bool space = false;
+    for (const char c : label) {
+      if (Utils::IsLabelSpace(c)) {
+        space = size != 0;
+        continue;
+      }
+      if (space) {
+        out[size++] = ' ';
+        space = false;
+      }
+      out[size++] = c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+    }
+    view_ = std::string_view(out, size);
+  }
+
+  AsciiLabel(const AsciiLabel&) = delete;
+  AsciiLabel& operator=(const AsciiLabel&) = delete;
+
+  std::string_view View() const { return view_; }
+
+ private:
+  char buffer_[256];
+  std::string large_;
+  std::string_view view_;
+};
+
+bool IsAscii(std::string_view s) {
+  for (char c : s) {
+    if (static_cast<unsigned char>(c) >= 0x80) return false;
+  }
+  return true;
+}
+
+const LinkReference* Find(const ReferenceMap& map, std::string_view label) {
+  auto it = map.find(label);
+  return it == map.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+std::size_t LabelHash::operator()(std::string_view label) const {
+  if (IsNormalizedAscii(label)) return std::hash<std::string_view>{}(label);
+  return std::hash<std::string_view>{}(AsciiLabel(label).View());
+}
+
+bool LabelEqual::operator()(std::string_view a, std::string_view b) const {
+  // Stored keys are normalized, so a match is usually byte for byte
+  if (a == b) return true;
+  return AsciiLabel(a).View() == AsciiLabel(b).View();
+}
+
+const LinkReference* ParseEnv::FindReference(std::string_view label) const {
+  // Non-ASCII labels need Unicode case folding first
+  std::string folded;
+  if (!IsAscii(label)) {
+    folded = Utils::NormalizeReference(label);
+    label = folded;
+  }
+
+  // Normalized once here, so the map compares the keys as they are
+  const AsciiLabel key(label);
+  if (const LinkReference* ref = Find(references, key.View())) return ref;
+  if (shared_references) return Find(*shared_references, key.View());
+  return nullptr;
+}
+
+bool ParseEnv::AddReference(std::string_view label, LinkReference reference) {
+  return references
+      .try_emplace(Utils::NormalizeReference(label), std::move(reference))
+      .second;
+}
+
+std::shared_ptr<const ReferenceMap> ParseEnv::ShareReferences() {
+  auto table = std::make_shared<const ReferenceMap>(std::move(references));
+  references.clear();
+  return table;
+}
+
+std::string ParseEnv::UniqueSlug(std::string_view slug) {
+  auto it = slugs.find(slug);
+  if (it == slugs.end()) {
+    slugs.emplace(slug, 1);
+    return std::string(slug);
+  }
+
+  // the suffixed form may itself be the slug of another heading
+  std::string unique;
+  do {
+    unique.assign(slug);
+    unique += '-';
+    unique += std::to_string(it->second++);
+  } while (slugs.contains(unique));
+
+  slugs.emplace(unique, 1);
+  return unique;
+}
+
+void ParseEnv::Clear() {
+  references.clear();
+  shared_references.reset();
+  footnotes.refs.clear();
+  footnotes.list.clear();
+  slugs.clear();
+  for (std::shared_ptr<void>& slot : slots_) slot.reset();
+}
+
+std::size_t ParseEnv::RegisterSlot() {
+  static std::atomic<std::size_t> next = 0;
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace aethermark
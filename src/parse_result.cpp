@@ -0,0 +1,42 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/parse_result.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace aethermark {
+
+// Smallest first arena block; tiny documents still get a useful buffer.
+static constexpr std::size_t kMinArenaBlock = 4096;
+
+// Arena bytes reserved per source byte for the first block. The token array
+// lives upstream, and most token text borrows the source, so what the arena
+// holds for typical prose stays below the source size; the arena grows
+// geometrically past this anyway.
+static constexpr std::size_t kArenaBytesPerSourceByte = 1;
+
+ParseResult::Storage::Storage(std::size_t initial_size,
+                              std::pmr::memory_resource* upstream,
+                              std::pmr::memory_resource* buffer)
+    : arena(initial_size, upstream), tokens(&arena, buffer) {}
+
+ParseResult::ParseResult(std::size_t size_hint,
+                         std::pmr::memory_resource* upstream,
+                         std::pmr::memory_resource* buffer)
+    : storage_(std::make_unique<Storage>(
+          std::max(kMinArenaBlock, size_hint * kArenaBytesPerSourceByte),
+          upstream, buffer ? buffer : upstream)) {}
+
+void ParseResult::Reset() {
+  // drop the tokens before the arena memory backing them
+  storage_->tokens.clear();
+  storage_->arena.release();
+  storage_->source.clear();
+  storage_->env.Clear();
+}
+
+}  // namespace aethermark
@@ -3,9 +3,10 @@
 
 #include "aethermark/parser_block.hpp"
 
-#include <deque>
+#include <span>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "aethermark/aethermark.hpp"
@@ -16,114 +17,81 @@
 
 namespace aethermark {
 
-static const std::vector<
-    std::tuple<std::string, RuleBlock, std::vector<std::string>>>
-    block_rules = {{"table", BlockRules::RuleTable, {"paragraph", "reference"}},
-                   {"code", BlockRules::RuleCode, {}},
-                   {"fence",
-                    BlockRules::RuleFence,
-                    {"paragraph", "reference", "blockquote", "list"}},
-                   {"blockquote",
-                    BlockRules::RuleBlockquote,
-                    {"paragraph", "reference", "blockquote", "list"}},
-                   {"hr",
-                    BlockRules::RuleHr,
-                    {"paragraph", "reference", "blockquote", "list"}},
-                   {"list",
-                    BlockRules::RuleList,
-                    {"paragraph", "reference", "blockquote"}},
-                   {"reference", BlockRules::RuleReference, {}},
-                   {"html_block",
-                    BlockRules::RuleHtmlBlock,
-                    {"paragraph", "reference", "blockquote"}},
-                   {"heading",
-                    BlockRules::RuleHeading,
-                    {"paragraph", "reference", "blockquote"}},
-                   {"lheading", BlockRules::RuleLheading, {}},
-                   {"paragraph", BlockRules::RuleParagraph, {}}};
+// Name, function, alternate chains and trigger characters of each rule. A
+// rule with triggers only runs on lines whose first non-space character is
+// one of them. Keep in step with `StaticPreset<PresetId::kCommonmark>`.
+static const std::vector<std::tuple<std::string, RuleBlock,
+                                    std::vector<std::string>, std::string>>
+    block_rules = {
+        {"table", BlockRules::RuleTable, {"paragraph", "reference"}, ""},
+        {"code", BlockRules::RuleCode, {}, ""},
+        {"fence",
+         BlockRules::RuleFence,
+         {"paragraph", "reference", "blockquote", "list"},
+         BlockTriggers::kFence},
+        {"blockquote",
+         BlockRules::RuleBlockquote,
+         {"paragraph", "reference", "blockquote", "list"},
+         BlockTriggers::kBlockquote},
+        {"hr",
+         BlockRules::RuleHr,
+         {"paragraph", "reference", "blockquote", "list"},
+         BlockTriggers::kHr},
+        {"list",
+         BlockRules::RuleList,
+         {"paragraph", "reference", "blockquote"},
+         BlockTriggers::kList},
+        {"reference", BlockRules::RuleReference, {}, BlockTriggers::kReference},
+        {"html_block",
+         BlockRules::RuleHtmlBlock,
+         {"paragraph", "reference", "blockquote"},
+         BlockTriggers::kHtmlBlock},
+        {"heading",
+         BlockRules::RuleHeading,
+         {"paragraph", "reference", "blockquote"},
+         BlockTriggers::kHeading},
+        {"lheading", BlockRules::RuleLheading, {}, ""},
+        {"paragraph", BlockRules::RuleParagraph, {}, ""}};
 
 ParserBlock::ParserBlock() : ruler() {
-  for (const auto& [name, fn, alts] : block_rules) {
+  for (const auto& [name, fn, alts, triggers] : block_rules) {
     RuleOptions opts;
     opts.alt = alts;
+    opts.triggers = triggers;
     ruler.Push(name, fn, opts);
   }
+
+  chains.paragraph = ruler.ChainId("paragraph");
+  chains.reference = ruler.ChainId("reference");
+  chains.blockquote = ruler.ChainId("blockquote");
+  chains.list = ruler.ChainId("list");
 }
 
 void ParserBlock::Tokenize(StateBlock& state, int startLine, int endLine) {
-  // Get rule list
-  const std::vector<std::pair<std::string, RuleBlock>>& rules =
-      ruler.GetRules("");
-  const int len = static_cast<int>(rules.size());
-  const int max_nesting = state.md.options.max_nesting;
-
-  int line = startLine;
-  bool has_empty_lines = false;
-
-  while (line < endLine) {
-    // Skip empty lines
-    state.line = state.SkipEmptyLines(line);
-    line = state.line;
-    if (line >= endLine) break;
-
-    // Termination for nested blocks (quotes, lists, etc.)
-    if (state.s_count[line] < state.blk_indent) {
-      break;
-    }
-
-    // Max nesting level reached → bail out
-    if (state.level >= max_nesting) {
-      state.line = endLine;
-      break;
-    }
-
-    const int prev_line = state.line;
-    bool matched = false;
-
-    // Try all block rules
-    for (int i = 0; i < len; ++i) {
-      const RuleBlock& rule = rules[i].second;
-      if (rule(state, line, endLine, false)) {
-        matched = true;
-        if (state.line <= prev_line) {
-          throw std::runtime_error("block rule didn't increment state.line");
-        }
-        break;
-      }
+  // Rule lists of the parse, indexed by first character
+  const RuleChains<RuleBlock>& rules = *state.rules;
+
+  // Try the block rules that can start with the line's first character
+  auto match = [&rules](StateBlock& state, int line, int endLine) {
+    const unsigned char first = state.src[state.lines[line].First()];
+    for (const RuleBlock& rule : rules.Get(kDefaultChain, first)) {
+      if (rule(state, line, endLine, false)) return true;
     }
+    return false;
+  };
 
-    // Paragraph rule disabled? → impossible in normal config
-    if (!matched) {
-      throw std::runtime_error("none of the block rules matched");
-    }
-
-    // Update state.tight (same logic as JS)
-    state.tight = !has_empty_lines;
-
-    // Paragraphs sometimes consume the trailing newline
-    if (state.IsEmpty(state.line - 1)) {
-      has_empty_lines = true;
-    }
-
-    line = state.line;
-
-    // If next line is empty, mark it
-    if (line < endLine && state.IsEmpty(line)) {
-      has_empty_lines = true;
-      ++line;
-      state.line = line;
-    }
-  }
+  TokenizeWith(state, startLine, endLine, state.md.options.max_nesting, match);
 }
 
-void ParserBlock::Parse(const std::string& src, Aethermark& md, std::any env,
-                        std::deque<Token>& outTokens) {
+void ParserBlock::Parse(const std::string& src, Aethermark& md, ParseEnv& env,
+                        TokenList& outTokens, ParseContext* context,
+                        RuleSnapshot<RuleBlock> rules) {
   if (src.empty()) {
     return;
   }
 
   // Create parsing state
-  StateBlock state(src, md, env, outTokens);
+  StateBlock state(src, md, env, outTokens, context, std::move(rules));
 
   // Kick off block tokenization
   Tokenize(state, state.line, state.line_max);
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "aethermark/aethermark.hpp"
 #include "aethermark/rules_core/rules_core.hpp"
 
 namespace aethermark {
@@ -27,11 +28,15 @@ ParserCore::ParserCore() : ruler{} {
 }
 
 void ParserCore::Process(StateCore& state) {
-  std::vector<std::pair<std::string, RuleCore>> rules =
-      this->ruler.GetRules("");
-  for (int i = 0, l = rules.size(); i < l; i++) {
-    rules[i].second(state);
+  // Take one configuration for every stage of the parse, held by the state
+  // so it outlives a concurrent reconfiguration
+  if (!state.rules) state.rules = state.md.Rules();
+  for (const RuleCore& rule : state.rules->core_rules->Get(kDefaultChain)) {
+    rule(state);
   }
+  // Drop the children merged away by the rules, so the buffer holds only
+  // tokens of the tree
+  state.tokens.Compact();
 }
 
 }  // namespace aethermark
@@ -0,0 +1,159 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/parser_inline.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/ruler.hpp"
+#include "aethermark/rules_inline/rules_inline.hpp"
+#include "aethermark/rules_inline/state_inline.hpp"
+#include "aethermark/token.hpp"
+
+namespace aethermark {
+
+// Name, function and trigger characters of each tokenizing rule. A rule with
+// triggers only runs at positions holding one of them; `text` runs
+// everywhere and gives up at once on the characters other rules start with.
+static const std::vector<std::tuple<std::string, RuleInline, std::string>>
+    inline_rules = {
+        {"text", InlineRules::RuleText, ""},
+        {"newline", InlineRules::RuleNewline, "\n"},
+        {"escape", InlineRules::RuleEscape, "\\"},
+        {"backticks", InlineRules::RuleBackticks, "`"},
+        {"emphasis", InlineRules::RuleEmphasis, "*_"},
+        {"link", InlineRules::RuleLink, "["},
+        {"image", InlineRules::RuleImage, "!"},
+        {"autolink", InlineRules::RuleAutolink, "<"},
+        {"html_inline", InlineRules::RuleHtmlInline, "<"},
+        {"entity", InlineRules::RuleEntity, "&"}};
+
+// Post-processing rules, run in order once the content is tokenized.
+static const std::vector<std::pair<std::string, RuleInline2>> inline_rules2 =
+    {{"balance_pairs", InlineRules::RuleBalancePairs},
+     {"emphasis", InlineRules::RuleEmphasisPost},
+     {"fragments_join", InlineRules::RuleFragmentsJoin}};
+
+ParserInline::ParserInline() : ruler(), ruler2() {
+  for (const auto& [name, fn, triggers] : inline_rules) {
+    RuleOptions opts;
+    opts.triggers = triggers;
+    ruler.Push(name, fn, opts);
+  }
+
+  for (const auto& [name, fn] : inline_rules2) {
+    ruler2.Push(name, fn);
+  }
+}
+
+void ParserInline::Tokenize(StateInline& state,
+                            const RuleChains<RuleInline>& rules) const {
+  const std::size_t end = state.pos_max;
+  const int max_nesting = state.md.options.max_nesting;
+
+  while (state.pos < end) {
+    // Try the rules that can start with the character at the position
+    const std::size_t prev_pos = state.pos;
+    bool ok = false;
+
+    if (state.level < max_nesting) {
+      const auto c = static_cast<unsigned char>(state.src[state.pos]);
+      for (const RuleInline& rule : rules.Get(kDefaultChain, c)) {
+        ok = rule(state, false);
+        if (ok) {
+          if (prev_pos >= state.pos) {
+            throw std::runtime_error("inline rule didn't increment state.pos");
+          }
+          break;
+        }
+      }
+    }
+
+    if (ok) {
+      if (state.pos >= end) break;
+      continue;
+    }
+
+    state.AddPending(state.pos, state.pos + 1);
+    state.pos++;
+  }
+
+  if (state.HasPending()) state.PushPending();
+}
+
+void ParserInline::SkipToken(StateInline& state) const {
+  const std::size_t pos = state.pos;
+
+  const auto cached = state.cache.find(pos);
+  if (cached != state.cache.end()) {
+    state.pos = cached->second;
+    return;
+  }
+
+  bool ok = false;
+  if (state.level < state.md.options.max_nesting) {
+    const auto c = static_cast<unsigned char>(state.src[pos]);
+    for (const RuleInline& rule : state.rules->Get(kDefaultChain, c)) {
+      // Nested rules count as one level deeper, which bounds the recursion;
+      // nothing is pushed in silent mode
+      state.level++;
+      ok = rule(state, true);
+      state.level--;
+      if (ok) {
+        if (pos >= state.pos) {
+          throw std::runtime_error("inline rule didn't increment state.pos");
+        }
+        break;
+      }
+    }
+  } else {
+    state.pos = state.pos_max;
+  }
+
+  if (!ok) state.pos++;
+  state.cache[pos] = state.pos;
+}
+
+void ParserInline::Parse(TokenList& tokens, std::size_t parent,
+                         Aethermark& md, ParseEnv& env,
+                         const RuleChains<RuleInline>& rules,
+                         const RuleChains<RuleInline2>& rules2) const {
+  const TokenString& content = tokens[parent].content;
+  if (content.empty()) return;
+
+  // Owned content moves with its token as the list grows, so parse a copy
+  // the children cannot borrow from
+  const bool stable = content.IsBorrowed();
+  std::pmr::string scratch(tokens.get_allocator());
+  if (!stable) scratch = content.View();
+  const std::string_view src = stable ? content.View() : scratch;
+
+  StateInline state(src, md, env, tokens, parent, stable);
+  state.rules = &rules;
+  tokens.BeginChildren(parent);
+  Tokenize(state, rules);
+  tokens.EndChildren();
+
+  for (const RuleInline2& rule : rules2.Get(kDefaultChain)) {
+    rule(state);
+  }
+
+  // Image descriptions become children of their image tokens, appended
+  // after the ones of the parent
+  const TokenRange children = tokens[parent].children;
+  for (std::size_t i = children.begin; i < children.end; i++) {
+    if (tokens[i].type == TokenKind::kImage) {
+      Parse(tokens, i, md, env, rules, rules2);
+    }
+  }
+}
+
+}  // namespace aethermark
@@ -3,10 +3,25 @@
 
 #include "aethermark/rules_block/rules_block.hpp"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "aethermark/aethermark.hpp"
+#include "aethermark/link_helpers.hpp"
 #include "aethermark/parser_block.hpp"
 #include "aethermark/token.hpp"
 #include "aethermark/utils.hpp"
@@ -18,26 +33,24 @@ namespace aethermark {
 // FIXME: Implement all block rules
 bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
                                 bool silent) {
-  int pos = state.b_marks[start_line] + state.t_shift[start_line];
-  int max = state.e_marks[start_line];
+  SourcePos pos = state.lines[start_line].First();
+  SourcePos max = state.lines[start_line].e_mark;
 
   const int oldline_max = state.line_max;
 
   // If indented too far (more than 3 spaces) -> not a blockquote
-  if (state.s_count[start_line] - state.blk_indent >= 4) return false;
+  if (state.lines[start_line].s_count - state.blk_indent >= 4) return false;
 
   // Must start with '>'
   if (state.src[pos] != '>') return false;
 
   if (silent) return true;
 
-  std::vector<int> old_b_marks;
-  std::vector<int> old_bs_count;
-  std::vector<int> old_s_count;
-  std::vector<int> old_t_shift;
+  // Line records changed below are rolled back once the contents are parsed
+  const LineCheckpoint checkpoint = state.Checkpoint();
 
-  std::vector<std::pair<std::string, RuleBlock>> terminators =
-      state.md.block_parser.ruler.GetRules("blockquote");
+  const ParserBlock& block_parser = state.md.block_parser;
+  const RuleChains<RuleBlock>& terminators = *state.rules;
 
   ParentType old_parent = state.parent_type;
   state.parent_type = ParentType::kBlockquote;
@@ -47,10 +60,11 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
 
   // Search
   for (next_line = start_line; next_line < end_line; next_line++) {
-    bool is_outdented = state.s_count[next_line] < state.blk_indent;
+    LineInfo& info = state.lines[next_line];
+    bool is_outdented = info.s_count < state.blk_indent;
 
-    pos = state.b_marks[next_line] + state.t_shift[next_line];
-    max = state.e_marks[next_line];
+    pos = info.First();
+    max = info.e_mark;
 
     if (pos >= max) {
       // Empty line outside blockquote
@@ -61,7 +75,7 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
     if (state.src[pos] == '>' && !is_outdented) {
       pos++;
 
-      int initial = state.s_count[next_line] + 1;
+      int initial = info.s_count + 1;
       bool space_after_marker = false;
       bool adjust_tab = false;
 
@@ -72,7 +86,7 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
         space_after_marker = true;
       } else if (pos < max && state.src[pos] == '\t') {
         space_after_marker = true;
-        if ((state.bs_count[next_line] + initial) % 4 == 3) {
+        if ((info.bs_count + initial) % 4 == 3) {
           pos++;
           initial++;
         } else {
@@ -82,17 +96,15 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
 
       int offset = initial;
 
-      old_b_marks.push_back(state.b_marks[next_line]);
-      state.b_marks[next_line] = pos;
+      state.SaveLine(next_line);
+      info.b_mark = pos;
 
       // Consume leading whitespace
       while (pos < max) {
         unsigned char ch = state.src[pos];
         if (Utils::IsSpace(static_cast<int>(ch))) {
           if (ch == '\t') {
-            offset +=
-                4 -
-                (offset + state.bs_count[next_line] + (adjust_tab ? 1 : 0)) % 4;
+            offset += 4 - (offset + info.bs_count + (adjust_tab ? 1 : 0)) % 4;
           } else {
             offset++;
           }
@@ -104,15 +116,9 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
 
       last_line_empty = (pos >= max);
 
-      old_bs_count.push_back(state.bs_count[next_line]);
-      state.bs_count[next_line] =
-          state.s_count[next_line] + 1 + (space_after_marker ? 1 : 0);
-
-      old_s_count.push_back(state.s_count[next_line]);
-      state.s_count[next_line] = offset - initial;
-
-      old_t_shift.push_back(state.t_shift[next_line]);
-      state.t_shift[next_line] = pos - state.b_marks[next_line];
+      info.bs_count = info.s_count + 1 + (space_after_marker ? 1 : 0);
+      info.s_count = offset - initial;
+      info.t_shift = static_cast<int>(pos - info.b_mark);
 
       continue;
     }
@@ -122,8 +128,10 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
 
     // Case 3: terminator rule
     bool terminate = false;
-    for (std::pair<std::string, RuleBlock>& rule : terminators) {
-      if (rule.second(state, next_line, end_line, true)) {
+    const unsigned char first = state.src[pos];
+    for (const RuleBlock& rule :
+         terminators.Get(block_parser.chains.blockquote, first)) {
+      if (rule(state, next_line, end_line, true)) {
         terminate = true;
         break;
       }
@@ -133,30 +141,24 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
       state.line_max = next_line;
 
       if (state.blk_indent != 0) {
-        old_b_marks.push_back(state.b_marks[next_line]);
-        old_bs_count.push_back(state.bs_count[next_line]);
-        old_t_shift.push_back(state.t_shift[next_line]);
-        old_s_count.push_back(state.s_count[next_line]);
-
-        state.s_count[next_line] -= state.blk_indent;
+        state.SaveLine(next_line);
+        info.s_count -= state.blk_indent;
       }
 
       break;
     }
 
-    old_b_marks.push_back(state.b_marks[next_line]);
-    old_bs_count.push_back(state.bs_count[next_line]);
-    old_t_shift.push_back(state.t_shift[next_line]);
-    old_s_count.push_back(state.s_count[next_line]);
-
-    state.s_count[next_line] = -1;  // paragraph continuation
+    state.SaveLine(next_line);
+    info.s_count = -1;  // paragraph continuation
   }
 
   int old_indent = state.blk_indent;
   state.blk_indent = 0;
 
-  // Open token
-  Token& open = state.Push("blockquote_open", "blockquote", Nesting::kOpening);
+  // Open token, tracked by index since nested rules grow the token list
+  const std::size_t open_index = state.tokens.size();
+  Token& open = state.Push(TokenKind::kBlockquoteOpen, HtmlTag::kBlockquote,
+                           Nesting::kOpening);
   open.markup = ">";
   open.map = std::optional<std::pair<float, float>>(
       {static_cast<float>(start_line), 0});
@@ -165,31 +167,25 @@ bool BlockRules::RuleBlockquote(StateBlock& state, int start_line, int end_line,
   state.md.block_parser.Tokenize(state, start_line, next_line);
 
   // Close token
-  Token& close =
-      state.Push("blockquote_close", "blockquote", Nesting::kClosing);
+  Token& close = state.Push(TokenKind::kBlockquoteClose, HtmlTag::kBlockquote,
+                            Nesting::kClosing);
   close.markup = ">";
 
   // Fix map end
-  open.map->second = static_cast<float>(state.line);
+  state.tokens[open_index].map->second = static_cast<float>(state.line);
   state.line_max = oldline_max;
   state.parent_type = old_parent;
   state.blk_indent = old_indent;
 
   // Restore offsets
-  for (int i = 0; i < static_cast<int>(old_t_shift.size()); i++) {
-    int line = start_line + i;
-    state.b_marks[line] = old_b_marks[i];
-    state.t_shift[line] = old_t_shift[i];
-    state.s_count[line] = old_s_count[i];
-    state.bs_count[line] = old_bs_count[i];
-  }
+  state.Rollback(checkpoint);
 
   return true;
 }
 
 bool BlockRules::RuleCode(StateBlock& state, int start_line, int end_line,
                           bool silent) {
-  if (state.s_count[start_line] - state.blk_indent < 4) {
+  if (state.lines[start_line].s_count - state.blk_indent < 4) {
     return false;
   }
 
@@ -202,7 +198,7 @@ bool BlockRules::RuleCode(StateBlock& state, int start_line, int end_line,
       next_line++;
       continue;
     }
-    if (state.s_count[next_line] - state.blk_indent >= 4) {
+    if (state.lines[next_line].s_count - state.blk_indent >= 4) {
       next_line++;
       last = next_line;
       continue;
@@ -212,9 +208,20 @@ bool BlockRules::RuleCode(StateBlock& state, int start_line, int end_line,
 
   state.line = last;
 
-  Token& token = state.Push("code_block", "code", Nesting::kSelfClosing);
-  token.content =
-      state.GetLines(start_line, last, 4 + state.blk_indent, false) + "\n";
+  Token& token =
+      state.Push(TokenKind::kCodeBlock, HtmlTag::kCode, Nesting::kSelfClosing);
+
+  // Content always ends with a newline; borrow it when the source has one.
+  std::optional<std::string_view> view =
+      state.GetLinesView(start_line, last, 4 + state.blk_indent, true);
+  if (view.has_value() && view->ends_with('\n')) {
+    token.content.Borrow(*view);
+  } else {
+    std::pmr::string content(token.get_allocator());
+    state.AppendLines(start_line, last, 4 + state.blk_indent, true, content);
+    if (!content.ends_with('\n')) content += '\n';
+    token.content.Assign(std::move(content));
+  }
   token.map = {start_line, state.line};
 
   return true;
@@ -222,7 +229,127 @@ bool BlockRules::RuleCode(StateBlock& state, int start_line, int end_line,
 
 bool BlockRules::RuleFence(StateBlock& state, int start_line, int end_line,
                            bool silent) {
-  return false;
+  // if it's indented more than 3 spaces, it should be a code block
+  if (state.lines[start_line].s_count - state.blk_indent >= 4) {
+    return false;
+  }
+
+  SourcePos pos = state.lines[start_line].First();
+  SourcePos max = state.lines[start_line].e_mark;
+  if (pos + 3 > max) return false;
+
+  const char marker = state.src[pos];
+  if (marker != '~' && marker != '`') return false;
+
+  // scan marker length
+  const SourcePos mem = pos;
+  pos = state.SkipChars(pos, marker);
+  const SourcePos len = pos - mem;
+  if (len < 3) return false;
+
+  const std::string_view src = state.src;
+  const std::string_view markup = src.substr(mem, len);
+  const std::string_view params = src.substr(pos, max - pos);
+
+  if (marker == '`' && params.find('`') != std::string_view::npos) {
+    return false;
+  }
+
+  // Since start is found, we can report success here in validation mode
+  if (silent) return true;
+
+  // If a fence has heading spaces, they should be removed from its inner
+  // block
+  const int indent = state.lines[start_line].s_count;
+
+  // Search for the end of the block. A closing fence starts with the marker,
+  // so jump between its occurrences with memchr rather than looking at the
+  // first character of every line; the records of the lines skipped over are
+  // still checked for an outdent, which ends the block early, and for a gap
+  // (blockquote markers) that keeps the body from being one span.
+  int next_line = start_line + 1;
+  bool have_end_marker = false;
+  bool contiguous = indent == 0;
+  const SourcePos body_end =
+      next_line < end_line ? state.lines[end_line - 1].e_mark : 0;
+  SourcePos scan = next_line < end_line ? state.lines[next_line].b_mark : 0;
+
+  while (next_line < end_line) {
+    const void* hit =
+        scan < body_end
+            ? std::memchr(src.data() + scan, marker,
+                          static_cast<std::size_t>(body_end - scan))
+            : nullptr;
+    const SourcePos hit_pos =
+        hit != nullptr
+            ? static_cast<SourcePos>(static_cast<const char*>(hit) - src.data())
+            : body_end + 1;
+
+    // Walk the line records up to the one holding the hit
+    bool outdent = false;
+    for (;;) {
+      const LineInfo& info = state.lines[next_line];
+      if (info.First() < info.e_mark && info.s_count < state.blk_indent) {
+        // non-empty line with negative indent should stop the list:
+        // - ```
+        //  test
+        outdent = true;
+        break;
+      }
+      contiguous =
+          contiguous && info.b_mark == state.lines[next_line - 1].e_mark + 1;
+      if (hit_pos <= info.e_mark) break;
+      if (++next_line >= end_line) break;
+    }
+    if (outdent || next_line >= end_line) break;
+
+    const LineInfo& info = state.lines[next_line];
+    // closing fence should be indented less than 4 spaces
+    if (info.First() < info.e_mark && src[info.First()] == marker &&
+        info.s_count - state.blk_indent < 4) {
+      pos = state.SkipChars(info.First(), marker);
+      // closing code fence must be at least as long as the opening one, and
+      // followed by spaces only
+      if (pos - info.First() >= len && state.SkipSpaces(pos) >= info.e_mark) {
+        have_end_marker = true;
+        break;
+      }
+    }
+
+    if (++next_line < end_line) {
+      scan = std::max(hit_pos + 1, state.lines[next_line].b_mark);
+    }
+  }
+
+  state.line = next_line + (have_end_marker ? 1 : 0);
+
+  Token& token =
+      state.Push(TokenKind::kFence, HtmlTag::kCode, Nesting::kSelfClosing);
+  token.info = params;
+  token.markup = markup;
+
+  std::optional<std::string_view> view;
+  if (contiguous) {
+    const auto size = static_cast<SourcePos>(src.size());
+    const SourcePos begin = std::min(state.lines[start_line].e_mark + 1, size);
+    const SourcePos end =
+        next_line > start_line + 1
+            ? std::min(state.lines[next_line - 1].e_mark + 1, size)
+            : begin;
+    view = src.substr(begin, end - begin);
+  } else {
+    view = state.GetLinesView(start_line + 1, next_line, indent, true);
+  }
+  if (view.has_value()) {
+    token.content.Borrow(*view);
+  } else {
+    std::pmr::string content(token.get_allocator());
+    state.AppendLines(start_line + 1, next_line, indent, true, content);
+    token.content.Assign(std::move(content));
+  }
+  token.map = {start_line, state.line};
+
+  return true;
 }
 
 bool BlockRules::RuleHeading(StateBlock& state, int start_line, int end_line,
@@ -255,8 +382,8 @@ bool BlockRules::RuleParagraph(StateBlock& state, int start_line, int end_line,
   // If this is an empty line -> not a paragraph
   if (state.IsEmpty(start_line)) return false;
 
-  std::vector<std::pair<std::string, RuleBlock>> terminator_rules =
-      state.md.block_parser.ruler.GetRules("paragraph");
+  const ParserBlock& block_parser = state.md.block_parser;
+  const RuleChains<RuleBlock>& terminator_rules = *state.rules;
 
   ParentType old_parent_type = state.parent_type;
   state.parent_type = ParentType::kParagraph;
@@ -265,16 +392,20 @@ bool BlockRules::RuleParagraph(StateBlock& state, int start_line, int end_line,
 
   // Move line-by-line until we find a terminator
   for (; next_line < end_line && !state.IsEmpty(next_line); next_line++) {
+    const LineInfo& info = state.lines[next_line];
+
     // Code-indented line after a paragraph = lazy continuation
-    if (state.s_count[next_line] - state.blk_indent > 3) continue;
+    if (info.s_count - state.blk_indent > 3) continue;
 
     // Blockquote marker quirk (negative indent)
-    if (state.s_count[next_line] < 0) continue;
+    if (info.s_count < 0) continue;
 
-    // Run terminator rules
+    // Run terminator rules that can start with the line's first character
     bool terminate = false;
-    for (std::pair<std::string, RuleBlock>& rule : terminator_rules) {
-      if (rule.second(state, next_line, end_line, true)) {
+    const unsigned char first = state.src[info.First()];
+    for (const RuleBlock& rule :
+         terminator_rules.Get(block_parser.chains.paragraph, first)) {
+      if (rule(state, next_line, end_line, true)) {
         terminate = true;
         break;
       }
@@ -282,38 +413,599 @@ bool BlockRules::RuleParagraph(StateBlock& state, int start_line, int end_line,
     if (terminate) break;
   }
 
-  // Extract raw paragraph text
-  std::string content =
-      state.GetLines(start_line, next_line, state.blk_indent, false);
-  content = Utils::Trim(content);
-
   state.line = next_line;
 
   // Build tokens
-  Token& token_open = state.Push("paragraph_open", "p", Nesting::kOpening);
+  Token& token_open =
+      state.Push(TokenKind::kParagraphOpen, HtmlTag::kP, Nesting::kOpening);
   token_open.map =
       std::optional<std::pair<float, float>>({start_line, state.line});
 
-  Token& token_inline = state.Push("inline", "", Nesting::kSelfClosing);
-  token_inline.content = content;
+  Token& token_inline =
+      state.Push(TokenKind::kInline, HtmlTag::kNone, Nesting::kSelfClosing);
+
+  // Extract raw paragraph text, borrowed from the source when contiguous
+  std::optional<std::string_view> view =
+      state.GetLinesView(start_line, next_line, state.blk_indent, false);
+  if (view.has_value()) {
+    token_inline.content.Borrow(Utils::TrimView(*view));
+  } else {
+    // Assemble straight into the token's arena storage, then trim in place
+    std::pmr::string content(token_inline.get_allocator());
+    state.AppendLines(start_line, next_line, state.blk_indent, false, content);
+    const std::string_view trimmed = Utils::TrimView(content);
+    const std::size_t lead = trimmed.data() - content.data();
+    content.resize(lead + trimmed.size());
+    content.erase(0, lead);
+    token_inline.content.Assign(std::move(content));
+  }
   token_inline.map =
       std::optional<std::pair<float, float>>({start_line, state.line});
 
-  state.Push("paragraph_close", "p", Nesting::kClosing);
+  state.Push(TokenKind::kParagraphClose, HtmlTag::kP, Nesting::kClosing);
 
   state.parent_type = old_parent_type;
 
   return true;
 }
 
-bool BlockRules::RuleReference(StateBlock& state, int start_line, int end_line,
-                               bool silent) {
-  return false;
+// Like markdown-it, reads up to `state.line_max` and ignores `end_line`.
+bool BlockRules::RuleReference(StateBlock& state, int start_line,
+                               int /*end_line*/, bool silent) {
+  const LineInfo& first = state.lines[start_line];
+  int next_line = start_line + 1;
+
+  // if it's indented more than 3 spaces, it should be a code block
+  if (first.s_count - state.blk_indent >= 4) return false;
+
+  if (state.src[first.First()] != '[') return false;
+
+  const ParserBlock& block_parser = state.md.block_parser;
+  const RuleChains<RuleBlock>& terminators = *state.rules;
+
+  // Text of a line the definition may continue on, newline included;
+  // nullopt at an empty line, the end of the input or another block
+  auto get_next_line = [&](int line) -> std::optional<std::string_view> {
+    if (line >= state.line_max || state.IsEmpty(line)) return std::nullopt;
+
+    const LineInfo& info = state.lines[line];
+
+    // this would be a code block normally, but after paragraph it's
+    // considered a lazy continuation regardless of what's there; negative
+    // indents are the blockquote quirk, already checked by that rule
+    const bool is_continuation =
+        info.s_count - state.blk_indent > 3 || info.s_count < 0;
+
+    if (!is_continuation) {
+      const ParentType old_parent = state.parent_type;
+      state.parent_type = ParentType::kReference;
+
+      // Some tags can terminate paragraph without empty line
+      bool terminate = false;
+      const unsigned char c = state.src[info.First()];
+      for (const RuleBlock& rule :
+           terminators.Get(block_parser.chains.reference, c)) {
+        if (rule(state, line, state.line_max, true)) {
+          terminate = true;
+          break;
+        }
+      }
+
+      state.parent_type = old_parent;
+      if (terminate) return std::nullopt;
+    }
+
+    // e_mark + 1 explicitly includes the newline
+    const std::string_view src = state.src;
+    return src.substr(info.First(), info.e_mark + 1 - info.First());
+  };
+
+  // The definition may span lines, so it is parsed from their contents
+  // joined without indentation
+  std::string str(std::string_view(state.src).substr(
+      first.First(), first.e_mark + 1 - first.First()));
+  std::size_t max = str.size();
+
+  auto append_next_line = [&]() {
+    if (std::optional<std::string_view> line = get_next_line(next_line)) {
+      str += *line;
+      max = str.size();
+      next_line++;
+    }
+  };
+
+  std::size_t label_end = std::string::npos;
+  std::size_t pos;
+
+  for (pos = 1; pos < max; pos++) {
+    const char ch = str[pos];
+    if (ch == '[') {
+      return false;
+    } else if (ch == ']') {
+      label_end = pos;
+      break;
+    } else if (ch == '\n') {
+      append_next_line();
+    } else if (ch == '\\') {
+      pos++;
+      if (pos < max && str[pos] == '\n') append_next_line();
+    }
+  }
+
+  if (label_end == std::string::npos || label_end + 1 >= max ||
+      str[label_end + 1] != ':') {
+    return false;
+  }
+
+  // [label]:   destination   'title'
+  //         ^^^ skip optional whitespace here
+  for (pos = label_end + 2; pos < max; pos++) {
+    const char ch = str[pos];
+    if (ch == '\n') {
+      append_next_line();
+    } else if (!Utils::IsSpace(ch)) {
+      break;
+    }
+  }
+
+  // [label]:   destination   'title'
+  //            ^^^^^^^^^^^ parse this
+  const LinkDestination dest = LinkHelpers::ParseLinkDestination(str, pos, max);
+  if (!dest.ok) return false;
+
+  std::string href = state.md.NormalizeLink(dest.str);
+  if (!state.md.ValidateLink(href)) return false;
+
+  pos = dest.pos;
+
+  // save cursor state, we could require to rollback later
+  const std::size_t dest_end_pos = pos;
+  const int dest_end_line = next_line;
+
+  // [label]:   destination   'title'
+  //                       ^^^ skipping those spaces
+  const std::size_t start = pos;
+  for (; pos < max; pos++) {
+    const char ch = str[pos];
+    if (ch == '\n') {
+      append_next_line();
+    } else if (!Utils::IsSpace(ch)) {
+      break;
+    }
+  }
+
+  // [label]:   destination   'title'
+  //                          ^^^^^^^ parse this
+  LinkTitle title_res = LinkHelpers::ParseLinkTitle(str, pos, max);
+  while (title_res.can_continue) {
+    std::optional<std::string_view> line = get_next_line(next_line);
+    if (!line.has_value()) break;
+    str += *line;
+    pos = max;
+    max = str.size();
+    next_line++;
+    title_res = LinkHelpers::ParseLinkTitle(str, pos, max, &title_res);
+  }
+
+  std::string title;
+  if (pos < max && start != pos && title_res.ok) {
+    title = std::move(title_res.str);
+    pos = title_res.pos;
+  } else {
+    pos = dest_end_pos;
+    next_line = dest_end_line;
+  }
+
+  // skip trailing spaces until the rest of the line
+  while (pos < max && Utils::IsSpace(str[pos])) pos++;
+
+  if (pos < max && str[pos] != '\n' && !title.empty()) {
+    // garbage at the end of the line after title, but it could still be a
+    // valid reference if we roll back
+    title.clear();
+    pos = dest_end_pos;
+    next_line = dest_end_line;
+    while (pos < max && Utils::IsSpace(str[pos])) pos++;
+  }
+
+  // garbage at the end of the line
+  if (pos < max && str[pos] != '\n') return false;
+
+  std::string label =
+      Utils::NormalizeReference(std::string_view(str).substr(1, label_end - 1));
+
+  // CommonMark 0.20 disallows empty labels
+  if (label.empty()) return false;
+
+  // Reference can not terminate anything. This check is for safety only.
+  if (silent) return true;
+
+  // The first definition of a label wins
+  state.env.references.try_emplace(std::move(label), std::move(href),
+                                   std::move(title));
+
+  state.line = next_line;
+  return true;
+}
+
+namespace {
+
+// Table rows are split 64 bytes at a time with the widest vectors the build
+// targets: bit `i` of each mask describes byte `i` of the block.
+constexpr int kRowBlock = 64;
+
+struct PipeMasks {
+  std::uint64_t pipe;
+  std::uint64_t backslash;
+};
+
+#if defined(__AVX2__)
+inline PipeMasks ScanPipes(const char* p) {
+  PipeMasks masks{0, 0};
+  for (int i = 0; i < kRowBlock; i += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const __m256i pipe = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('|'));
+    const __m256i backslash = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'));
+    masks.pipe |= std::uint64_t{static_cast<std::uint32_t>(
+                      _mm256_movemask_epi8(pipe))}
+                  << i;
+    masks.backslash |= std::uint64_t{static_cast<std::uint32_t>(
+                           _mm256_movemask_epi8(backslash))}
+                       << i;
+  }
+  return masks;
+}
+#elif defined(__SSE2__)
+inline PipeMasks ScanPipes(const char* p) {
+  PipeMasks masks{0, 0};
+  for (int i = 0; i < kRowBlock; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const __m128i pipe = _mm_cmpeq_epi8(v, _mm_set1_epi8('|'));
+    const __m128i backslash = _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'));
+    masks.pipe |= std::uint64_t{static_cast<std::uint32_t>(
+                      _mm_movemask_epi8(pipe))}
+                  << i;
+    masks.backslash |= std::uint64_t{static_cast<std::uint32_t>(
+                           _mm_movemask_epi8(backslash))}
+                       << i;
+  }
+  return masks;
+}
+#else
+inline PipeMasks ScanPipes(const char* p) {
+  PipeMasks masks{0, 0};
+  for (int i = 0; i < kRowBlock; i++) {
+    masks.pipe |= std::uint64_t{p[i] == '|'} << i;
+    masks.backslash |= std::uint64_t{p[i] == '\\'} << i;
+  }
+  return masks;
+}
+#endif
+
+// Call `fn(pos)` for each pipe of `row` separating cells, i.e. not preceded
+// by a backslash, as markdown-it's `escapedSplit`; stop when `fn` returns
+// false. Return whether a pipe was escaped.
+template <typename Fn>
+bool ForEachCellPipe(std::string_view row, Fn&& fn) {
+  bool escaped = false;
+  std::uint64_t carry = 0;
+
+  for (std::size_t base = 0; base < row.size(); base += kRowBlock) {
+    PipeMasks masks;
+    if (row.size() - base >= kRowBlock) {
+      masks = ScanPipes(row.data() + base);
+    } else {
+      // pad the last block with bytes that are neither pipes nor backslashes
+      char tail[kRowBlock] = {};
+      std::memcpy(tail, row.data() + base, row.size() - base);
+      masks = ScanPipes(tail);
+    }
+
+    const std::uint64_t after_backslash = masks.backslash << 1 | carry;
+    carry = masks.backslash >> 63;
+    escaped = escaped || (masks.pipe & after_backslash) != 0;
+
+    for (std::uint64_t bits = masks.pipe & ~after_backslash; bits != 0;
+         bits &= bits - 1) {
+      if (!fn(base + std::countr_zero(bits))) return escaped;
+    }
+  }
+  return escaped;
+}
+
+// A table row, trimmed, split into cells at the pipes that separate them;
+// an empty first and last cell are dropped. Cells are found by scanning the
+// row again on each walk, so nothing is stored per row.
+class TableRow {
+ public:
+  explicit TableRow(std::string_view row)
+      : row_(row),
+        skip_first_(!row.empty() && row.front() == '|'),
+        skip_last_(!row.empty() && row.back() == '|' &&
+                   (row.size() == 1 || row[row.size() - 2] != '\\')) {}
+
+  // Number of cells, counted up to `limit + 1` only so that a row with far
+  // too many cells is rejected early. Also finds escaped pipes.
+  std::size_t Count(std::size_t limit) {
+    std::size_t pipes = 0;
+    const std::size_t max_pipes = limit + 2;
+    escaped_ = ForEachCellPipe(row_, [&](std::size_t) {
+      return ++pipes < max_pipes;
+    });
+    const std::size_t cells = pipes + 1 - skip_first_ - skip_last_;
+    return std::min(cells, limit + 1);
+  }
+
+  // Call `fn(cell, escaped)` for each cell, `escaped` telling whether the
+  // cell holds an escaped pipe. Call after `Count`.
+  template <typename Fn>
+  void ForEachCell(Fn&& fn) const {
+    std::size_t start = 0;
+    bool first = true;
+    ForEachCellPipe(row_, [&](std::size_t pos) {
+      if (!first || !skip_first_) Emit(start, pos, fn);
+      first = false;
+      start = pos + 1;
+      return true;
+    });
+    if (!skip_last_) Emit(start, row_.size(), fn);
+  }
+
+ private:
+  template <typename Fn>
+  void Emit(std::size_t begin, std::size_t end, Fn& fn) const {
+    const std::string_view cell = row_.substr(begin, end - begin);
+    fn(cell, escaped_ && cell.find("\\|") != std::string_view::npos);
+  }
+
+  std::string_view row_;
+  bool skip_first_;
+  bool skip_last_;
+  bool escaped_ = false;
+};
+
+// Text of `line` from its first non-space character, trimmed
+std::string_view TableLine(const StateBlock& state, int line) {
+  const LineInfo& info = state.lines[line];
+  const SourcePos first = info.First();
+  return Utils::TrimView(
+      std::string_view(state.src).substr(first, info.e_mark - first));
+}
+
+// Set the content of a cell's inline token, borrowing it from the source
+// unless escaped pipes must be unescaped
+void SetCellContent(Token& token, std::string_view cell, bool escaped) {
+  cell = Utils::TrimView(cell);
+  if (!escaped) {
+    token.content.Borrow(cell);
+    return;
+  }
+
+  std::pmr::string content(token.get_allocator());
+  content.reserve(cell.size());
+  for (std::size_t i = 0; i < cell.size(); i++) {
+    if (cell[i] == '\\' && i + 1 < cell.size() && cell[i + 1] == '|') continue;
+    content += cell[i];
+  }
+  token.content.Assign(std::move(content));
 }
 
+// Limit on the cells added to short rows, against quadratic output for
+// rows of one character after a wide header
+constexpr std::ptrdiff_t kMaxAutocompletedCells = 0x10000;
+
+}  // namespace
+
 bool BlockRules::RuleTable(StateBlock& state, int start_line, int end_line,
                            bool silent) {
-  return false;
+  // should have at least two lines
+  if (start_line + 2 > end_line) return false;
+
+  int next_line = start_line + 1;
+  const LineInfo& delimiter = state.lines[next_line];
+
+  if (delimiter.s_count < state.blk_indent) return false;
+
+  // if it's indented more than 3 spaces, it should be a code block
+  if (delimiter.s_count - state.blk_indent >= 4) return false;
+
+  // first character of the second line should be '|', '-', ':', and no
+  // other characters are allowed but spaces; basically, this is the
+  // equivalent of /^[-:|][-:|\s]*$/ regexp
+  SourcePos pos = delimiter.First();
+  if (pos >= delimiter.e_mark) return false;
+
+  const char first_ch = state.src[pos++];
+  if (first_ch != '|' && first_ch != '-' && first_ch != ':') return false;
+
+  if (pos >= delimiter.e_mark) return false;
+
+  const char second_ch = state.src[pos++];
+  if (second_ch != '|' && second_ch != '-' && second_ch != ':' &&
+      !Utils::IsSpace(second_ch)) {
+    return false;
+  }
+
+  // if first character is '-', then second character must not be a space
+  // (due to parsing ambiguity with list)
+  if (first_ch == '-' && Utils::IsSpace(second_ch)) return false;
+
+  for (; pos < delimiter.e_mark; pos++) {
+    const char ch = state.src[pos];
+    if (ch != '|' && ch != '-' && ch != ':' && !Utils::IsSpace(ch)) {
+      return false;
+    }
+  }
+
+  // Alignment of each column, as the value of its style attribute
+  std::vector<std::string_view> aligns;
+  std::string_view line_text = TableLine(state, next_line);
+  for (std::size_t begin = 0;;) {
+    const std::size_t end = std::min(line_text.find('|', begin),
+                                     line_text.size());
+    const bool last = end == line_text.size();
+    const std::string_view t =
+        Utils::TrimView(line_text.substr(begin, end - begin));
+
+    if (t.empty()) {
+      // allow empty columns before and after table, but not in between
+      // columns; e.g. allow ` |---| `, disallow ` ---||--- `
+      if (begin != 0 && !last) return false;
+    } else {
+      // /^:?-+:?$/
+      const std::size_t dashes_begin = t.front() == ':' ? 1 : 0;
+      const std::size_t dashes_end =
+          t.size() > dashes_begin && t.back() == ':' ? t.size() - 1 : t.size();
+      if (dashes_end <= dashes_begin ||
+          t.find_first_not_of('-', dashes_begin) < dashes_end) {
+        return false;
+      }
+
+      if (t.back() == ':') {
+        aligns.push_back(t.front() == ':' ? "text-align:center"
+                                          : "text-align:right");
+      } else if (t.front() == ':') {
+        aligns.push_back("text-align:left");
+      } else {
+        aligns.push_back({});
+      }
+    }
+
+    if (last) break;
+    begin = end + 1;
+  }
+
+  line_text = TableLine(state, start_line);
+  if (line_text.find('|') == std::string_view::npos) return false;
+  if (state.lines[start_line].s_count - state.blk_indent >= 4) return false;
+
+  // header row will define an amount of columns in the entire table, and
+  // align row should be exactly the same (the rest of the rows can differ);
+  // the header is only scanned as far as needed to tell
+  TableRow header(line_text);
+  const std::size_t column_count = aligns.size();
+  if (column_count == 0 || header.Count(column_count) != column_count) {
+    return false;
+  }
+
+  if (silent) return true;
+
+  const ParserBlock& block_parser = state.md.block_parser;
+  const RuleChains<RuleBlock>& terminator_rules = *state.rules;
+
+  ParentType old_parent_type = state.parent_type;
+  state.parent_type = ParentType::kTable;
+
+  // Tokens may move as the list grows, so maps filled in at the end are
+  // set through indices
+  const std::size_t table_open = state.tokens.size();
+  state.Push(TokenKind::kTableOpen, HtmlTag::kTable, Nesting::kOpening);
+
+  const std::pair<float, float> header_lines(start_line, start_line + 1);
+  state.Push(TokenKind::kTheadOpen, HtmlTag::kThead, Nesting::kOpening).map =
+      header_lines;
+  state.Push(TokenKind::kTrOpen, HtmlTag::kTr, Nesting::kOpening).map =
+      header_lines;
+
+  std::size_t column = 0;
+  header.ForEachCell([&](std::string_view cell, bool escaped) {
+    Token& token_open =
+        state.Push(TokenKind::kThOpen, HtmlTag::kTh, Nesting::kOpening);
+    if (!aligns[column].empty()) {
+      token_open.AttrSet(AttrKind::kStyle, aligns[column]);
+    }
+    column++;
+
+    Token& token_inline =
+        state.Push(TokenKind::kInline, HtmlTag::kNone, Nesting::kSelfClosing);
+    SetCellContent(token_inline, cell, escaped);
+
+    state.Push(TokenKind::kThClose, HtmlTag::kTh, Nesting::kClosing);
+  });
+
+  state.Push(TokenKind::kTrClose, HtmlTag::kTr, Nesting::kClosing);
+  state.Push(TokenKind::kTheadClose, HtmlTag::kThead, Nesting::kClosing);
+
+  std::size_t tbody_open = TokenList::kNoParent;
+  std::ptrdiff_t autocompleted_cells = 0;
+
+  for (next_line = start_line + 2; next_line < end_line; next_line++) {
+    const LineInfo& info = state.lines[next_line];
+    if (info.s_count < state.blk_indent) break;
+
+    line_text = TableLine(state, next_line);
+    if (line_text.empty()) break;
+
+    // use 'blockquote' lists for termination because it's the most similar
+    // to tables
+    bool terminate = false;
+    const unsigned char first = state.src[info.First()];
+    for (const RuleBlock& rule :
+         terminator_rules.Get(block_parser.chains.blockquote, first)) {
+      if (rule(state, next_line, end_line, true)) {
+        terminate = true;
+        break;
+      }
+    }
+    if (terminate) break;
+
+    if (info.s_count - state.blk_indent >= 4) break;
+
+    // a row has at most one cell more than bytes, so this counts them all
+    TableRow row(line_text);
+    const std::size_t cells = row.Count(line_text.size());
+
+    // note: autocomplete count can be negative if user specifies more
+    // columns than header, but that does not affect intended use (which is
+    // limiting expansion)
+    autocompleted_cells += static_cast<std::ptrdiff_t>(column_count) -
+                           static_cast<std::ptrdiff_t>(cells);
+    if (autocompleted_cells > kMaxAutocompletedCells) break;
+
+    if (next_line == start_line + 2) {
+      tbody_open = state.tokens.size();
+      state.Push(TokenKind::kTbodyOpen, HtmlTag::kTbody, Nesting::kOpening);
+    }
+
+    state.Push(TokenKind::kTrOpen, HtmlTag::kTr, Nesting::kOpening).map =
+        std::pair<float, float>(next_line, next_line + 1);
+
+    column = 0;
+    auto push_cell = [&](std::string_view cell, bool escaped) {
+      if (column == column_count) return;
+
+      Token& token_open =
+          state.Push(TokenKind::kTdOpen, HtmlTag::kTd, Nesting::kOpening);
+      if (!aligns[column].empty()) {
+        token_open.AttrSet(AttrKind::kStyle, aligns[column]);
+      }
+      column++;
+
+      Token& token_inline =
+          state.Push(TokenKind::kInline, HtmlTag::kNone, Nesting::kSelfClosing);
+      SetCellContent(token_inline, cell, escaped);
+
+      state.Push(TokenKind::kTdClose, HtmlTag::kTd, Nesting::kClosing);
+    };
+    row.ForEachCell(push_cell);
+    while (column < column_count) push_cell({}, false);
+
+    state.Push(TokenKind::kTrClose, HtmlTag::kTr, Nesting::kClosing);
+  }
+
+  if (tbody_open != TokenList::kNoParent) {
+    state.Push(TokenKind::kTbodyClose, HtmlTag::kTbody, Nesting::kClosing);
+    state.tokens[tbody_open].map =
+        std::pair<float, float>(start_line + 2, next_line);
+  }
+
+  state.Push(TokenKind::kTableClose, HtmlTag::kTable, Nesting::kClosing);
+  state.tokens[table_open].map = std::pair<float, float>(start_line, next_line);
+
+  state.parent_type = old_parent_type;
+  state.line = next_line;
+  return true;
 }
 
 // NOLINTEND
@@ -3,85 +3,198 @@
 
 #include "aethermark/rules_block/state_block.hpp"
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
-#include <any>
-#include <deque>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+
 namespace aethermark {
 
-StateBlock::StateBlock(const std::string& src_, Aethermark& md_, std::any env_,
-                       std::deque<Token>& tokens_)
-    : src(src_), md(md_), env(env_), tokens(tokens_) {
-  size_t estimated_lines = std::count(src.begin(), src.end(), '\n') + 4;
-
-  b_marks.reserve(estimated_lines);
-  e_marks.reserve(estimated_lines);
-  t_shift.reserve(estimated_lines);
-  s_count.reserve(estimated_lines);
-  bs_count.reserve(estimated_lines);
-
-  const std::string& s = src;
-  int len = static_cast<int>(s.length());
-
-  int start = 0;
-  int pos = 0;
-  int indent = 0;
-  int offset = 0;
-  bool indent_found = false;
-
-  while (pos < len) {
-    unsigned char ch = s[pos];
-
-    if (!indent_found) {
-      if (Utils::IsSpace(ch)) {
-        indent++;
-
-        if (ch == 0x09) {
-          offset += 4 - (offset % 4);
-        } else {
-          offset++;
+namespace {
+
+// Line indexing classifies the source 64 bytes at a time with the widest
+// vectors the build targets, then walks lines with bit operations.
+constexpr int kBlock = 64;
+
+// Classification of one block: bit `i` describes byte `i`.
+struct BlockMasks {
+  std::uint64_t newline;
+  std::uint64_t blank;  ///< Space or tab.
+};
+
+#if defined(__AVX2__)
+inline BlockMasks ScanBlock(const char* p) {
+  BlockMasks masks{0, 0};
+  for (int i = 0; i < kBlock; i += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const __m256i blank = _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+    const __m256i newline = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+    masks.blank |= std::uint64_t{static_cast<std::uint32_t>(
+                       _mm256_movemask_epi8(blank))}
+                   << i;
+    masks.newline |= std::uint64_t{static_cast<std::uint32_t>(
+                         _mm256_movemask_epi8(newline))}
+                     << i;
+  }
+  return masks;
+}
+#elif defined(__SSE2__)
+inline BlockMasks ScanBlock(const char* p) {
+  BlockMasks masks{0, 0};
+  for (int i = 0; i < kBlock; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const __m128i blank =
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    const __m128i newline = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+    masks.blank |= std::uint64_t{static_cast<std::uint32_t>(
+                       _mm_movemask_epi8(blank))}
+                   << i;
+    masks.newline |= std::uint64_t{static_cast<std::uint32_t>(
+                         _mm_movemask_epi8(newline))}
+                     << i;
+  }
+  return masks;
+}
+#else
+inline BlockMasks ScanBlock(const char* p) {
+  BlockMasks masks{0, 0};
+  for (int i = 0; i < kBlock; i++) {
+    const auto ch = static_cast<unsigned char>(p[i]);
+    masks.blank |= std::uint64_t{Utils::IsSpace(ch)} << i;
+    masks.newline |= std::uint64_t{ch == 0x0A} << i;
+  }
+  return masks;
+}
+#endif
+
+// Classify the block at `base`, padding a short last block with bytes that
+// are neither blanks nor newlines.
+inline BlockMasks ScanBlockAt(const char* s, SourcePos base, SourcePos len) {
+  if (len - base >= kBlock) return ScanBlock(s + base);
+
+  char tail[kBlock] = {};
+  std::memcpy(tail, s + base, len - base);
+  return ScanBlock(tail);
+}
+
+// Number of newlines in `s[0..len)`.
+std::size_t CountNewlines(const char* s, SourcePos len) {
+  std::size_t count = 0;
+  for (SourcePos base = 0; base < len; base += kBlock) {
+    count += std::popcount(ScanBlockAt(s, base, len).newline);
+  }
+  return count;
+}
+
+// Call `emit(begin, first, end)` for each line of `s[0..len)`: its start, its
+// first byte that is not a blank, and its newline (`len` for the last line).
+// Like the byte loop this replaced, a last line made of blanks only has no
+// end and is skipped.
+template <typename Emit>
+void ForEachLine(const char* s, SourcePos len, Emit&& emit) {
+  SourcePos begin = 0;
+  SourcePos first = -1;  // not found yet
+
+  for (SourcePos base = 0; base < len; base += kBlock) {
+    const BlockMasks masks = ScanBlockAt(s, base, len);
+    const std::uint64_t content = ~masks.blank;
+
+    std::uint64_t from = ~std::uint64_t{0};  // bits at or after the cursor
+    for (;;) {
+      if (first < 0) {
+        const std::uint64_t found = content & from;
+        if (found == 0) break;
+        const int bit = std::countr_zero(found);
+        first = base + bit;
+        if (first >= len) {
+          first = -1;  // padding
+          break;
         }
-        pos++;
-        continue;
-      } else {
-        indent_found = true;
+        from = ~std::uint64_t{0} << bit;
       }
+
+      const std::uint64_t newlines = masks.newline & from;
+      if (newlines == 0) break;
+      const int bit = std::countr_zero(newlines);
+      emit(begin, first, base + bit);
+
+      begin = base + bit + 1;
+      first = -1;
+      if (bit == kBlock - 1) break;
+      from = ~std::uint64_t{0} << (bit + 1);
     }
+  }
 
-    if (ch == 0x0A || pos == len - 1) {
-      if (ch != 0x0A) {
-        pos++;
-      }
+  if (first >= 0) emit(begin, first, len);
+}
+
+}  // namespace
+
+StateBlock::StateBlock(const std::string& src_, Aethermark& md_, ParseEnv& env_,
+                       TokenList& tokens_, ParseContext* context,
+                       RuleSnapshot<RuleBlock> rules_)
+    : src(src_),
+      md(md_),
+      env(env_),
+      tokens(tokens_),
+      rules(rules_ ? std::move(rules_) : md_.Rules()->block_rules),
+      context_(context) {
+  if (context_ != nullptr) {
+    lines.swap(context_->lines_);
+    line_undo_.swap(context_->line_undo_);
+  }
+
+  const char* s = src.data();
+  const auto len = static_cast<SourcePos>(src.size());
 
-      b_marks.push_back(start);
-      e_marks.push_back(pos);
-      t_shift.push_back(indent);
-      s_count.push_back(offset);
-      bs_count.push_back(0);
+  // counting is much cheaper than growing the array
+  lines.reserve(CountNewlines(s, len) + 4);
 
-      indent_found = false;
-      indent = 0;
+  ForEachLine(s, len, [&](SourcePos begin, SourcePos first, SourcePos end) {
+    const int indent = static_cast<int>(first - begin);
+    int offset = indent;
+    if (indent > 0 && std::memchr(s + begin, '\t', indent) != nullptr) {
       offset = 0;
-      start = pos + 1;
+      for (SourcePos i = begin; i < first; i++) {
+        offset += s[i] == 0x09 ? 4 - (offset % 4) : 1;
+      }
     }
 
-    pos++;
-  }
+    lines.push_back(LineInfo{begin, end, indent, offset, 0});
+  });
+
+  lines.push_back(LineInfo{len, len, 0, 0, 0});
 
-  b_marks.push_back(len);
-  e_marks.push_back(len);
-  t_shift.push_back(0);
-  s_count.push_back(0);
-  bs_count.push_back(0);
+  line_max = static_cast<int>(lines.size()) - 1;
+}
+
+StateBlock::~StateBlock() {
+  if (context_ == nullptr) return;
 
-  line_max = static_cast<int>(b_marks.size()) - 1;
+  // keep the capacity for the next parse
+  lines.clear();
+  lines.swap(context_->lines_);
+  line_undo_.clear();
+  line_undo_.swap(context_->line_undo_);
 }
 
-Token& StateBlock::Push(const std::string& type, const std::string& tag,
-                        Nesting nesting) {
+Token& StateBlock::Push(TokenType type, TokenTag tag, Nesting nesting) {
   tokens.emplace_back(type, tag, nesting);
   Token& token = tokens.back();
   token.block = true;
@@ -102,21 +215,35 @@ Token& StateBlock::Push(const std::string& type, const std::string& tag,
   return token;
 }
 
+LineInfo& StateBlock::SaveLine(int line) {
+  line_undo_.push_back(SavedLine{line, lines[line]});
+  return lines[line];
+}
+
+void StateBlock::Rollback(LineCheckpoint checkpoint) {
+  // newest first, so a line saved twice ends up with its oldest record
+  while (line_undo_.size() > checkpoint) {
+    const SavedLine& saved = line_undo_.back();
+    lines[saved.line] = saved.info;
+    line_undo_.pop_back();
+  }
+}
+
 bool StateBlock::IsEmpty(int line) const {
-  return b_marks[line] + t_shift[line] >= e_marks[line];
+  return lines[line].First() >= lines[line].e_mark;
 }
 
 int StateBlock::SkipEmptyLines(int from) const {
   for (int max = line_max; from < max; from++) {
-    if (b_marks[from] + t_shift[from] < e_marks[from]) {
+    if (lines[from].First() < lines[from].e_mark) {
       break;
     }
   }
   return from;
 }
 
-int StateBlock::SkipSpaces(int pos) const {
-  int max = src.size();
+SourcePos StateBlock::SkipSpaces(SourcePos pos) const {
+  const auto max = static_cast<SourcePos>(src.size());
   while (pos < max) {
     unsigned char ch = src[pos];
     if (!Utils::IsSpace(ch)) break;
@@ -125,7 +252,7 @@ int StateBlock::SkipSpaces(int pos) const {
   return pos;
 }
 
-int StateBlock::SkipSpacesBack(int pos, int min) const {
+SourcePos StateBlock::SkipSpacesBack(SourcePos pos, SourcePos min) const {
   if (pos <= min) return pos;
 
   while (pos > min) {
@@ -136,8 +263,8 @@ int StateBlock::SkipSpacesBack(int pos, int min) const {
   return pos;
 }
 
-int StateBlock::SkipChars(int pos, int code) const {
-  int max = src.size();
+SourcePos StateBlock::SkipChars(SourcePos pos, int code) const {
+  const auto max = static_cast<SourcePos>(src.size());
   while (pos < max) {
     if ((unsigned char)src[pos] != code) break;
     pos++;
@@ -145,7 +272,8 @@ int StateBlock::SkipChars(int pos, int code) const {
   return pos;
 }
 
-int StateBlock::SkipCharsBack(int pos, int code, int min) const {
+SourcePos StateBlock::SkipCharsBack(SourcePos pos, int code,
+                                    SourcePos min) const {
   if (pos <= min) return pos;
 
   while (pos > min) {
@@ -155,61 +283,126 @@ int StateBlock::SkipCharsBack(int pos, int code, int min) const {
   return pos;
 }
 
-std::string StateBlock::GetLines(int begin, int end, int indent,
-                                 bool keepLastLF) const {
-  if (begin >= end) return "";
-
-  std::vector<std::string> out;
-  out.reserve(end - begin);
-
-  for (int line = begin; line < end; line++) {
-    int line_indent = 0;
-    int line_start = b_marks[line];
-    int first = line_start;
-    int last;
-
-    if (line + 1 < end || keepLastLF) {
-      last = e_marks[line] + 1;  // include LF
+// Skip up to `indent` columns of indentation of `line`, stopping at `last`.
+// Returns the first kept position; `line_indent` receives the columns skipped,
+// which exceeds `indent` when a tab had to be split.
+static SourcePos StripIndent(const StateBlock& state, int line,
+                             SourcePos last, int indent, int* line_indent) {
+  const LineInfo& info = state.lines[line];
+  const SourcePos line_start = info.b_mark;
+  SourcePos first = line_start;
+  *line_indent = 0;
+
+  // compute indent mask
+  while (first < last && *line_indent < indent) {
+    unsigned char ch = state.src[first];
+
+    if (Utils::IsSpace(ch)) {
+      if (ch == 0x09) {
+        // tab expansion respects bs_count (blockquote hacks)
+        *line_indent += 4 - (*line_indent + info.bs_count) % 4;
+      } else {
+        (*line_indent)++;
+      }
+    } else if (first - line_start < info.t_shift) {
+      // masked region (blockquote markers etc)
+      (*line_indent)++;
     } else {
-      last = e_marks[line];  // exclude LF
+      break;
     }
+    first++;
+  }
+
+  return first;
+}
 
-    // compute indent mask
-    while (first < last && line_indent < indent) {
-      unsigned char ch = src[first];
+// Part of `line` kept by `GetLines`: spaces standing for a split tab, then
+// the source range `[first, last)`.
+struct LineSlice {
+  int spaces;
+  SourcePos first;
+  SourcePos last;
+};
+
+static LineSlice SliceLine(const StateBlock& state, int line, int end,
+                           int indent, bool keep_last_lf) {
+  const SourcePos e_mark = state.lines[line].e_mark;
+  SourcePos last = (line + 1 < end || keep_last_lf) ? e_mark + 1  // LF
+                                                     : e_mark;
+  last = std::min(last, static_cast<SourcePos>(state.src.size()));
+
+  int line_indent = 0;
+  const SourcePos first = StripIndent(state, line, last, indent, &line_indent);
+
+  // partial tab expansion
+  const int spaces = line_indent > indent ? line_indent - indent : 0;
+  return LineSlice{spaces, first, last};
+}
 
-      if (Utils::IsSpace(ch)) {
-        if (ch == 0x09) {
-          // tab expansion respects bs_count (blockquote hacks)
-          line_indent += 4 - (line_indent + bs_count[line]) % 4;
-        } else {
-          line_indent++;
-        }
-      } else if (first - line_start < t_shift[line]) {
-        // masked region (blockquote markers etc)
-        line_indent++;
-      } else {
-        break;
-      }
-      first++;
-    }
+template <typename String>
+static void AppendLinesTo(const StateBlock& state, int begin, int end,
+                          int indent, bool keep_last_lf, String& out) {
+  if (begin >= end) return;
 
-    if (line_indent > indent) {
-      // partial tab expansion
-      int extra = line_indent - indent;
-      out.emplace_back(std::string(extra, ' ') +
-                       src.substr(first, last - first));
-    } else {
-      out.emplace_back(src.substr(first, last - first));
-    }
+  // measure first, so that the bytes are copied once into a single buffer
+  std::size_t size = out.size();
+  for (int line = begin; line < end; line++) {
+    const LineSlice slice = SliceLine(state, line, end, indent, keep_last_lf);
+    size += slice.spaces + (slice.last - slice.first);
   }
+  out.reserve(size);
 
+  for (int line = begin; line < end; line++) {
+    const LineSlice slice = SliceLine(state, line, end, indent, keep_last_lf);
+    out.append(slice.spaces, ' ');
+    out.append(state.src, slice.first, slice.last - slice.first);
+  }
+}
+
+std::string StateBlock::GetLines(int begin, int end, int indent,
+                                 bool keep_last_lf) const {
   std::string result;
-  result.reserve(64 * (end - begin));  // speed
+  AppendLinesTo(*this, begin, end, indent, keep_last_lf, result);
+  return result;
+}
 
-  for (std::string& s : out) result += s;
+void StateBlock::AppendLines(int begin, int end, int indent, bool keep_last_lf,
+                             std::string& out) const {
+  AppendLinesTo(*this, begin, end, indent, keep_last_lf, out);
+}
 
-  return result;
+void StateBlock::AppendLines(int begin, int end, int indent, bool keep_last_lf,
+                             std::pmr::string& out) const {
+  AppendLinesTo(*this, begin, end, indent, keep_last_lf, out);
+}
+
+std::optional<std::string_view> StateBlock::GetLinesView(
+    int begin, int end, int indent, bool keep_last_lf) const {
+  if (begin >= end) return std::string_view();
+
+  const auto len = static_cast<SourcePos>(src.size());
+  SourcePos view_begin = 0;
+  SourcePos view_end = 0;
+
+  for (int line = begin; line < end; line++) {
+    int line_indent = 0;
+    SourcePos last = (line + 1 < end || keep_last_lf) ? lines[line].e_mark + 1
+                                                       : lines[line].e_mark;
+    SourcePos first = StripIndent(*this, line, last, indent, &line_indent);
+
+    // partial tab expansion inserts spaces that are not in the source
+    if (line_indent > indent) return std::nullopt;
+
+    if (line == begin) {
+      view_begin = first;
+    } else if (first != view_end) {
+      // stripped indentation (or blockquote markers) between two lines
+      return std::nullopt;
+    }
+    view_end = std::min(last, len);
+  }
+
+  return std::string_view(src).substr(view_begin, view_end - view_begin);
 }
 
 }  // namespace aethermark
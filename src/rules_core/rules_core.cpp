@@ -3,9 +3,15 @@
 
 #include "aethermark/rules_core/rules_core.hpp"
 
-#include <deque>
-#include <optional>
-#include <regex>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -14,29 +20,147 @@
 
 namespace aethermark {
 
+namespace {
+
+// Normalization looks for the bytes it rewrites 64 at a time with the widest
+// vectors the build targets.
+constexpr std::size_t kBlock = 64;
+
+// Inline content bytes per child token, low enough to cover prose and table
+// cells before text_join merges their text tokens.
+constexpr std::size_t kContentBytesPerChild = 32;
+
+// Bit `i` is set when byte `i` of the block is a carriage return or a NUL.
+#if defined(__AVX2__)
+inline std::uint64_t ScanSpecials(const char* p) {
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < kBlock; i += 32) {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    const __m256i special =
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                        _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+    mask |= std::uint64_t{static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(special))}
+            << i;
+  }
+  return mask;
+}
+#elif defined(__SSE2__)
+inline std::uint64_t ScanSpecials(const char* p) {
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < kBlock; i += 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    const __m128i special =
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                     _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+    mask |= std::uint64_t{static_cast<std::uint32_t>(
+                _mm_movemask_epi8(special))}
+            << i;
+  }
+  return mask;
+}
+#else
+inline std::uint64_t ScanSpecials(const char* p) {
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < kBlock; i++) {
+    mask |= std::uint64_t{p[i] == '\r' || p[i] == '\0'} << i;
+  }
+  return mask;
+}
+#endif
+
+// Classify the block at `base`, ignoring bytes past the end of the string.
+inline std::uint64_t ScanSpecialsAt(const std::string& s, std::size_t base) {
+  const std::size_t left = s.size() - base;
+  if (left >= kBlock) return ScanSpecials(s.data() + base);
+
+  char tail[kBlock] = {};
+  std::memcpy(tail, s.data() + base, left);
+  return ScanSpecials(tail) & ((std::uint64_t{1} << left) - 1);
+}
+
+// Rewrite CR and CRLF to LF and NUL to U+FFFD in a single pass. Returns
+// `false`, leaving `src` untouched, when there is nothing to rewrite.
+bool NormalizeSource(std::string& src) {  // NOLINT(runtime/references)
+  std::size_t base = 0;
+  std::uint64_t mask = 0;
+  while (base < src.size() && (mask = ScanSpecialsAt(src, base)) == 0) {
+    base += kBlock;
+  }
+  if (mask == 0) return false;
+
+  std::string out;
+  out.reserve(src.size());
+  out.append(src, 0, base);
+
+  // only the LF of a CRLF is ever skipped, and LFs are not in the masks, so
+  // every flagged byte is at or after the cursor
+  std::size_t cursor = base;  // first byte not yet copied to `out`
+  for (;;) {
+    for (; mask != 0; mask &= mask - 1) {
+      const std::size_t pos = base + std::countr_zero(mask);
+      out.append(src, cursor, pos - cursor);
+      cursor = pos + 1;
+
+      if (src[pos] == '\r') {
+        out += '\n';
+        if (cursor < src.size() && src[cursor] == '\n') cursor++;
+      } else {
+        out += "\xEF\xBF\xBD";
+      }
+    }
+
+    base += kBlock;
+    if (base >= src.size()) break;
+    mask = ScanSpecialsAt(src, base);
+  }
+  out.append(src, cursor, std::string::npos);
+
+  src.swap(out);
+  return true;
+}
+
+}  // namespace
+
 void CoreRules::RuleBlock(StateCore& state) {  // NOLINT(runtime/references)
-  Token t = Token("", "", Nesting::kSelfClosing);
   if (state.inline_mode) {
-    Token t = Token("inline", "", Nesting::kSelfClosing);
-    t.content = state.src;
+    Token& t = state.tokens.emplace_back(TokenKind::kInline, HtmlTag::kNone,
+                                         Nesting::kSelfClosing);
+    t.content.Borrow(state.src);
     t.map = std::pair<float, float>({0, 1});
-    t.children = std::optional<std::deque<Token>>({});
-    state.tokens.push_back(t);
   } else {
-    state.md.block_parser.Parse(state.src, state.md, state.env, state.tokens);
+    state.md.block_parser.Parse(state.src, state.md, state.env, state.tokens,
+                                state.context, state.rules->block_rules);
   }
 }
 
 void CoreRules::RuleInline(StateCore& state) {  // NOLINT(runtime/references)
-  const std::deque<Token>& tokens = state.tokens;
-
-  // Parse inline
-  for (int i = 0, l = tokens.size(); i < l; ++i) {
-    const Token& tok = tokens[i];
-    if (tok.type == "inline") {
-      // TODO(MukulWaval): uncomment once inline parser is complete
-      // state.md.inlineParser.parse(tok.GetContent(), state.md, state.env,
-      // state.tokens);
+  TokenList& tokens = state.tokens;
+  const ParserInline& parser = state.md.inline_parser;
+
+  // Rules of the parse's configuration, so every inline token of the
+  // document is parsed with the same rules as its blocks
+  const RuleChains<aethermark::RuleInline>& rules = *state.rules->inline_rules;
+  const RuleChains<RuleInline2>& rules2 = *state.rules->inline_rules2;
+
+  // Children go to the end of the list; reserve for them at once, one per
+  // parent plus one per `kContentBytesPerChild` of content, so a large
+  // document grows the buffer once instead of doubling it past its need
+  std::size_t parents = 0;
+  std::size_t content_bytes = 0;
+  for (const Token& token : tokens.Roots()) {
+    if (token.type != TokenKind::kInline) continue;
+    parents++;
+    content_bytes += token.content.size();
+  }
+  tokens.reserve(tokens.size() + parents +
+                 content_bytes / kContentBytesPerChild);
+
+  // Parse inline. Children go to the end of the list, so iterate by index
+  for (auto it = tokens.Roots().begin(); it != tokens.Roots().end(); ++it) {
+    if (it->type == TokenKind::kInline) {
+      parser.Parse(tokens, it.Index(), state.md, state.env, rules, rules2);
     }
   }
 }
@@ -45,12 +169,7 @@ void CoreRules::RuleInline(StateCore& state) {  // NOLINT(runtime/references)
 void CoreRules::RuleLinkify(StateCore& state) {}  // NOLINT(runtime/references)
 
 void CoreRules::RuleNormalize(StateCore& state) {  // NOLINT(runtime/references)
-  const std::regex kNewlineRe(R"(\r\n?|\n)");
-  const std::regex kNullRe(std::string("\x00", 1));
-
-  std::string str = std::regex_replace(state.src, kNewlineRe, "\n");
-  str = std::regex_replace(str, kNullRe, "\xEF\xBF\xBD");
-  state.src = str;
+  NormalizeSource(state.src);
 }
 
 // FIXME: implement replacements rule
@@ -61,36 +180,18 @@ void CoreRules::RuleSmartquotes(StateCore& state) {
 }  // NOLINT(runtime/references)
 
 void CoreRules::RuleTextJoin(StateCore& state) {  // NOLINT(runtime/references)
-  int curr, last;
-  std::deque<Token> block_tokens = state.tokens;
-  int l = block_tokens.size();
+  TokenList& block_tokens = state.tokens;
 
-  for (int j = 0; j < l; j++) {
-    if (block_tokens[j].type == "inline") {
-      continue;
-    }
+  for (auto it = block_tokens.Roots().begin(); it != block_tokens.Roots().end();
+       ++it) {
+    if (it->type != TokenKind::kInline) continue;
 
-    std::optional<std::deque<Token>> tokens = block_tokens[j].children;
-    int max;
-    if (!tokens.has_value()) {
-      max = 0;
-    } else {
-      max = tokens->size();
+    // text_special only exists to keep escapes away from other rules
+    for (Token& token : block_tokens.Children(*it)) {
+      if (token.type == TokenKind::kTextSpecial) token.type = TokenKind::kText;
     }
 
-    for (curr = 0, last = 0; curr < max; curr++) {
-      // collapse two adjacent text nodes
-      if (tokens->at(curr).type == "text" && curr + 1 < max &&
-          tokens->at(curr + 1).type == "text") {
-        tokens->at(curr + 1).content =
-            tokens->at(curr).content + tokens->at(curr + 1).content;
-      } else {
-        if (curr != last) {
-          tokens->at(last) = tokens->at(curr);
-        }
-        last++;
-      }
-    }
+    block_tokens.JoinTextChildren(it.Index());
   }
 }
 
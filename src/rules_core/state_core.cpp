@@ -7,7 +7,8 @@
 
 namespace aethermark {
 
-StateCore::StateCore(const std::string& src, Aethermark& md, std::any env)
-    : src(src), md(md), env(env) {}
+StateCore::StateCore(std::string& src, Aethermark& md, ParseEnv& env,
+                     TokenList& tokens)
+    : src(src), env(env), tokens(tokens), md(md) {}
 
 }  // namespace aethermark
@@ -0,0 +1,984 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/rules_inline/rules_inline.hpp"
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/entities.hpp"
+#include "aethermark/link_helpers.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/utils.hpp"
+
+namespace aethermark {
+
+namespace {
+
+// Characters ending a run of plain text, the same set as markdown-it
+constexpr std::string_view kTerminatorChars = "\n!#$%&*+-:<=@[\\]^_`{}~";
+
+constexpr std::array<bool, 256> MakeTerminatorTable() {
+  std::array<bool, 256> table{};
+  for (char c : kTerminatorChars) table[static_cast<unsigned char>(c)] = true;
+  return table;
+}
+
+constexpr std::array<bool, 256> kTerminators = MakeTerminatorTable();
+
+// Text is scanned a vector at a time for candidate terminators, then each
+// candidate is checked against the table. With SSSE3 a nibble lookup gives
+// the exact set; plain SSE2 flags every ASCII punctuation byte and newline.
+#if defined(__AVX2__) || defined(__SSSE3__)
+// Entry `lo` has bit `hi` set when byte `hi << 4 | lo` is a terminator. Only
+// ASCII has terminators, so eight bits are enough.
+constexpr std::array<std::uint8_t, 16> MakeLowNibbleTable() {
+  std::array<std::uint8_t, 16> table{};
+  for (int c = 0; c < 128; ++c) {
+    if (kTerminators[c]) table[c & 0x0F] |= 1u << (c >> 4);
+  }
+  return table;
+}
+
+constexpr std::array<std::uint8_t, 16> MakeHighNibbleTable() {
+  std::array<std::uint8_t, 16> table{};
+  for (int hi = 0; hi < 8; ++hi) table[hi] = 1u << hi;
+  return table;
+}
+
+alignas(16) constexpr std::array<std::uint8_t, 16> kLowNibbles =
+    MakeLowNibbleTable();
+alignas(16) constexpr std::array<std::uint8_t, 16> kHighNibbles =
+    MakeHighNibbleTable();
+#endif
+
+#if defined(__AVX2__)
+constexpr std::size_t kBlock = 32;
+
+inline std::uint32_t TerminatorCandidates(const char* p) {
+  const __m256i lo_table = _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(kLowNibbles.data())));
+  const __m256i hi_table = _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(kHighNibbles.data())));
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  const __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, nibble));
+  const __m256i hi = _mm256_shuffle_epi8(
+      hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+  const __m256i none =
+      _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+  return ~static_cast<std::uint32_t>(_mm256_movemask_epi8(none));
+}
+#elif defined(__SSSE3__)
+constexpr std::size_t kBlock = 16;
+
+inline std::uint32_t TerminatorCandidates(const char* p) {
+  const __m128i lo_table =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(kLowNibbles.data()));
+  const __m128i hi_table =
+      _mm_load_si128(reinterpret_cast<const __m128i*>(kHighNibbles.data()));
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  const __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, nibble));
+  const __m128i hi =
+      _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+  const __m128i none =
+      _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+  return ~static_cast<std::uint32_t>(_mm_movemask_epi8(none)) & 0xFFFFu;
+}
+#elif defined(__SSE2__)
+constexpr std::size_t kBlock = 16;
+
+// Bytes in [first, last]; signed compares are fine as the ranges are ASCII
+inline __m128i InRange(__m128i v, char first, char last) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(first - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(last + 1)));
+}
+
+inline std::uint32_t TerminatorCandidates(const char* p) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  __m128i hit = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+  hit = _mm_or_si128(hit, InRange(v, '!', '/'));
+  hit = _mm_or_si128(hit, InRange(v, ':', '@'));
+  hit = _mm_or_si128(hit, InRange(v, '[', '`'));
+  hit = _mm_or_si128(hit, InRange(v, '{', '~'));
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(hit));
+}
+#endif
+
+constexpr std::string_view kEscapable = "\\!\"#$%&'()*+,./:;<=>?@[]^_`{|}~-";
+
+// Length of the UTF-8 sequence starting with `lead`, 1 for stray bytes
+std::size_t Utf8Length(unsigned char lead) {
+  if (lead >= 0xF0) return 4;
+  if (lead >= 0xE0) return 3;
+  if (lead >= 0xC0) return 2;
+  return 1;
+}
+
+// Skip spaces, tabs and newlines between the parts of an inline link
+std::size_t SkipLinkSpaces(std::string_view src, std::size_t pos,
+                           std::size_t max) {
+  while (pos < max && (Utils::IsSpace(src[pos]) || src[pos] == '\n')) pos++;
+  return pos;
+}
+
+bool IsAsciiAlpha(char c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+
+bool IsAsciiAlnum(char c) { return IsAsciiAlpha(c) || (c >= '0' && c <= '9'); }
+
+// ^[a-zA-Z][a-zA-Z0-9+.-]{1,31}:[^<>\x00-\x20]*$
+bool IsAutolinkUrl(std::string_view url) {
+  if (url.empty() || !IsAsciiAlpha(url[0])) return false;
+
+  std::size_t pos = 1;
+  while (pos < url.size() && (IsAsciiAlnum(url[pos]) || url[pos] == '+' ||
+                              url[pos] == '.' || url[pos] == '-')) {
+    pos++;
+  }
+  if (pos < 2 || pos > 32 || pos >= url.size() || url[pos] != ':') {
+    return false;
+  }
+
+  for (pos++; pos < url.size(); pos++) {
+    const auto c = static_cast<unsigned char>(url[pos]);
+    if (c <= 0x20 || c == '<' || c == '>') return false;
+  }
+  return true;
+}
+
+// A domain label: [a-zA-Z0-9](?:[a-zA-Z0-9-]{0,61}[a-zA-Z0-9])?
+bool IsDomainLabel(std::string_view label) {
+  if (label.empty() || label.size() > 63) return false;
+  if (!IsAsciiAlnum(label.front()) || !IsAsciiAlnum(label.back())) {
+    return false;
+  }
+  for (char c : label) {
+    if (!IsAsciiAlnum(c) && c != '-') return false;
+  }
+  return true;
+}
+
+// ^[a-zA-Z0-9.!#$%&'*+/=?^_`{|}~-]+@<label>(?:\.<label>)*$
+bool IsEmail(std::string_view url) {
+  constexpr std::string_view kLocalPunct = ".!#$%&'*+/=?^_`{|}~-";
+
+  const std::size_t at = url.find('@');
+  if (at == 0 || at == std::string_view::npos) return false;
+  for (char c : url.substr(0, at)) {
+    if (!IsAsciiAlnum(c) && kLocalPunct.find(c) == std::string_view::npos) {
+      return false;
+    }
+  }
+
+  std::string_view domain = url.substr(at + 1);
+  for (;;) {
+    const std::size_t dot = domain.find('.');
+    if (!IsDomainLabel(domain.substr(0, dot))) return false;
+    if (dot == std::string_view::npos) return true;
+    domain.remove_prefix(dot + 1);
+  }
+}
+
+bool StartsWithNoCase(std::string_view s, std::string_view prefix) {
+  if (s.size() < prefix.size()) return false;
+  for (std::size_t i = 0; i < prefix.size(); ++i) {
+    if ((s[i] | 0x20) != prefix[i]) return false;
+  }
+  return true;
+}
+
+// <a[>\s] and <\/a\s*>, ignoring case
+bool IsLinkOpen(std::string_view html) {
+  return StartsWithNoCase(html, "<a") && html.size() > 2 &&
+         (html[2] == '>' || Utils::IsSpace(html[2]) || html[2] == '\n');
+}
+
+bool IsLinkClose(std::string_view html) {
+  if (!StartsWithNoCase(html, "</a")) return false;
+  std::size_t pos = 3;
+  while (pos < html.size() &&
+         (Utils::IsSpace(html[pos]) || html[pos] == '\n')) {
+    pos++;
+  }
+  return pos < html.size() && html[pos] == '>';
+}
+
+// Smallest opener index worth trying for a closer, per marker and per
+// (closer can open, closer length % 3). Openers at or below it were already
+// rejected by an earlier closer of the same kind, which keeps matching linear.
+class OpenersBottom {
+ public:
+  explicit OpenersBottom(const std::pmr::polymorphic_allocator<>& alloc)
+      : markers_(alloc), bottoms_(alloc) {}
+
+  int& At(char marker, bool open, int length) {
+    std::size_t i = 0;
+    while (i < markers_.size() && markers_[i] != marker) i++;
+    if (i == markers_.size()) {
+      markers_.push_back(marker);
+      bottoms_.push_back({-1, -1, -1, -1, -1, -1});
+    }
+    return bottoms_[i][(open ? 3 : 0) + length % 3];
+  }
+
+ private:
+  // Few distinct markers per inline, so a linear search is the fastest map
+  std::pmr::vector<char> markers_;
+  std::pmr::vector<std::array<int, 6>> bottoms_;
+};
+
+// Pair openers and closers of one delimiter list, setting `end` of openers.
+// Runs of paired delimiters are skipped with `jumps` so each closer looks at
+// each unpaired opener at most once.
+void ProcessDelimiters(DelimiterList& delimiters) {
+  const int max = static_cast<int>(delimiters.size());
+  if (max == 0) return;
+
+  OpenersBottom openers_bottom(delimiters.get_allocator());
+
+  // header_idx is the first delimiter of the current (where closer is)
+  // delimiter run
+  int header_idx = 0;
+  std::size_t last_token_idx = static_cast<std::size_t>(-2);
+  std::pmr::vector<int> jumps(delimiters.get_allocator());
+  jumps.reserve(max);
+
+  for (int closer_idx = 0; closer_idx < max; closer_idx++) {
+    Delimiter& closer = delimiters[closer_idx];
+
+    jumps.push_back(0);
+
+    // markers belong to same delimiter run if:
+    //  - they have adjacent tokens
+    //  - AND markers are the same
+    if (delimiters[header_idx].marker != closer.marker ||
+        last_token_idx != closer.token - 1) {
+      header_idx = closer_idx;
+    }
+
+    last_token_idx = closer.token;
+
+    if (!closer.close) continue;
+
+    int& min_opener_idx =
+        openers_bottom.At(closer.marker, closer.open, closer.length);
+    int opener_idx = header_idx - jumps[header_idx] - 1;
+    int new_min_opener_idx = opener_idx;
+
+    for (; opener_idx > min_opener_idx;
+         opener_idx -= jumps[opener_idx] + 1) {
+      Delimiter& opener = delimiters[opener_idx];
+
+      if (opener.marker != closer.marker) continue;
+
+      if (opener.open && opener.end < 0) {
+        bool is_odd_match = false;
+
+        // from spec:
+        //
+        // If one of the delimiters can both open and close emphasis, then
+        // the sum of the lengths of the delimiter runs containing the
+        // opening and closing delimiters must not be a multiple of 3 unless
+        // both lengths are multiples of 3.
+        if (opener.close || closer.open) {
+          if ((opener.length + closer.length) % 3 == 0) {
+            if (opener.length % 3 != 0 || closer.length % 3 != 0) {
+              is_odd_match = true;
+            }
+          }
+        }
+
+        if (!is_odd_match) {
+          // If previous delimiter cannot be an opener, we can safely skip
+          // the entire sequence in future checks. This is required to make
+          // sure algorithm has linear complexity (see *_*_*_*_*_... case).
+          const int last_jump =
+              opener_idx > 0 && !delimiters[opener_idx - 1].open
+                  ? jumps[opener_idx - 1] + 1
+                  : 0;
+
+          jumps[closer_idx] = closer_idx - opener_idx + last_jump;
+          jumps[opener_idx] = last_jump;
+
+          closer.open = false;
+          opener.end = closer_idx;
+          opener.close = false;
+          new_min_opener_idx = -1;
+          // treat next token as start of run, it optimizes skips in
+          // **<...>**a**<...>** pathological case
+          last_token_idx = static_cast<std::size_t>(-2);
+          break;
+        }
+      }
+    }
+
+    if (new_min_opener_idx != -1) {
+      // If match for this delimiter run failed, we want to set lower bound
+      // for future lookups. This is required to make sure algorithm has
+      // linear complexity.
+      //
+      // See details here:
+      // https://github.com/commonmark/cmark/issues/178#issuecomment-270417442
+      openers_bottom.At(closer.marker, closer.open, closer.length) =
+          new_min_opener_idx;
+    }
+  }
+}
+
+// Turn paired `*` and `_` delimiters of one list into em and strong tokens
+void EmphasisPostProcess(StateInline& state, const DelimiterList& delimiters) {
+  std::span<Token> tokens = state.Children();
+
+  for (int i = static_cast<int>(delimiters.size()) - 1; i >= 0; i--) {
+    const Delimiter& start_delim = delimiters[i];
+
+    if (start_delim.marker != '_' && start_delim.marker != '*') continue;
+
+    // Process only opening markers
+    if (start_delim.end == -1) continue;
+
+    const Delimiter& end_delim = delimiters[start_delim.end];
+
+    // If the previous delimiter has the same marker and is adjacent to this
+    // one, merge those into one strong delimiter.
+    //
+    // `<em><em>whatever</em></em>` -> `<strong>whatever</strong>`
+    const bool is_strong =
+        i > 0 && delimiters[i - 1].end == start_delim.end + 1 &&
+        // check that first two markers match and adjacent
+        delimiters[i - 1].marker == start_delim.marker &&
+        delimiters[i - 1].token == start_delim.token - 1 &&
+        // check that last two markers are adjacent (we can safely assume they
+        // match)
+        delimiters[start_delim.end + 1].token == end_delim.token + 1;
+
+    Token& token_o = tokens[start_delim.token];
+    token_o.type = is_strong ? TokenKind::kStrongOpen : TokenKind::kEmOpen;
+    token_o.tag = is_strong ? HtmlTag::kStrong : HtmlTag::kEm;
+    token_o.nesting = Nesting::kOpening;
+    token_o.markup.assign(is_strong ? 2 : 1, start_delim.marker);
+    token_o.content = std::string_view();
+
+    Token& token_c = tokens[end_delim.token];
+    token_c.type = is_strong ? TokenKind::kStrongClose : TokenKind::kEmClose;
+    token_c.tag = is_strong ? HtmlTag::kStrong : HtmlTag::kEm;
+    token_c.nesting = Nesting::kClosing;
+    token_c.markup = token_o.markup;
+    token_c.content = std::string_view();
+
+    if (is_strong) {
+      tokens[delimiters[i - 1].token].content = std::string_view();
+      tokens[delimiters[start_delim.end + 1].token].content =
+          std::string_view();
+      i--;
+    }
+  }
+}
+
+}  // namespace
+
+bool InlineRules::IsTerminator(unsigned char c) { return kTerminators[c]; }
+
+std::size_t InlineRules::SkipText(std::string_view src, std::size_t pos) {
+  const char* p = src.data();
+  const std::size_t n = src.size();
+
+#if defined(__AVX2__) || defined(__SSSE3__) || defined(__SSE2__)
+  for (; pos + kBlock <= n; pos += kBlock) {
+    for (std::uint32_t mask = TerminatorCandidates(p + pos); mask != 0;
+         mask &= mask - 1) {
+      const std::size_t i = pos + std::countr_zero(mask);
+      if (kTerminators[static_cast<unsigned char>(p[i])]) return i;
+    }
+  }
+#endif
+
+  while (pos < n && !kTerminators[static_cast<unsigned char>(p[pos])]) pos++;
+  return pos;
+}
+
+// NOLINTBEGIN(runtime/references)
+
+bool InlineRules::RuleAutolink(StateInline& state, bool silent) {
+  std::size_t pos = state.pos;
+  if (state.src[pos] != '<') return false;
+
+  const std::size_t start = pos;
+  const std::size_t max = state.pos_max;
+
+  for (;;) {
+    if (++pos >= max) return false;
+    const char ch = state.src[pos];
+    if (ch == '<') return false;
+    if (ch == '>') break;
+  }
+
+  const std::size_t url_begin = start + 1;
+  const std::string_view url = state.src.substr(url_begin, pos - url_begin);
+
+  std::string full_url;
+  if (IsAutolinkUrl(url)) {
+    full_url = state.md.NormalizeLink(std::string(url));
+  } else if (IsEmail(url)) {
+    full_url = state.md.NormalizeLink("mailto:" + std::string(url));
+  } else {
+    return false;
+  }
+  if (!state.md.ValidateLink(full_url)) return false;
+
+  if (!silent) {
+    Token& token_o = state.Push(TokenKind::kLinkOpen, HtmlTag::kA,
+                                Nesting::kOpening);
+    token_o.AttrSet(AttrKind::kHref, full_url);
+    token_o.markup = "autolink";
+    token_o.info = "auto";
+
+    Token& token_t =
+        state.Push(TokenKind::kText, HtmlTag::kNone, Nesting::kSelfClosing);
+    const std::string text = state.md.NormalizeLinkText(std::string(url));
+    if (text == url) {
+      state.SetContent(token_t, url_begin, pos);
+    } else {
+      token_t.content = text;
+    }
+
+    Token& token_c = state.Push(TokenKind::kLinkClose, HtmlTag::kA,
+                                Nesting::kClosing);
+    token_c.markup = "autolink";
+    token_c.info = "auto";
+  }
+
+  state.pos = pos + 1;
+  return true;
+}
+
+bool InlineRules::RuleBackticks(StateInline& state, bool silent) {
+  std::size_t pos = state.pos;
+  if (state.src[pos] != '`') return false;
+
+  const std::size_t start = pos;
+  const std::size_t max = state.pos_max;
+  const std::string_view src = state.src;
+  pos++;
+
+  // Scan marker length
+  while (pos < max && src[pos] == '`') pos++;
+
+  const std::size_t opener_length = pos - start;
+  std::vector<std::size_t>& closers = state.backticks;
+
+  // No closer of that length after the opener: the marker is plain text
+  const auto keep_as_text = [&]() {
+    if (!silent) state.AddPending(start, pos);
+    state.pos = pos;
+    return true;
+  };
+
+  if (state.backticks_scanned &&
+      (opener_length >= closers.size() || closers[opener_length] <= start)) {
+    return keep_as_text();
+  }
+
+  std::size_t match_end = pos;
+
+  // Nothing found in the cache, scan until the end of the content
+  for (;;) {
+    const void* hit =
+        std::memchr(src.data() + match_end, '`', src.size() - match_end);
+    if (hit == nullptr) break;
+
+    const std::size_t match_start = static_cast<const char*>(hit) - src.data();
+    match_end = match_start + 1;
+
+    // Scan marker length
+    while (match_end < max && src[match_end] == '`') match_end++;
+
+    const std::size_t closer_length = match_end - match_start;
+
+    if (closer_length == opener_length) {
+      // Found matching closer length
+      if (!silent) {
+        Token& token = state.Push(TokenKind::kCodeInline, HtmlTag::kCode,
+                                  Nesting::kSelfClosing);
+        token.markup = src.substr(start, opener_length);
+
+        // Line endings become spaces, then one space is stripped from each
+        // side when both are present
+        std::string_view body = src.substr(pos, match_start - pos);
+        if (body.find('\n') == std::string_view::npos) {
+          std::size_t begin = pos;
+          std::size_t end = match_start;
+          if (body.size() >= 3 && body.front() == ' ' && body.back() == ' ') {
+            begin++;
+            end--;
+          }
+          state.SetContent(token, begin, end);
+        } else {
+          std::pmr::string content(body, token.get_allocator());
+          for (char& c : content) {
+            if (c == '\n') c = ' ';
+          }
+          if (content.size() >= 3 && content.front() == ' ' &&
+              content.back() == ' ') {
+            content.pop_back();
+            content.erase(0, 1);
+          }
+          token.content.Assign(std::move(content));
+        }
+      }
+      state.pos = match_end;
+      return true;
+    }
+
+    // Some different length found, put it in cache as upper limit of where
+    // closer can be found
+    if (closer_length >= closers.size()) closers.resize(closer_length + 1, 0);
+    closers[closer_length] = match_start;
+  }
+
+  // Scanned through the end, didn't find anything
+  state.backticks_scanned = true;
+
+  return keep_as_text();
+}
+
+// Insert each marker as a separate text token, and add it to the delimiter
+// list
+bool InlineRules::RuleEmphasis(StateInline& state, bool silent) {
+  const std::size_t start = state.pos;
+  const char marker = state.src[start];
+
+  if (silent) return false;
+
+  if (marker != '_' && marker != '*') return false;
+
+  const DelimiterRun scanned = state.ScanDelims(state.pos, marker == '*');
+
+  for (std::size_t i = 0; i < scanned.length; i++) {
+    Token& token =
+        state.Push(TokenKind::kText, HtmlTag::kNone, Nesting::kSelfClosing);
+    state.SetContent(token, start + i, start + i + 1);
+
+    state.delimiters.push_back(Delimiter{
+        .marker = marker,
+        .length = static_cast<int>(scanned.length),
+        .token = state.Children().size() - 1,
+        .end = -1,
+        .open = scanned.can_open,
+        .close = scanned.can_close});
+  }
+
+  state.pos += scanned.length;
+  return true;
+}
+
+bool InlineRules::RuleEntity(StateInline& state, bool silent) {
+  const std::size_t pos = state.pos;
+  const std::size_t max = state.pos_max;
+
+  if (state.src[pos] != '&' || pos + 1 >= max) return false;
+
+  const Entities::Match match =
+      Entities::Decode(state.src.substr(pos, max - pos));
+  if (!match) return false;
+
+  if (!silent) {
+    Token& token = state.Push(TokenKind::kTextSpecial, HtmlTag::kNone,
+                              Nesting::kSelfClosing);
+    token.content = match.Text();
+    token.markup = state.src.substr(pos, match.length);
+    token.info = "entity";
+  }
+
+  state.pos += match.length;
+  return true;
+}
+
+bool InlineRules::RuleEscape(StateInline& state, bool silent) {
+  std::size_t pos = state.pos;
+  const std::size_t max = state.pos_max;
+
+  if (state.src[pos] != '\\') return false;
+  pos++;
+
+  // '\' at the end of the inline block
+  if (pos >= max) return false;
+
+  const auto ch1 = static_cast<unsigned char>(state.src[pos]);
+
+  if (ch1 == '\n') {
+    if (!silent) {
+      state.Push(TokenKind::kHardbreak, HtmlTag::kBr, Nesting::kSelfClosing);
+    }
+
+    pos++;
+    // Skip leading whitespace of the next line
+    while (pos < max && Utils::IsSpace(state.src[pos])) pos++;
+
+    state.pos = pos;
+    return true;
+  }
+
+  const std::size_t escaped_begin = pos;
+  pos = std::min(pos + Utf8Length(ch1), max);
+
+  if (!silent) {
+    Token& token = state.Push(TokenKind::kTextSpecial, HtmlTag::kNone,
+                              Nesting::kSelfClosing);
+
+    if (kEscapable.find(static_cast<char>(ch1)) != std::string_view::npos) {
+      state.SetContent(token, escaped_begin, pos);
+    } else {
+      state.SetContent(token, state.pos, pos);
+    }
+
+    token.markup = state.src.substr(state.pos, pos - state.pos);
+    token.info = "escape";
+  }
+
+  state.pos = pos;
+  return true;
+}
+
+bool InlineRules::RuleHtmlInline(StateInline& state, bool silent) {
+  if (!state.md.options.html) return false;
+
+  // Check start
+  const std::size_t max = state.pos_max;
+  const std::size_t pos = state.pos;
+  if (state.src[pos] != '<' || pos + 2 >= max) return false;
+
+  // Quick fail on second char
+  const char ch = state.src[pos + 1];
+  if (ch != '!' && ch != '?' && ch != '/' && !IsAsciiAlpha(ch)) return false;
+
+  const std::size_t length =
+      Utils::MatchHtmlTag(state.src.substr(pos, max - pos));
+  if (length == 0) return false;
+
+  if (!silent) {
+    Token& token = state.Push(TokenKind::kHtmlInline, HtmlTag::kNone,
+                              Nesting::kSelfClosing);
+    state.SetContent(token, pos, pos + length);
+
+    const std::string_view html = token.content.View();
+    if (IsLinkOpen(html)) state.link_level++;
+    if (IsLinkClose(html)) state.link_level--;
+  }
+
+  state.pos += length;
+  return true;
+}
+
+bool InlineRules::RuleImage(StateInline& state, bool silent) {
+  const std::size_t old_pos = state.pos;
+  const std::size_t max = state.pos_max;
+  const std::string_view src = state.src;
+
+  if (src[old_pos] != '!' || old_pos + 1 >= max || src[old_pos + 1] != '[') {
+    return false;
+  }
+
+  const std::size_t label_start = old_pos + 2;
+  const std::size_t label_end =
+      LinkHelpers::ParseLinkLabel(state, old_pos + 1, false);
+
+  // parser failed to find ']', so it's not a valid link
+  if (label_end == std::string_view::npos) return false;
+
+  std::size_t pos = label_end + 1;
+  std::string href;
+  std::string title;
+
+  if (pos < max && src[pos] == '(') {
+    // Inline image
+    // ![alt](  <href>  "title"  )
+    //        ^^ skipping these spaces
+    pos = SkipLinkSpaces(src, pos + 1, max);
+    if (pos >= max) return false;
+
+    // ![alt](  <href>  "title"  )
+    //          ^^^^^^ parsing link destination
+    LinkDestination dest = LinkHelpers::ParseLinkDestination(src, pos, max);
+    if (dest.ok) {
+      href = state.md.NormalizeLink(dest.str);
+      if (state.md.ValidateLink(href)) {
+        pos = dest.pos;
+      } else {
+        href.clear();
+      }
+    }
+
+    // ![alt](  <href>  "title"  )
+    //                ^^ skipping these spaces
+    const std::size_t start = pos;
+    pos = SkipLinkSpaces(src, pos, max);
+
+    // ![alt](  <href>  "title"  )
+    //                  ^^^^^^^ parsing link title
+    LinkTitle res = LinkHelpers::ParseLinkTitle(src, pos, max);
+    if (pos < max && start != pos && res.ok) {
+      title = std::move(res.str);
+      pos = SkipLinkSpaces(src, res.pos, max);
+    }
+
+    if (pos >= max || src[pos] != ')') {
+      state.pos = old_pos;
+      return false;
+    }
+    pos++;
+  } else {
+    // Image reference
+    if (!state.env.HasReferences()) return false;
+
+    std::string_view label;
+    if (pos < max && src[pos] == '[') {
+      const std::size_t start = pos + 1;
+      pos = LinkHelpers::ParseLinkLabel(state, pos);
+      if (pos != std::string_view::npos) {
+        label = src.substr(start, pos - start);
+        pos++;
+      } else {
+        pos = label_end + 1;
+      }
+    }
+
+    // covers collapsed and shortcut reference images
+    if (label.empty()) label = src.substr(label_start, label_end - label_start);
+
+    const LinkReference* ref = state.env.FindReference(label);
+    if (ref == nullptr) {
+      state.pos = old_pos;
+      return false;
+    }
+    href = ref->href;
+    title = ref->title;
+  }
+
+  if (!silent) {
+    // The alt text is parsed into the image's children once the content of
+    // the parent is done, see `ParserInline::Parse`
+    Token& token =
+        state.Push(TokenKind::kImage, HtmlTag::kImg, Nesting::kSelfClosing);
+    token.AttrSet(AttrKind::kSrc, href);
+    token.AttrSet(AttrKind::kAlt, "");
+    if (!title.empty()) token.AttrSet(AttrKind::kTitle, title);
+    state.SetContent(token, label_start, label_end);
+  }
+
+  state.pos = pos;
+  state.pos_max = max;
+  return true;
+}
+
+bool InlineRules::RuleLink(StateInline& state, bool silent) {
+  const std::size_t old_pos = state.pos;
+  const std::size_t max = state.pos_max;
+  const std::string_view src = state.src;
+
+  if (src[old_pos] != '[') return false;
+
+  const std::size_t label_start = old_pos + 1;
+  const std::size_t label_end =
+      LinkHelpers::ParseLinkLabel(state, old_pos, true);
+
+  // parser failed to find ']', so it's not a valid link
+  if (label_end == std::string_view::npos) return false;
+
+  std::size_t pos = label_end + 1;
+  std::string href;
+  std::string title;
+  bool parse_reference = true;
+
+  if (pos < max && src[pos] == '(') {
+    // Inline link
+    // might have found a valid shortcut link, disable reference parsing
+    parse_reference = false;
+
+    // [link](  <href>  "title"  )
+    //        ^^ skipping these spaces
+    pos = SkipLinkSpaces(src, pos + 1, max);
+    if (pos >= max) return false;
+
+    // [link](  <href>  "title"  )
+    //          ^^^^^^ parsing link destination
+    LinkDestination dest = LinkHelpers::ParseLinkDestination(src, pos, max);
+    if (dest.ok) {
+      href = state.md.NormalizeLink(dest.str);
+      if (state.md.ValidateLink(href)) {
+        pos = dest.pos;
+      } else {
+        href.clear();
+      }
+
+      // [link](  <href>  "title"  )
+      //                ^^ skipping these spaces
+      const std::size_t start = pos;
+      pos = SkipLinkSpaces(src, pos, max);
+
+      // [link](  <href>  "title"  )
+      //                  ^^^^^^^ parsing link title
+      LinkTitle res = LinkHelpers::ParseLinkTitle(src, pos, max);
+      if (pos < max && start != pos && res.ok) {
+        title = std::move(res.str);
+        pos = SkipLinkSpaces(src, res.pos, max);
+      }
+    }
+
+    if (pos >= max || src[pos] != ')') {
+      // parsing a valid shortcut link failed, fallback to reference
+      parse_reference = true;
+    }
+    pos++;
+  }
+
+  if (parse_reference) {
+    // Link reference
+    if (!state.env.HasReferences()) return false;
+
+    std::string_view label;
+    if (pos < max && src[pos] == '[') {
+      const std::size_t start = pos + 1;
+      pos = LinkHelpers::ParseLinkLabel(state, pos);
+      if (pos != std::string_view::npos) {
+        label = src.substr(start, pos - start);
+        pos++;
+      } else {
+        pos = label_end + 1;
+      }
+    } else {
+      pos = label_end + 1;
+    }
+
+    // covers collapsed and shortcut reference links
+    if (label.empty()) label = src.substr(label_start, label_end - label_start);
+
+    const LinkReference* ref = state.env.FindReference(label);
+    if (ref == nullptr) {
+      state.pos = old_pos;
+      return false;
+    }
+    href = ref->href;
+    title = ref->title;
+  }
+
+  // We found the end of the link, and know for a fact it's a valid link;
+  // so all that's left to do is to call tokenizer.
+  if (!silent) {
+    state.pos = label_start;
+    state.pos_max = label_end;
+
+    Token& token_o =
+        state.Push(TokenKind::kLinkOpen, HtmlTag::kA, Nesting::kOpening);
+    token_o.AttrSet(AttrKind::kHref, href);
+    if (!title.empty()) token_o.AttrSet(AttrKind::kTitle, title);
+
+    state.link_level++;
+    state.md.inline_parser.Tokenize(state, *state.rules);
+    state.link_level--;
+
+    state.Push(TokenKind::kLinkClose, HtmlTag::kA, Nesting::kClosing);
+  }
+
+  state.pos = pos;
+  state.pos_max = max;
+  return true;
+}
+
+bool InlineRules::RuleNewline(StateInline& state, bool silent) {
+  std::size_t pos = state.pos;
+  if (state.src[pos] != '\n') return false;
+
+  const std::size_t max = state.pos_max;
+  const std::string_view src = state.src;
+
+  // '  \n' -> hardbreak
+  if (!silent) {
+    const std::size_t begin = state.pending_begin;
+    const std::size_t end = state.pending_end;
+
+    if (state.HasPending() && src[end - 1] == ' ') {
+      if (end - begin >= 2 && src[end - 2] == ' ') {
+        // Find whitespaces tail of pending chars
+        std::size_t ws = end - 2;
+        while (ws > begin && src[ws - 1] == ' ') ws--;
+        state.pending_end = ws;
+        state.Push(TokenKind::kHardbreak, HtmlTag::kBr, Nesting::kSelfClosing);
+      } else {
+        state.pending_end = end - 1;
+        state.Push(TokenKind::kSoftbreak, HtmlTag::kBr, Nesting::kSelfClosing);
+      }
+    } else {
+      state.Push(TokenKind::kSoftbreak, HtmlTag::kBr, Nesting::kSelfClosing);
+    }
+  }
+
+  pos++;
+
+  // Skip heading spaces for next line
+  while (pos < max && Utils::IsSpace(src[pos])) pos++;
+
+  state.pos = pos;
+  return true;
+}
+
+bool InlineRules::RuleText(StateInline& state, bool silent) {
+  const std::size_t pos = state.pos;
+  const std::size_t end =
+      SkipText(state.src.substr(0, state.pos_max), state.pos);
+
+  if (end == pos) return false;
+
+  if (!silent) state.AddPending(pos, end);
+
+  state.pos = end;
+  return true;
+}
+
+void InlineRules::RuleBalancePairs(StateInline& state) {
+  ProcessDelimiters(state.delimiters);
+  for (DelimiterList& nested : state.nested_delimiters) {
+    ProcessDelimiters(nested);
+  }
+}
+
+void InlineRules::RuleEmphasisPost(StateInline& state) {
+  EmphasisPostProcess(state, state.delimiters);
+  for (const DelimiterList& nested : state.nested_delimiters) {
+    EmphasisPostProcess(state, nested);
+  }
+}
+
+void InlineRules::RuleFragmentsJoin(StateInline& state) {
+  // Rules removing delimiters leave levels and text runs behind
+  int level = 0;
+  for (Token& token : state.Children()) {
+    if (token.nesting < 0) level--;
+    token.level = level;
+    if (token.nesting > 0) level++;
+  }
+
+  state.tokens.JoinTextChildren(state.parent);
+}
+
+// NOLINTEND
+
+}  // namespace aethermark
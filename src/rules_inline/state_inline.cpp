@@ -0,0 +1,168 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/rules_inline/state_inline.hpp"
+
+#include <cstddef>
+#include <string_view>
+#include <utility>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/utils.hpp"
+
+namespace aethermark {
+
+namespace {
+
+// Code point starting at `pos`; invalid sequences decode to their first byte
+char32_t DecodeAt(std::string_view src, std::size_t pos) {
+  const auto lead = static_cast<unsigned char>(src[pos]);
+  std::size_t length = 0;
+  char32_t cp = lead;
+  if (lead >= 0xF0) {
+    length = 4;
+    cp = lead & 0x07;
+  } else if (lead >= 0xE0) {
+    length = 3;
+    cp = lead & 0x0F;
+  } else if (lead >= 0xC0) {
+    length = 2;
+    cp = lead & 0x1F;
+  } else {
+    return lead;
+  }
+  if (pos + length > src.size()) return lead;
+  for (std::size_t i = 1; i < length; ++i) {
+    const auto c = static_cast<unsigned char>(src[pos + i]);
+    if ((c & 0xC0) != 0x80) return lead;
+    cp = (cp << 6) | (c & 0x3F);
+  }
+  return cp;
+}
+
+// Code point ending right before `pos`
+char32_t DecodeBefore(std::string_view src, std::size_t pos) {
+  std::size_t start = pos - 1;
+  while (start > 0 && pos - start < 4 &&
+         (static_cast<unsigned char>(src[start]) & 0xC0) == 0x80) {
+    start--;
+  }
+  return DecodeAt(src, start);
+}
+
+}  // namespace
+
+StateInline::StateInline(std::string_view src_, Aethermark& md_,
+                         ParseEnv& env_, TokenList& tokens_,
+                         std::size_t parent_, bool stable_src)
+    : src(src_),
+      md(md_),
+      env(env_),
+      tokens(tokens_),
+      parent(parent_),
+      pos_max(src_.size()),
+      cache(tokens_.get_allocator()),
+      delimiters(tokens_.get_allocator()),
+      nested_delimiters(tokens_.get_allocator()),
+      stable_src_(stable_src),
+      prev_delimiters_(tokens_.get_allocator()) {}
+
+void StateInline::AddPending(std::size_t begin, std::size_t end) {
+  if (HasPending() && pending_end != begin) PushPending();
+  if (!HasPending()) {
+    pending_begin = begin;
+    pending_level = level;
+  }
+  pending_end = end;
+}
+
+Token& StateInline::PushPending() {
+  Token& token =
+      tokens.emplace_back(TokenKind::kText, HtmlTag::kNone,
+                          Nesting::kSelfClosing);
+  SetContent(token, pending_begin, pending_end);
+  token.level = pending_level;
+  pending_begin = pending_end = 0;
+  return token;
+}
+
+Token& StateInline::Push(TokenType type, TokenTag tag, Nesting nesting) {
+  if (HasPending()) PushPending();
+
+  Token& token = tokens.emplace_back(type, tag, nesting);
+
+  // closing tag -> decrease level before assigning
+  if (static_cast<int>(nesting) < 0) {
+    level--;
+    if (!delimiters.empty()) {
+      nested_delimiters.push_back(std::move(delimiters));
+    }
+    if (prev_delimiters_.empty()) {
+      delimiters.clear();
+    } else {
+      delimiters = std::move(prev_delimiters_.back());
+      prev_delimiters_.pop_back();
+    }
+  }
+
+  token.level = level;
+
+  // opening tag -> increase level after assigning
+  if (static_cast<int>(nesting) > 0) {
+    level++;
+    prev_delimiters_.push_back(std::move(delimiters));
+    delimiters.clear();
+  }
+
+  pending_level = level;
+  return token;
+}
+
+DelimiterRun StateInline::ScanDelims(std::size_t start,
+                                     bool can_split_word) const {
+  const std::size_t max = pos_max;
+  const char marker = src[start];
+
+  // treat beginning of the line as a whitespace
+  const char32_t last_char = start > 0 ? DecodeBefore(src, start) : 0x20;
+
+  std::size_t pos = start;
+  while (pos < max && src[pos] == marker) pos++;
+
+  const std::size_t count = pos - start;
+
+  // treat end of the line as a whitespace
+  const char32_t next_char = pos < max ? DecodeAt(src, pos) : 0x20;
+
+  const bool is_last_punct_char = Utils::IsPunctChar(last_char);
+  const bool is_next_punct_char = Utils::IsPunctChar(next_char);
+
+  const bool is_last_white_space = Utils::IsWhiteSpace(last_char);
+  const bool is_next_white_space = Utils::IsWhiteSpace(next_char);
+
+  const bool left_flanking =
+      !is_next_white_space &&
+      (!is_next_punct_char || is_last_white_space || is_last_punct_char);
+  const bool right_flanking =
+      !is_last_white_space &&
+      (!is_last_punct_char || is_next_white_space || is_next_punct_char);
+
+  const bool can_open = left_flanking && (can_split_word || !right_flanking ||
+                                          is_last_punct_char);
+  const bool can_close = right_flanking && (can_split_word || !left_flanking ||
+                                            is_next_punct_char);
+
+  return {can_open, can_close, count};
+}
+
+void StateInline::SetContent(Token& token, std::size_t begin,
+                             std::size_t end) const {
+  std::string_view text = src.substr(begin, end - begin);
+  if (stable_src_) {
+    token.content.Borrow(text);
+  } else {
+    token.content = text;
+  }
+}
+
+}  // namespace aethermark
@@ -0,0 +1,64 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/symbol.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace aethermark {
+
+SymbolTable::SymbolTable(std::span<const std::string_view> builtins)
+    : builtins_(builtins) {
+  ids_.reserve(builtins.size());
+  for (std::size_t i = 0; i < builtins.size(); i++) {
+    ids_.emplace(builtins[i], static_cast<std::uint16_t>(i));
+  }
+}
+
+std::uint16_t SymbolTable::Intern(std::string_view name) {
+  {
+    std::shared_lock lock(mutex_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+  }
+
+  std::unique_lock lock(mutex_);
+  auto it = ids_.find(name);
+  if (it != ids_.end()) return it->second;
+
+  std::size_t id = builtins_.size() + names_.size();
+  if (id > std::numeric_limits<std::uint16_t>::max()) {
+    throw std::runtime_error("Symbol table full, cannot intern: " +
+                             std::string(name));
+  }
+
+  const std::string& stored = names_.emplace_back(name);
+  ids_.emplace(stored, static_cast<std::uint16_t>(id));
+  return static_cast<std::uint16_t>(id);
+}
+
+std::optional<std::uint16_t> SymbolTable::Find(std::string_view name) const {
+  std::shared_lock lock(mutex_);
+  auto it = ids_.find(name);
+  if (it == ids_.end()) return std::nullopt;
+  return it->second;
+}
+
+std::string_view SymbolTable::Name(std::uint16_t id) const {
+  if (id < builtins_.size()) return builtins_[id];
+
+  std::shared_lock lock(mutex_);
+  std::size_t index = id - builtins_.size();
+  if (index >= names_.size()) return {};
+  return names_[index];
+}
+
+}  // namespace aethermark
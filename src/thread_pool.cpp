@@ -0,0 +1,151 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/thread_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace aethermark {
+
+ThreadPool::ThreadPool(std::size_t workers)
+    : ranges_(std::make_unique<Range[]>(workers + 1)) {
+  workers_.reserve(workers);
+  for (std::size_t i = 0; i < workers; i++) {
+    workers_.emplace_back([this, i] { WorkerLoop(i + 1); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) worker.join();
+}
+
+ThreadPool& ThreadPool::Shared() {
+  static ThreadPool pool(
+      std::max(1u, std::thread::hardware_concurrency()) - 1);
+  return pool;
+}
+
+std::size_t ThreadPool::ParallelFor(std::size_t count, std::size_t max_slots,
+                                    const Task& fn) {
+  if (count == 0) return 1;
+
+  std::size_t slots = workers_.size() + 1;
+  if (max_slots != 0) slots = std::min(slots, max_slots);
+  slots = std::min(slots, count);
+
+  // Another loop owns the workers: run this one alone
+  std::unique_lock<std::mutex> loop(loop_mutex_, std::try_to_lock);
+  if (!loop.owns_lock() || slots == 1) {
+    for (std::size_t task = 0; task < count; task++) fn(task, 0);
+    return 1;
+  }
+
+  // One contiguous share per slot; stealing evens out the rest
+  for (std::size_t slot = 0; slot < slots; slot++) {
+    std::lock_guard<std::mutex> lock(ranges_[slot].mutex);
+    ranges_[slot].begin = count * slot / slots;
+    ranges_[slot].end = count * (slot + 1) / slots;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fn_ = &fn;
+    slots_ = slots;
+    running_ = slots - 1;
+    error_ = nullptr;
+    failed_ = false;
+    generation_++;
+  }
+  wake_.notify_all();
+
+  RunSlot(0);
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return running_ == 0; });
+    fn_ = nullptr;
+    error = error_;
+  }
+  if (error) std::rethrow_exception(error);
+  return slots;
+}
+
+void ThreadPool::WorkerLoop(std::size_t slot) {
+  std::uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+      if (slot >= slots_) continue;
+    }
+
+    RunSlot(slot);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--running_ == 0) done_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunSlot(std::size_t slot) {
+  std::size_t task;
+  while (!failed_ && NextTask(slot, &task)) {
+    try {
+      (*fn_)(task, slot);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!error_) error_ = std::current_exception();
+      failed_ = true;
+    }
+  }
+}
+
+bool ThreadPool::NextTask(std::size_t slot, std::size_t* task) {
+  Range& own = ranges_[slot];
+  {
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (own.begin < own.end) {
+      *task = own.begin++;
+      return true;
+    }
+  }
+
+  // Steal the back half of the first non-empty range after ours
+  for (std::size_t i = 1; i < slots_; i++) {
+    Range& victim = ranges_[(slot + i) % slots_];
+    std::size_t begin;
+    std::size_t end;
+    {
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      const std::size_t left = victim.end - victim.begin;
+      if (left == 0) continue;
+      end = victim.end;
+      begin = end - (left + 1) / 2;
+      victim.end = begin;
+    }
+
+    // Run the first stolen task now, keep the rest for ourselves
+    std::lock_guard<std::mutex> lock(own.mutex);
+    own.begin = begin + 1;
+    own.end = end;
+    *task = begin;
+    return true;
+  }
+  return false;
+}
+
+}  // namespace aethermark
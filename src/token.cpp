@@ -3,36 +3,198 @@
 
 #include "aethermark/token.hpp"
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 namespace aethermark {
 
-Token::Token(std::string type, std::string tag, Nesting nesting) {
-  this->type = type;
-  this->tag = tag;
-  this->nesting = nesting;
-  this->attrs = std::nullopt;
-  this->map = std::nullopt;
-  this->level = 0;
-  this->children = std::nullopt;
-  this->content = "";
-  this->markup = "";
-  this->info = "";
-  this->block = false;
-  this->hidden = false;
-}
-
-int Token::AttrIndex(const std::string& name) {
-  // Check null
-  if (!this->attrs.has_value()) {
-    return -1;
+TokenString::TokenString(const TokenString& other, const allocator_type& alloc)
+    : owned_(other.owned_, alloc), view_(other.view_) {}
+
+TokenString::TokenString(TokenString&& other, const allocator_type& alloc)
+    : owned_(std::move(other.owned_), alloc), view_(other.view_) {}
+
+TokenString& TokenString::operator=(std::string_view text) {
+  owned_.assign(text);
+  view_ = {};
+  return *this;
+}
+
+void TokenString::Borrow(std::string_view text) {
+  owned_.clear();
+  // a null view means owned text, so empty views get a non-null pointer
+  view_ = text.data() != nullptr ? text : std::string_view("", 0);
+}
+
+void TokenString::Assign(std::pmr::string&& text) {
+  owned_ = std::move(text);
+  view_ = {};
+}
+
+void TokenString::Append(std::string_view text) {
+  if (IsBorrowed()) {
+    std::string_view current = view_;
+    owned_.reserve(current.size() + text.size());
+    owned_.assign(current);
+    view_ = {};
+  }
+  owned_.append(text);
+}
+
+TokenAttrs::~TokenAttrs() { Release(); }
+
+TokenAttrs::TokenAttrs(TokenAttrs&& other) noexcept : alloc_(other.alloc_) {
+  StealFrom(other);
+}
+
+TokenAttrs::TokenAttrs(const TokenAttrs& other, const allocator_type& alloc)
+    : alloc_(alloc) {
+  reserve(other.size_);
+  for (const TokenAttr& attr : other) push_back(attr);
+}
+
+TokenAttrs::TokenAttrs(TokenAttrs&& other, const allocator_type& alloc)
+    : alloc_(alloc) {
+  if (alloc_ == other.alloc_) {
+    StealFrom(other);
+    return;
+  }
+  reserve(other.size_);
+  for (const TokenAttr& attr : other) push_back(attr);
+}
+
+TokenAttrs& TokenAttrs::operator=(const TokenAttrs& other) {
+  if (this == &other) return *this;
+  clear();
+  reserve(other.size_);
+  for (const TokenAttr& attr : other) push_back(attr);
+  return *this;
+}
+
+TokenAttrs& TokenAttrs::operator=(TokenAttrs&& other) {
+  if (this == &other) return *this;
+  if (alloc_ == other.alloc_) {
+    Release();
+    StealFrom(other);
+    return *this;
+  }
+  return *this = static_cast<const TokenAttrs&>(other);
+}
+
+TokenAttr& TokenAttrs::at(std::size_t i) {
+  if (i >= size_) throw std::out_of_range("TokenAttrs::at");
+  return data_[i];
+}
+
+const TokenAttr& TokenAttrs::at(std::size_t i) const {
+  if (i >= size_) throw std::out_of_range("TokenAttrs::at");
+  return data_[i];
+}
+
+void TokenAttrs::reserve(std::size_t n) {
+  if (n <= capacity_) return;
+
+  TokenAttr* grown = alloc_.allocate_object<TokenAttr>(n);
+  for (std::uint32_t i = 0; i < size_; i++) {
+    alloc_.construct(grown + i, std::move(data_[i]));
+    std::destroy_at(data_ + i);
   }
-  // Search for attribute
-  for (size_t i = 0; i < this->attrs->size(); i++) {
-    if (this->attrs->at(i).first == name) {
+  if (data_ != nullptr) alloc_.deallocate_object(data_, capacity_);
+
+  data_ = grown;
+  capacity_ = static_cast<std::uint32_t>(n);
+}
+
+TokenAttr& TokenAttrs::emplace_back(AttrName name, std::string_view value) {
+  if (size_ == capacity_) {
+    reserve(capacity_ == 0 ? kInitialCapacity : std::size_t{capacity_} * 2);
+  }
+  TokenAttr* attr = data_ + size_;
+  alloc_.construct(attr, name, value);
+  size_++;
+  return *attr;
+}
+
+void TokenAttrs::clear() {
+  std::destroy_n(data_, size_);
+  size_ = 0;
+}
+
+void TokenAttrs::StealFrom(TokenAttrs& other) {
+  data_ = other.data_;
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+  other.capacity_ = 0;
+}
+
+void TokenAttrs::Release() {
+  clear();
+  if (data_ != nullptr) alloc_.deallocate_object(data_, capacity_);
+  data_ = nullptr;
+  capacity_ = 0;
+}
+
+Token::Token(TokenType type, TokenTag tag, Nesting nesting,
+             const allocator_type& alloc)
+    : type(type),
+      tag(tag),
+      nesting(nesting),
+      block(false),
+      hidden(false),
+      attrs(alloc),
+      map(std::nullopt),
+      level(0),
+      content(alloc),
+      markup(alloc),
+      info(alloc) {}
+
+Token::Token(std::string_view type, std::string_view tag, Nesting nesting,
+             const allocator_type& alloc)
+    : Token(TokenType(type), TokenTag(tag), nesting, alloc) {}
+
+Token::Token(const Token& other, const allocator_type& alloc)
+    : type(other.type),
+      tag(other.tag),
+      nesting(other.nesting),
+      block(other.block),
+      hidden(other.hidden),
+      attrs(other.attrs, alloc),
+      map(other.map),
+      level(other.level),
+      children(other.children),
+      content(other.content, alloc),
+      markup(other.markup, alloc),
+      info(other.info, alloc),
+      meta(other.meta) {}
+
+Token::Token(Token&& other, const allocator_type& alloc)
+    : type(other.type),
+      tag(other.tag),
+      nesting(other.nesting),
+      block(other.block),
+      hidden(other.hidden),
+      attrs(std::move(other.attrs), alloc),
+      map(other.map),
+      level(other.level),
+      children(other.children),
+      content(std::move(other.content), alloc),
+      markup(std::move(other.markup), alloc),
+      info(std::move(other.info), alloc),
+      meta(std::move(other.meta)) {}
+
+int Token::AttrIndex(AttrName name) const {
+  // Search for attribute, names compare as ids
+  for (std::size_t i = 0; i < this->attrs.size(); i++) {
+    if (this->attrs[i].first == name) {
       return static_cast<int>(i);
     }
   }
@@ -40,50 +202,56 @@ int Token::AttrIndex(const std::string& name) {
   return -1;
 }
 
-using Attr = std::pair<std::string, std::string>;
-void Token::AttrPush(const std::vector<Attr>& attr_data) {
-  // Initialize attrs if null
-  if (!this->attrs.has_value()) {
-    this->attrs.emplace();
-  }
+int Token::AttrIndex(std::string_view name) const {
+  // A name that was never interned cannot be set on any token
+  std::optional<AttrName> symbol = AttrName::Find(name);
+  if (!symbol.has_value()) return -1;
+  return this->AttrIndex(*symbol);
+}
 
+void Token::AttrPush(
+    const std::vector<std::pair<std::string, std::string>>& attr_data) {
   // Push attributes
-  attrs->insert(attrs->end(), attr_data.begin(), attr_data.end());
+  attrs.reserve(attrs.size() + attr_data.size());
+  for (const std::pair<std::string, std::string>& a : attr_data) {
+    attrs.emplace_back(AttrName(a.first), a.second);
+  }
 }
 
-void Token::AttrSet(const std::string& name, const std::string& value) {
+void Token::AttrSet(AttrName name, std::string_view value) {
   int index = this->AttrIndex(name);
   if (index == -1) {
     // Add new attribute
-    if (!this->attrs.has_value()) {
-      this->attrs.emplace();
-    }
-    this->attrs->emplace_back(std::make_pair(name, value));
+    this->attrs.emplace_back(name, value);
     return;
   }
   // Override existing attribute
-  for (std::pair<std::string, std::string>& a : *attrs) {
-    if (a.first == name) a.second = value;
-  }
+  this->attrs[index].second = value;
 }
 
-std::optional<std::string> Token::AttrGet(const std::string& name) {
+std::optional<std::string_view> Token::AttrGet(AttrName name) const {
   int index = this->AttrIndex(name);
   if (index == -1) return std::nullopt;
-  return this->attrs->at(index).second;
+  return std::string_view(this->attrs[index].second);
 }
 
-void Token::AttrJoin(const std::string& name, const std::string& value) {
+std::optional<std::string_view> Token::AttrGet(std::string_view name) const {
+  int index = this->AttrIndex(name);
+  if (index == -1) return std::nullopt;
+  return std::string_view(this->attrs[index].second);
+}
+
+void Token::AttrJoin(AttrName name, std::string_view value) {
   int index = this->AttrIndex(name);
   if (index == -1) {
     // Add new attribute
-    if (!this->attrs.has_value()) {
-      this->attrs.emplace();
-    }
-    this->attrs->emplace_back(std::make_pair(name, value));
+    this->attrs.emplace_back(name, value);
     return;
   }
   // Join to existing attribute
-  this->attrs->at(index).second += " " + value;
+  std::pmr::string& joined = this->attrs[index].second;
+  joined.reserve(joined.size() + 1 + value.size());
+  joined += ' ';
+  joined += value;
 }
 }  // namespace aethermark
@@ -0,0 +1,194 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/token_list.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace aethermark {
+
+TokenList::TokenList(const allocator_type& alloc,
+                     std::pmr::memory_resource* buffer)
+    : tokens_(TokenBufferAllocator<Token>(buffer, alloc)),
+      root_runs_(tokens_.get_allocator()),
+      compact_index_(tokens_.get_allocator()) {}
+
+TokenList::TokenList(const TokenList& other, const allocator_type& alloc)
+    : tokens_(other.tokens_, TokenBufferAllocator<Token>(
+                                 std::pmr::get_default_resource(), alloc)),
+      root_runs_(other.root_runs_, tokens_.get_allocator()),
+      open_parent_(other.open_parent_),
+      dropped_(other.dropped_),
+      compact_index_(tokens_.get_allocator()) {}
+
+TokenList::TokenList(TokenList&& other, const allocator_type& alloc)
+    : tokens_(std::move(other.tokens_),
+              TokenBufferAllocator<Token>(other.BufferResource(), alloc)),
+      root_runs_(std::move(other.root_runs_), tokens_.get_allocator()),
+      open_parent_(other.open_parent_),
+      dropped_(other.dropped_),
+      compact_index_(tokens_.get_allocator()) {
+  other.open_parent_ = kNoParent;
+  other.dropped_ = 0;
+}
+
+void TokenList::clear() {
+  tokens_.clear();
+  root_runs_.clear();
+  open_parent_ = kNoParent;
+  dropped_ = 0;
+}
+
+void TokenList::BeginChildren(std::size_t parent) {
+  if (open_parent_ != kNoParent) {
+    throw std::runtime_error("TokenList: children of token " +
+                             std::to_string(open_parent_) +
+                             " are still being appended");
+  }
+  if (parent >= tokens_.size()) {
+    throw std::runtime_error("TokenList: no token at index " +
+                             std::to_string(parent));
+  }
+
+  const auto end = static_cast<std::uint32_t>(tokens_.size());
+  dropped_ += tokens_[parent].children.size();
+  tokens_[parent].children = TokenRange{end, end};
+  open_parent_ = parent;
+}
+
+void TokenList::EndChildren() {
+  if (open_parent_ == kNoParent) {
+    throw std::runtime_error("TokenList: EndChildren without BeginChildren");
+  }
+  open_parent_ = kNoParent;
+}
+
+void TokenList::TruncateChildren(std::size_t parent, std::uint32_t size) {
+  TokenRange& range = tokens_[parent].children;
+  if (size < range.size()) {
+    dropped_ += range.size() - size;
+    range.end = range.begin + size;
+  }
+}
+
+void TokenList::JoinTextChildren(std::size_t parent) {
+  // Children live in the flat buffer, so merge them in place
+  std::span<Token> tokens = Children(tokens_[parent]);
+  const std::size_t max = tokens.size();
+
+  std::size_t last = 0;
+  for (std::size_t curr = 0; curr < max;) {
+    // find the run of adjacent text nodes starting here
+    std::size_t end = curr + 1;
+    if (tokens[curr].type == TokenKind::kText) {
+      while (end < max && tokens[end].type == TokenKind::kText) end++;
+    }
+
+    if (end - curr > 1) {
+      bool contiguous = tokens[curr].content.IsBorrowed();
+      std::size_t size = tokens[curr].content.size();
+      for (std::size_t i = curr + 1; i < end; i++) {
+        const TokenString& prev = tokens[i - 1].content;
+        const TokenString& text = tokens[i].content;
+        contiguous = contiguous && text.IsBorrowed() &&
+                     prev.View().data() + prev.size() == text.View().data();
+        size += text.size();
+      }
+
+      TokenString& joined = tokens[curr].content;
+      if (contiguous) {
+        joined.Borrow(std::string_view(joined.View().data(), size));
+      } else {
+        std::pmr::string content(joined.get_allocator());
+        content.reserve(size);
+        for (std::size_t i = curr; i < end; i++) {
+          content.append(tokens[i].content.View());
+        }
+        joined.Assign(std::move(content));
+      }
+    }
+
+    if (curr != last) tokens[last] = std::move(tokens[curr]);
+    last++;
+    curr = end;
+  }
+
+  TruncateChildren(parent, static_cast<std::uint32_t>(last));
+}
+
+void TokenList::Compact() {
+  if (dropped_ == 0) return;
+  if (open_parent_ != kNoParent) {
+    throw std::runtime_error("TokenList: children of token " +
+                             std::to_string(open_parent_) +
+                             " are still being appended");
+  }
+
+  // Children always follow their parent, so one forward pass reaches every
+  // live token before it is renumbered
+  constexpr auto kDropped = static_cast<std::uint32_t>(-1);
+  std::vector<std::uint32_t, TokenBufferAllocator<std::uint32_t>>& index =
+      compact_index_;
+  index.assign(tokens_.size(), kDropped);
+  for (const TokenRange& run : root_runs_) {
+    std::fill(index.begin() + run.begin, index.begin() + run.end, 0);
+  }
+  std::uint32_t live = 0;
+  for (std::size_t i = 0; i < tokens_.size(); i++) {
+    if (index[i] == kDropped) continue;
+    index[i] = live++;
+    const TokenRange children = tokens_[i].children;
+    std::fill(index.begin() + children.begin, index.begin() + children.end, 0);
+  }
+
+  for (std::size_t i = 0; i < tokens_.size(); i++) {
+    if (index[i] == kDropped) continue;
+    TokenRange& children = tokens_[i].children;
+    children = children.empty()
+                   ? TokenRange{}
+                   : TokenRange{index[children.begin],
+                                index[children.begin] + children.size()};
+    if (index[i] != i) tokens_[index[i]] = std::move(tokens_[i]);
+  }
+  tokens_.erase(tokens_.begin() + live, tokens_.end());
+
+  // Runs separated only by dropped tokens become one
+  std::size_t runs = 0;
+  for (std::size_t i = 0; i < root_runs_.size(); i++) {
+    const TokenRange run{index[root_runs_[i].begin],
+                         index[root_runs_[i].begin] + root_runs_[i].size()};
+    if (runs > 0 && root_runs_[runs - 1].end == run.begin) {
+      root_runs_[runs - 1].end = run.end;
+    } else {
+      root_runs_[runs++] = run;
+    }
+  }
+  root_runs_.resize(runs);
+  dropped_ = 0;
+}
+
+void TokenList::Appended() {
+  const auto index = static_cast<std::uint32_t>(tokens_.size() - 1);
+
+  if (open_parent_ != kNoParent) {
+    tokens_[open_parent_].children.end = index + 1;
+    return;
+  }
+
+  if (!root_runs_.empty() && root_runs_.back().end == index) {
+    root_runs_.back().end = index + 1;
+  } else {
+    root_runs_.push_back(TokenRange{index, index + 1});
+  }
+}
+
+}  // namespace aethermark
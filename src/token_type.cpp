@@ -0,0 +1,59 @@
+// Copyright 2025 Aethermark Contributors
+// All rights reserved.
+
+#include "aethermark/token_type.hpp"
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+#include "aethermark/symbol.hpp"
+
+namespace aethermark {
+
+// Names in enumerator order: the enumerator value is the symbol id.
+static constexpr std::string_view kTokenKindNames[] = {
+    "", "inline", "text", "text_special", "softbreak", "hardbreak",
+    "paragraph_open", "paragraph_close", "blockquote_open", "blockquote_close",
+    "code_block", "fence", "heading_open", "heading_close", "hr", "html_block",
+    "bullet_list_open", "bullet_list_close", "ordered_list_open",
+    "ordered_list_close", "list_item_open", "list_item_close", "table_open",
+    "table_close", "thead_open", "thead_close", "tbody_open", "tbody_close",
+    "tr_open", "tr_close", "th_open", "th_close", "td_open", "td_close",
+    "code_inline", "em_open", "em_close", "strong_open", "strong_close",
+    "s_open", "s_close", "link_open", "link_close", "image", "html_inline",
+};
+
+static constexpr std::string_view kHtmlTagNames[] = {
+    "", "p", "blockquote", "code", "pre", "h1", "h2", "h3", "h4", "h5", "h6",
+    "hr", "ul", "ol", "li", "table", "thead", "tbody", "tr", "th", "td", "em",
+    "strong", "s", "a", "img", "br",
+};
+
+static constexpr std::string_view kAttrNames[] = {
+    "", "href", "src", "alt", "title", "class", "id", "start", "style",
+};
+
+static_assert(std::size(kTokenKindNames) ==
+              static_cast<std::size_t>(TokenKind::kHtmlInline) + 1);
+static_assert(std::size(kHtmlTagNames) ==
+              static_cast<std::size_t>(HtmlTag::kBr) + 1);
+static_assert(std::size(kAttrNames) ==
+              static_cast<std::size_t>(AttrKind::kStyle) + 1);
+
+SymbolTable& TokenTypeTraits::Table() {
+  static SymbolTable table(kTokenKindNames);
+  return table;
+}
+
+SymbolTable& TokenTagTraits::Table() {
+  static SymbolTable table(kHtmlTagNames);
+  return table;
+}
+
+SymbolTable& AttrNameTraits::Table() {
+  static SymbolTable table(kAttrNames);
+  return table;
+}
+
+}  // namespace aethermark
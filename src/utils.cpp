@@ -3,7 +3,15 @@
 
 #include "aethermark/utils.hpp"
 
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <string>
+#include <string_view>
+
+#include "aethermark/entities.hpp"
 
 namespace aethermark {
 
@@ -26,6 +34,329 @@ std::string Utils::Trim(const std::string& s) {
   return s.substr(start, end - start + 1);
 }
 
+std::string_view Utils::TrimView(std::string_view s) {
+  size_t start = 0;
+  while (start < s.size() &&
+         std::isspace(static_cast<unsigned char>(s[start]))) {
+    start++;
+  }
+
+  size_t end = s.size();
+  while (end > start && std::isspace(static_cast<unsigned char>(s[end - 1]))) {
+    end--;
+  }
+
+  return s.substr(start, end - start);
+}
+
 bool Utils::IsSpace(int ch) { return ch == 0x20 || ch == 0x09; }
 
+bool Utils::IsWhiteSpace(char32_t ch) {
+  if (ch >= 0x2000 && ch <= 0x200A) return true;
+  switch (ch) {
+    case 0x09:  // \t
+    case 0x0A:  // \n
+    case 0x0B:  // \v
+    case 0x0C:  // \f
+    case 0x0D:  // \r
+    case 0x20:
+    case 0xA0:
+    case 0x1680:
+    case 0x202F:
+    case 0x205F:
+    case 0x3000:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool Utils::IsMdAsciiPunct(char32_t ch) {
+  return (ch >= 0x21 && ch <= 0x2F) || (ch >= 0x3A && ch <= 0x40) ||
+         (ch >= 0x5B && ch <= 0x60) || (ch >= 0x7B && ch <= 0x7E);
+}
+
+namespace {
+
+// Sorted, disjoint ranges of non-ASCII punctuation and symbols
+struct CodeRange {
+  char32_t first;
+  char32_t last;
+};
+
+#include "punct_table.inc"
+
+}  // namespace
+
+bool Utils::IsPunctChar(char32_t ch) {
+  if (ch < 0x80) return IsMdAsciiPunct(ch);
+
+  const auto it = std::upper_bound(
+      std::begin(kPunctRanges), std::end(kPunctRanges), ch,
+      [](char32_t c, const CodeRange& r) { return c < r.first; });
+  return it != std::begin(kPunctRanges) && ch <= std::prev(it)->last;
+}
+
+namespace {
+
+bool IsAsciiAlpha(char c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+
+bool IsAsciiDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Whitespace as matched by `\s` in the markdown-it patterns
+bool IsHtmlSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+std::size_t SkipHtmlSpaces(std::string_view s, std::size_t pos) {
+  while (pos < s.size() && IsHtmlSpace(s[pos])) pos++;
+  return pos;
+}
+
+// Tag name: [A-Za-z][A-Za-z0-9-]*
+std::size_t SkipTagName(std::string_view s, std::size_t pos) {
+  if (pos >= s.size() || !IsAsciiAlpha(s[pos])) return pos;
+  pos++;
+  while (pos < s.size() &&
+         (IsAsciiAlpha(s[pos]) || IsAsciiDigit(s[pos]) || s[pos] == '-')) {
+    pos++;
+  }
+  return pos;
+}
+
+// Attribute name: [a-zA-Z_:][a-zA-Z0-9:._-]*
+std::size_t SkipAttrName(std::string_view s, std::size_t pos) {
+  if (pos >= s.size() ||
+      !(IsAsciiAlpha(s[pos]) || s[pos] == '_' || s[pos] == ':')) {
+    return pos;
+  }
+  pos++;
+  while (pos < s.size()) {
+    const char c = s[pos];
+    if (!(IsAsciiAlpha(c) || IsAsciiDigit(c) || c == ':' || c == '.' ||
+          c == '_' || c == '-')) {
+      break;
+    }
+    pos++;
+  }
+  return pos;
+}
+
+// Attribute value: unquoted, single quoted or double quoted
+std::size_t SkipAttrValue(std::string_view s, std::size_t pos) {
+  if (pos >= s.size()) return pos;
+  const char q = s[pos];
+  if (q == '"' || q == '\'') {
+    const std::size_t close = s.find(q, pos + 1);
+    return close == std::string_view::npos ? pos : close + 1;
+  }
+  std::size_t end = pos;
+  while (end < s.size()) {
+    const auto c = static_cast<unsigned char>(s[end]);
+    if (c <= 0x20 || c == '"' || c == '\'' || c == '=' || c == '<' ||
+        c == '>' || c == '`') {
+      break;
+    }
+    end++;
+  }
+  return end;
+}
+
+std::size_t MatchOpenTag(std::string_view s) {
+  std::size_t pos = SkipTagName(s, 1);
+  if (pos == 1) return 0;
+
+  // Attributes, each preceded by whitespace
+  for (;;) {
+    const std::size_t ws_end = SkipHtmlSpaces(s, pos);
+    if (ws_end == pos) break;
+    const std::size_t name_end = SkipAttrName(s, ws_end);
+    if (name_end == ws_end) break;
+    pos = name_end;
+
+    const std::size_t eq = SkipHtmlSpaces(s, pos);
+    if (eq < s.size() && s[eq] == '=') {
+      const std::size_t value = SkipHtmlSpaces(s, eq + 1);
+      const std::size_t value_end = SkipAttrValue(s, value);
+      if (value_end == value) return 0;
+      pos = value_end;
+    }
+  }
+
+  pos = SkipHtmlSpaces(s, pos);
+  if (pos < s.size() && s[pos] == '/') pos++;
+  return pos < s.size() && s[pos] == '>' ? pos + 1 : 0;
+}
+
+std::size_t MatchCloseTag(std::string_view s) {
+  std::size_t pos = SkipTagName(s, 2);
+  if (pos == 2) return 0;
+  pos = SkipHtmlSpaces(s, pos);
+  return pos < s.size() && s[pos] == '>' ? pos + 1 : 0;
+}
+
+std::size_t MatchComment(std::string_view s) {
+  if (s.starts_with("<!-->")) return 5;
+  if (s.starts_with("<!--->")) return 6;
+
+  // Body of (?:[^-]|-[^-]|--[^>])*: the alternatives never overlap, so the
+  // greedy split is the only one, and it cannot run past a `-->`
+  std::size_t pos = 4;
+  const std::size_t n = s.size();
+  while (pos < n) {
+    if (s[pos] != '-') {
+      pos++;
+    } else if (pos + 1 < n && s[pos + 1] != '-') {
+      pos += 2;
+    } else if (pos + 2 < n && s[pos + 1] == '-' && s[pos + 2] != '>') {
+      pos += 3;
+    } else {
+      break;
+    }
+  }
+  return s.substr(pos).starts_with("-->") ? pos + 3 : 0;
+}
+
+}  // namespace
+
+std::size_t Utils::MatchHtmlTag(std::string_view s) {
+  if (s.size() < 3 || s[0] != '<') return 0;
+
+  const char c = s[1];
+  if (IsAsciiAlpha(c)) return MatchOpenTag(s);
+  if (c == '/') return MatchCloseTag(s);
+  if (c == '?') {
+    const std::size_t close = s.find("?>", 2);
+    return close == std::string_view::npos ? 0 : close + 2;
+  }
+  if (c != '!') return 0;
+
+  if (s.starts_with("<!--")) return MatchComment(s);
+  if (s.starts_with("<![CDATA[")) {
+    const std::size_t close = s.find("]]>", 9);
+    return close == std::string_view::npos ? 0 : close + 3;
+  }
+  if (IsAsciiAlpha(s[2])) {
+    const std::size_t close = s.find('>', 3);
+    return close == std::string_view::npos ? 0 : close + 1;
+  }
+  return 0;
+}
+
+namespace {
+
+// Folded text of a non-ASCII code point, in kCaseFoldText
+struct CaseFold {
+  char32_t code;
+  std::uint16_t offset;
+  std::uint8_t size;
+};
+
+#include "casefold_table.inc"
+
+// Decode the UTF-8 sequence at `pos`; stray bytes decode to themselves
+char32_t DecodeUtf8(std::string_view s, std::size_t pos, std::size_t* size) {
+  const auto lead = static_cast<unsigned char>(s[pos]);
+  std::size_t n = 1;
+  char32_t code = lead;
+  if (lead >= 0xF0) {
+    n = 4;
+    code = lead & 0x07;
+  } else if (lead >= 0xE0) {
+    n = 3;
+    code = lead & 0x0F;
+  } else if (lead >= 0xC0) {
+    n = 2;
+    code = lead & 0x1F;
+  }
+  if (n == 1 || pos + n > s.size()) {
+    *size = 1;
+    return lead;
+  }
+  for (std::size_t i = 1; i < n; i++) {
+    const auto c = static_cast<unsigned char>(s[pos + i]);
+    if ((c & 0xC0) != 0x80) {
+      *size = 1;
+      return lead;
+    }
+    code = (code << 6) | (c & 0x3F);
+  }
+  *size = n;
+  return code;
+}
+
+constexpr std::string_view kEscapable = "\\!\"#$%&'()*+,./:;<=>?@[]^_`{|}~-";
+
+}  // namespace
+
+std::string Utils::NormalizeReference(std::string_view label) {
+  std::string out;
+  out.reserve(label.size());
+
+  bool space = false;
+  std::size_t pos = 0;
+  while (pos < label.size()) {
+    const char c = label[pos];
+    if (IsLabelSpace(c)) {
+      space = !out.empty();
+      pos++;
+      continue;
+    }
+    if (space) {
+      out += ' ';
+      space = false;
+    }
+
+    const auto byte = static_cast<unsigned char>(c);
+    if (byte < 0x80) {
+      out += static_cast<char>(c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+      pos++;
+      continue;
+    }
+
+    std::size_t size;
+    const char32_t code = DecodeUtf8(label, pos, &size);
+    const auto it = std::lower_bound(
+        std::begin(kCaseFolds), std::end(kCaseFolds), code,
+        [](const CaseFold& fold, char32_t c) { return fold.code < c; });
+    if (it != std::end(kCaseFolds) && it->code == code) {
+      out += kCaseFoldText.substr(it->offset, it->size);
+    } else {
+      out += label.substr(pos, size);
+    }
+    pos += size;
+  }
+
+  return out;
+}
+
+std::string Utils::UnescapeAll(std::string_view s) {
+  std::size_t pos = s.find_first_of("\\&");
+  if (pos == std::string_view::npos) return std::string(s);
+
+  std::string out(s.substr(0, pos));
+  while (pos < s.size()) {
+    const char c = s[pos];
+    if (c == '\\' && pos + 1 < s.size() &&
+        kEscapable.find(s[pos + 1]) != std::string_view::npos) {
+      out += s[pos + 1];
+      pos += 2;
+      continue;
+    }
+    if (c == '&') {
+      const Entities::Match match = Entities::Decode(s.substr(pos));
+      if (match) {
+        out += match.Text();
+        pos += match.length;
+        continue;
+      }
+    }
+    out += c;
+    pos++;
+  }
+
+  return out;
+}
+
 }  // namespace aethermark
@@ -0,0 +1,211 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/aethermark.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/ruler.hpp"
+#include "aethermark/rules_block/state_block.hpp"
+#include "aethermark/rules_core/state_core.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+const char kDoc[] = "para\n\n> quote\n> more\n\n    code\n";
+
+// ---------- Enable / Disable ----------
+
+TEST(Aethermark, DisableRemovesRuleFromChain) {
+  am::Aethermark md("commonmark");
+  const std::size_t with_quote = md.Parse(kDoc, {}).size();
+
+  md.Disable({"blockquote"});
+  EXPECT_NE(md.Parse(kDoc, {}).size(), with_quote);
+
+  md.Enable({"blockquote"});
+  EXPECT_EQ(md.Parse(kDoc, {}).size(), with_quote);
+}
+
+TEST(Aethermark, UnknownRuleNameThrowsWithoutChanges) {
+  am::Aethermark md("commonmark");
+  const std::size_t before = md.Parse(kDoc, {}).size();
+
+  EXPECT_THROW(md.Disable({"blockquote", "nope"}), std::runtime_error);
+  EXPECT_EQ(md.Parse(kDoc, {}).size(), before);
+  EXPECT_NO_THROW(md.Disable({"nope"}, true));
+}
+
+// ---------- Parse into a result ----------
+
+TEST(Aethermark, ParseIntoResultReplacesTokens) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult expected = md.Parse(kDoc, {});
+
+  am::ParseResult out;
+  md.Parse("stale\n\nstale\n", {}, out);
+  const std::size_t capacity = out.Source().capacity();
+
+  md.Parse(kDoc, {}, out);
+  ASSERT_EQ(out.size(), expected.size());
+  for (std::size_t i = 0; i < out.size(); i++) {
+    EXPECT_EQ(out[i].type, expected[i].type) << "token " << i;
+    EXPECT_EQ(out[i].content, expected[i].content) << "token " << i;
+  }
+  EXPECT_GE(out.Source().capacity(), capacity);
+
+  md.ParseInline("*a*", {}, out);
+  ASSERT_FALSE(out.empty());
+  EXPECT_EQ(out[0].type, am::TokenKind::kInline);
+  EXPECT_EQ(out[0].content, "*a*");
+  EXPECT_EQ(out.Tokens().RootRuns().size(), 1u);
+  EXPECT_EQ(out.Tokens().RootRuns()[0].size(), 1u);
+}
+
+TEST(Aethermark, EnvIsSharedWithBlockRules) {
+  static const am::EnvSlot<int> kParagraphs;
+
+  am::Aethermark md("commonmark");
+  md.block_parser.ruler.Before(
+      "paragraph", "count_paragraphs",
+      [](am::StateBlock& state, int, int, bool silent) {
+        if (!silent) state.env.Get(kParagraphs)++;
+        return false;
+      });
+
+  std::string src = "one\n\ntwo\n";
+  am::ParseEnv env;
+  am::TokenList tokens;
+  am::StateCore state(src, md, env, tokens);
+  md.core_parser.Process(state);
+  EXPECT_EQ(env.Get(kParagraphs), 2);
+
+  // the env of a parse ends up in its result
+  EXPECT_EQ(md.Parse(src, {}).Env().Get(kParagraphs), 2);
+}
+
+// ---------- Concurrency ----------
+
+TEST(Aethermark, SharedInstanceParsesFromManyThreads) {
+  am::Aethermark md("commonmark");
+  const std::size_t with_quote = md.Parse(kDoc, {}).size();
+  md.Disable({"blockquote"});
+  const std::size_t without_quote = md.Parse(kDoc, {}).size();
+  md.Enable({"blockquote"});
+
+  std::atomic<bool> done = false;
+  std::atomic<int> unexpected = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        std::size_t size = md.Parse(kDoc, {}).size();
+        if (size != with_quote && size != without_quote) unexpected++;
+      }
+    });
+  }
+
+  // Reconfigure while the readers parse
+  for (int i = 0; i < 200; i++) {
+    md.Disable({"blockquote"});
+    md.Enable({"blockquote"});
+  }
+  done = true;
+  for (std::thread& reader : readers) reader.join();
+
+  EXPECT_EQ(unexpected.load(), 0);
+}
+
+TEST(Aethermark, ParsesNeverSeePartOfAChange) {
+  // The change spans the block ruler and both inline rulers
+  const std::vector<std::string> rules = {"blockquote", "emphasis"};
+  const char doc[] = "> *a*\n";
+  auto count = [](const am::ParseResult& result) {
+    int found = 0;
+    for (std::size_t i = 0; i < result.size(); i++) {
+      if (result[i].type == am::TokenKind::kBlockquoteOpen ||
+          result[i].type == am::TokenKind::kEmOpen) {
+        found++;
+      }
+    }
+    return found;
+  };
+
+  am::Aethermark md("commonmark");
+  ASSERT_EQ(count(md.Parse(doc, {})), 2);
+
+  std::atomic<bool> done = false;
+  std::atomic<int> mixed = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        if (count(md.Parse(doc, {})) == 1) mixed++;
+      }
+    });
+  }
+
+  for (int i = 0; i < 200; i++) {
+    md.Disable(rules);
+    md.Enable(rules);
+  }
+  done = true;
+  for (std::thread& reader : readers) reader.join();
+
+  EXPECT_EQ(mixed.load(), 0);
+}
+
+TEST(Aethermark, UsePublishesOnceThePluginReturns) {
+  am::Aethermark md("commonmark");
+  const std::shared_ptr<const am::ParserRules> before = md.Rules();
+
+  md.Use([&](am::Aethermark& self) {
+    self.block_parser.ruler.Disable("blockquote");
+    self.inline_parser.ruler.Disable("emphasis");
+    EXPECT_EQ(self.Rules(), before);
+  });
+  EXPECT_NE(md.Rules(), before);
+
+  // A direct ruler change publishes on its own
+  const std::shared_ptr<const am::ParserRules> after_use = md.Rules();
+  md.block_parser.ruler.Enable("blockquote");
+  EXPECT_NE(md.Rules(), after_use);
+  EXPECT_EQ(md.Rules()->inline_rules, after_use->inline_rules);
+}
+
+TEST(Aethermark, ReplacedRulesAreFreedWhileParsesRun) {
+  am::Aethermark md("commonmark");
+
+  // Parses overlap, so some configuration is held at every moment
+  std::vector<std::weak_ptr<const am::ParserRules>> released;
+  std::vector<std::weak_ptr<const am::RuleChains<am::RuleBlock>>> blocks;
+  std::shared_ptr<const am::ParserRules> reader = md.Rules();
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      md.Disable({"blockquote"});
+    } else {
+      md.Enable({"blockquote"});
+    }
+    std::shared_ptr<const am::ParserRules> next = md.Rules();
+    released.emplace_back(reader);
+    blocks.emplace_back(reader->block_rules);
+    reader = std::move(next);
+  }
+
+  for (const auto& rules : released) EXPECT_TRUE(rules.expired());
+  for (const auto& chains : blocks) EXPECT_TRUE(chains.expired());
+}
+
+}  // namespace
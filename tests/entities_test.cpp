@@ -0,0 +1,81 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/entities.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+namespace am = aethermark;
+
+namespace {
+
+// Decoded text of the reference at the start of `s`, "-" if none.
+std::string Decoded(std::string_view s) {
+  const am::Entities::Match match = am::Entities::Decode(s);
+  if (!match) return "-";
+  return std::string(match.Text());
+}
+
+// ---------- Named ----------
+
+TEST(Entities, NamedLookup) {
+  EXPECT_EQ(am::Entities::Named("amp"), "&");
+  EXPECT_EQ(am::Entities::Named("copy"), "\xC2\xA9");
+  EXPECT_EQ(am::Entities::Named("CounterClockwiseContourIntegral"),
+            "\xE2\x88\xB3");
+  // Two code points
+  EXPECT_EQ(am::Entities::Named("NotEqualTilde"), "\xE2\x89\x82\xCC\xB8");
+}
+
+TEST(Entities, NamedIsCaseSensitive) {
+  EXPECT_EQ(am::Entities::Named("AMP"), "&");
+  EXPECT_EQ(am::Entities::Named("aMp"), "");
+  EXPECT_EQ(am::Entities::Named("Copy"), "");
+}
+
+TEST(Entities, UnknownNamesAreEmpty) {
+  EXPECT_EQ(am::Entities::Named(""), "");
+  EXPECT_EQ(am::Entities::Named("a"), "");
+  EXPECT_EQ(am::Entities::Named("ampx"), "");
+  EXPECT_EQ(am::Entities::Named(std::string(40, 'a')), "");
+}
+
+// ---------- Decode ----------
+
+TEST(Entities, DecodeNamed) {
+  EXPECT_EQ(Decoded("&lt;b"), "<");
+  EXPECT_EQ(am::Entities::Decode("&lt;b").length, 4u);
+  // Legacy names without `;` are not references in markdown
+  EXPECT_EQ(Decoded("&lt b"), "-");
+  EXPECT_EQ(Decoded("&nosuch;"), "-");
+  EXPECT_EQ(Decoded("&1a;"), "-");
+}
+
+TEST(Entities, DecodeNumeric) {
+  EXPECT_EQ(Decoded("&#65;"), "A");
+  EXPECT_EQ(Decoded("&#x41;"), "A");
+  EXPECT_EQ(Decoded("&#X1F600;"), "\xF0\x9F\x98\x80");
+  EXPECT_EQ(Decoded("&#0000065;"), "A");
+  EXPECT_EQ(am::Entities::Decode("&#0000065;").length, 10u);
+}
+
+TEST(Entities, DecodeNumericLimits) {
+  // At most 7 decimal and 6 hex digits
+  EXPECT_EQ(Decoded("&#12345678;"), "-");
+  EXPECT_EQ(Decoded("&#x1234567;"), "-");
+  EXPECT_EQ(Decoded("&#;"), "-");
+  EXPECT_EQ(Decoded("&#x;"), "-");
+  EXPECT_EQ(Decoded("&#65"), "-");
+}
+
+TEST(Entities, InvalidCodePointsBecomeReplacementCharacter) {
+  EXPECT_EQ(Decoded("&#0;"), "\xEF\xBF\xBD");
+  EXPECT_EQ(Decoded("&#xD800;"), "\xEF\xBF\xBD");
+  EXPECT_EQ(Decoded("&#x110000;"), "\xEF\xBF\xBD");
+  EXPECT_EQ(Decoded("&#x9F;"), "\xEF\xBF\xBD");
+  EXPECT_EQ(Decoded("&#9;"), "\t");
+}
+
+}  // namespace
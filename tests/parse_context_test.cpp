@@ -0,0 +1,216 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/parse_context.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/static_aethermark.hpp"
+#include "aethermark/token.hpp"
+#include "alloc_counter.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Upstream resource that counts the blocks requested from it.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  int allocations = 0;
+  int live = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    allocations++;
+    live++;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+    live--;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+const std::vector<std::string> kDocuments = {
+    "hello\nworld\n",
+    "> quote\n> more\nlazy\n\nafter\n",
+    "",
+    "    code\n    block\n\ntext\n",
+    "> outer\n>> inner\n\npara one\n\npara two\n",
+};
+
+void ExpectSameTokens(const am::ParseResult& expected,
+                      const am::ParseResult& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    const am::Token& a = expected.Tokens()[i];
+    const am::Token& b = actual.Tokens()[i];
+    EXPECT_EQ(a.type, b.type) << "token " << i;
+    EXPECT_EQ(a.nesting, b.nesting) << "token " << i;
+    EXPECT_EQ(a.level, b.level) << "token " << i;
+    EXPECT_EQ(a.map, b.map) << "token " << i;
+    EXPECT_EQ(a.content, b.content) << "token " << i;
+    EXPECT_EQ(a.children, b.children) << "token " << i;
+  }
+}
+
+// ---------- BlockCache ----------
+
+TEST(BlockCache, ReusesBlocksOfTheSameSize) {
+  CountingResource upstream;
+  am::BlockCache cache(&upstream);
+
+  void* a = cache.allocate(4096, 16);
+  cache.deallocate(a, 4096, 16);
+  EXPECT_EQ(cache.CachedBytes(), 4096u);
+
+  EXPECT_EQ(cache.allocate(4096, 16), a);
+  EXPECT_EQ(cache.CachedBytes(), 0u);
+  EXPECT_EQ(upstream.allocations, 1);
+
+  void* b = cache.allocate(8192, 16);
+  EXPECT_EQ(upstream.allocations, 2);
+  cache.deallocate(a, 4096, 16);
+  cache.deallocate(b, 8192, 16);
+}
+
+TEST(BlockCache, RoundsRequestsToSizeClasses) {
+  CountingResource upstream;
+  am::BlockCache cache(&upstream);
+
+  void* a = cache.allocate(5000, 16);
+  cache.deallocate(a, 5000, 16);
+  EXPECT_EQ(cache.CachedBytes(), 8192u);
+
+  EXPECT_EQ(cache.allocate(6144, 16), a);
+  EXPECT_EQ(upstream.allocations, 1);
+  cache.deallocate(a, 6144, 16);
+}
+
+TEST(BlockCache, CapsTheNumberOfCachedBlocks) {
+  CountingResource upstream;
+  am::BlockCache cache(&upstream);
+
+  std::vector<void*> blocks;
+  for (std::size_t i = 0; i < am::BlockCache::kMaxCachedBlocks + 8; i++) {
+    blocks.push_back(cache.allocate(64, 8));
+  }
+  for (void* p : blocks) cache.deallocate(p, 64, 8);
+
+  EXPECT_EQ(upstream.live, static_cast<int>(am::BlockCache::kMaxCachedBlocks));
+  EXPECT_EQ(cache.CachedBytes(), am::BlockCache::kMaxCachedBlocks * 64);
+}
+
+TEST(BlockCache, ReleaseReturnsCachedBlocks) {
+  CountingResource upstream;
+  {
+    am::BlockCache cache(&upstream);
+    void* a = cache.allocate(64, 8);
+    void* b = cache.allocate(128, 8);
+    cache.deallocate(a, 64, 8);
+
+    cache.Release();
+    EXPECT_EQ(upstream.live, 1);
+    cache.deallocate(b, 128, 8);
+  }
+  EXPECT_EQ(upstream.live, 0);
+}
+
+// ---------- Reuse ----------
+
+TEST(ParseContext, ResultsMatchParsesWithoutContext) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+
+  for (int round = 0; round < 2; round++) {
+    for (const std::string& doc : kDocuments) {
+      am::ParseResult expected = md.Parse(doc, {});
+      ExpectSameTokens(expected, md.Parse(doc, {}, context));
+      ExpectSameTokens(md.ParseInline(doc, {}),
+                       md.ParseInline(doc, {}, context));
+    }
+  }
+}
+
+TEST(ParseContext, ReturnsTheResultItHolds) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+
+  am::ParseResult& result = md.Parse("text\n", {}, context);
+  EXPECT_EQ(&result, &context.Result());
+  EXPECT_EQ(result.Source(), "text\n");
+
+  context.Reset();
+  EXPECT_TRUE(context.Result().empty());
+  EXPECT_TRUE(context.Result().Source().empty());
+}
+
+TEST(ParseContext, KeepsArenaBlocksBetweenParses) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+  const std::string doc(4096, 'x');
+
+  md.Parse(doc, {}, context);
+  const std::size_t source_capacity = context.Result().Source().capacity();
+
+  md.Parse(doc, {}, context);
+  EXPECT_EQ(context.Result().Source().capacity(), source_capacity);
+  EXPECT_EQ(context.Result().Source(), doc);
+
+  context.Trim();
+  EXPECT_TRUE(context.Result().empty());
+  ExpectSameTokens(md.Parse(doc, {}), md.Parse(doc, {}, context));
+}
+
+TEST(ParseContext, ReusedContextParsesWithoutAllocating) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+
+  // escapes and emphasis leave joined text children behind, so every parse
+  // compacts its token list
+  std::string doc;
+  for (int i = 0; i < 50; i++) {
+    doc += "para *em* and `code` x \\* y [a] **b**\n\n> quote *q*\n\n";
+  }
+
+  md.Parse(doc, {}, context);
+  md.Parse(doc, {}, context);
+
+  const am::bench::AllocStats before = am::bench::AllocSnapshot();
+  md.Parse(doc, {}, context);
+  EXPECT_EQ(am::bench::AllocSince(before).count, 0u);
+}
+
+TEST(ParseContext, TrimFreesTheTokenArray) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+
+  md.Parse(kDocuments[4], {}, context);
+  ASSERT_GT(context.Result().Tokens().capacity(), 0u);
+
+  context.Trim();
+  EXPECT_EQ(context.Result().Tokens().capacity(), 0u);
+  ExpectSameTokens(md.Parse(kDocuments[4], {}),
+                   md.Parse(kDocuments[4], {}, context));
+}
+
+TEST(ParseContext, WorksWithStaticAethermark) {
+  am::StaticAethermark<am::PresetId::kCommonmark> fixed;
+  am::ParseContext context;
+
+  for (const std::string& doc : kDocuments) {
+    am::ParseResult expected = fixed.Parse(doc, {});
+    ExpectSameTokens(expected, fixed.Parse(doc, {}, context));
+  }
+}
+
+}  // namespace
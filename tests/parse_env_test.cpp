@@ -0,0 +1,183 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/parse_env.hpp"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+struct PluginState {
+  std::vector<int> values;
+};
+
+// ---------- Tables ----------
+
+TEST(ParseEnv, FindReferenceByView) {
+  am::ParseEnv env;
+  env.references["foo"] = {"/url", "title"};
+
+  const std::string source = "[foo]";
+  const am::LinkReference* ref =
+      env.FindReference(std::string_view(source).substr(1, 3));
+  ASSERT_NE(ref, nullptr);
+  EXPECT_EQ(ref->href, "/url");
+  EXPECT_EQ(ref->title, "title");
+  EXPECT_EQ(env.FindReference("bar"), nullptr);
+}
+
+TEST(ParseEnv, FindReferenceNormalizesTheLabel) {
+  am::ParseEnv env;
+  EXPECT_TRUE(env.AddReference("  Foo\t\n Bar ", {"/url", ""}));
+
+  EXPECT_NE(env.FindReference("foo bar"), nullptr);
+  EXPECT_NE(env.FindReference("FOO   BAR"), nullptr);
+  EXPECT_NE(env.FindReference("\nfoo\nbar\n"), nullptr);
+  EXPECT_EQ(env.FindReference("foobar"), nullptr);
+  EXPECT_EQ(env.references.begin()->first, "foo bar");
+}
+
+TEST(ParseEnv, FindReferenceFoldsUnicodeCase) {
+  am::ParseEnv env;
+  env.AddReference("\xC3\x84rger \xE1\xBA\x9E", {"/a", ""});  // Ärger ẞ
+
+  EXPECT_NE(env.FindReference("\xC3\xA4RGER SS"), nullptr);  // äRGER SS
+  EXPECT_NE(env.FindReference("\xC3\xA4rger \xC3\x9F"), nullptr);  // ärger ß
+  EXPECT_EQ(env.FindReference("arger ss"), nullptr);
+}
+
+TEST(ParseEnv, FirstDefinitionWins) {
+  am::ParseEnv env;
+  EXPECT_TRUE(env.AddReference("foo", {"/first", ""}));
+  EXPECT_FALSE(env.AddReference("FOO", {"/second", ""}));
+  EXPECT_EQ(env.FindReference("Foo")->href, "/first");
+}
+
+TEST(ParseEnv, SharedReferencesAreAFallback) {
+  am::ParseEnv glossary;
+  glossary.AddReference("term", {"/glossary#term", ""});
+  glossary.AddReference("other", {"/glossary#other", ""});
+  const std::shared_ptr<const am::ReferenceMap> table =
+      glossary.ShareReferences();
+  EXPECT_TRUE(glossary.references.empty());
+
+  am::ParseEnv env;
+  EXPECT_FALSE(env.HasReferences());
+  env.shared_references = table;
+  env.AddReference("other", {"/local", ""});
+  EXPECT_TRUE(env.HasReferences());
+
+  EXPECT_EQ(env.FindReference("Term")->href, "/glossary#term");
+  EXPECT_EQ(env.FindReference("other")->href, "/local");
+  EXPECT_EQ(env.FindReference("missing"), nullptr);
+}
+
+TEST(ParseEnv, UniqueSlugSuffixesRepeats) {
+  am::ParseEnv env;
+
+  EXPECT_EQ(env.UniqueSlug("intro"), "intro");
+  EXPECT_EQ(env.UniqueSlug("intro"), "intro-1");
+  EXPECT_EQ(env.UniqueSlug("intro-2"), "intro-2");
+  EXPECT_EQ(env.UniqueSlug("intro"), "intro-3");
+}
+
+// ---------- Plugin slots ----------
+
+TEST(ParseEnv, SlotsAreTypedAndIndependent) {
+  static const am::EnvSlot<PluginState> kState;
+  static const am::EnvSlot<int> kCounter;
+  EXPECT_NE(kState.id(), kCounter.id());
+
+  am::ParseEnv env;
+  env.Get(kState).values.push_back(7);
+  env.Get(kCounter) = 3;
+
+  EXPECT_EQ(env.Get(kState).values, std::vector<int>{7});
+  EXPECT_EQ(env.Get(kCounter), 3);
+}
+
+TEST(ParseEnv, ClearEmptiesTablesAndSlots) {
+  static const am::EnvSlot<int> kCounter;
+
+  am::ParseEnv env;
+  env.references["foo"] = {"/url", ""};
+  env.footnotes.refs["1"] = 0;
+  env.footnotes.list.push_back({"1", 1});
+  env.UniqueSlug("intro");
+  env.Get(kCounter) = 5;
+
+  env.Clear();
+  EXPECT_TRUE(env.references.empty());
+  EXPECT_TRUE(env.footnotes.refs.empty());
+  EXPECT_TRUE(env.footnotes.list.empty());
+  EXPECT_EQ(env.UniqueSlug("intro"), "intro");
+  EXPECT_EQ(env.Get(kCounter), 0);
+}
+
+// ---------- Parse ----------
+
+TEST(ParseEnv, ContextResetClearsTheEnv) {
+  am::Aethermark md("commonmark");
+  am::ParseContext context;
+
+  am::ParseEnv env;
+  env.references["foo"] = {"/url", ""};
+  md.Parse("text\n", std::move(env), context);
+  EXPECT_NE(context.Result().Env().FindReference("foo"), nullptr);
+
+  md.Parse("text\n", {}, context);
+  EXPECT_EQ(context.Result().Env().FindReference("foo"), nullptr);
+}
+
+TEST(ParseEnv, ReferenceDefinitionsFillTheEnv) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.Parse(
+      "[Foo]: /url \"title\"\n[bar]:\n<my url>\n'multi\nline'\n\n"
+      "[foo]: /ignored\n",
+      {});
+
+  ASSERT_EQ(result.Env().references.size(), 2u);
+  EXPECT_EQ(result.Env().FindReference("foo")->href, "/url");
+  EXPECT_EQ(result.Env().FindReference("foo")->title, "title");
+  EXPECT_EQ(result.Env().FindReference("BAR")->title, "multi\nline");
+  // Definitions produce no tokens
+  EXPECT_EQ(result.size(), 0u);
+}
+
+TEST(ParseEnv, InvalidDefinitionsArePlainParagraphs) {
+  am::Aethermark md("commonmark");
+  for (const char* src : {"[]: /url\n", "[foo]: /url \"title\" junk\n",
+                          "[foo] /url\n", "[foo]:\n", "    [foo]: /url\n"}) {
+    const am::ParseResult result = md.Parse(src, {});
+    EXPECT_TRUE(result.Env().references.empty()) << src;
+  }
+}
+
+TEST(ParseEnv, SharedReferencesResolveLinks) {
+  am::Aethermark md("commonmark");
+  am::ParseResult glossary = md.Parse("[API]: /docs/api\n", {});
+  const std::shared_ptr<const am::ReferenceMap> table =
+      glossary.Env().ShareReferences();
+
+  for (int i = 0; i < 2; i++) {
+    am::ParseEnv env;
+    env.shared_references = table;
+    const am::ParseResult result = md.Parse("See [api].\n", std::move(env));
+
+    const auto children = result.Tokens().Children(result[1]);
+    ASSERT_EQ(children.size(), 5u);
+    EXPECT_EQ(children[1].AttrGet(am::AttrKind::kHref), "/docs/api");
+  }
+}
+
+}  // namespace
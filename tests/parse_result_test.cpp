@@ -0,0 +1,229 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/parse_result.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <utility>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Upstream resource that counts the blocks requested by the arena.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  int allocations = 0;
+  int live = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    allocations++;
+    live++;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+    live--;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// ---------- Arena ownership ----------
+
+TEST(ParseResult, StartsEmpty) {
+  am::ParseResult result;
+  EXPECT_TRUE(result.empty());
+  EXPECT_EQ(result.size(), 0u);
+}
+
+TEST(ParseResult, TokensAreAllocatedFromArena) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("hello\nworld\n\n> quote\n", {});
+
+  ASSERT_FALSE(result.empty());
+  std::pmr::memory_resource* arena = result.Allocator().resource();
+  EXPECT_EQ(result.Tokens().get_allocator().resource(), arena);
+
+  for (const am::Token& t : result) {
+    EXPECT_EQ(t.get_allocator().resource(), arena);
+    EXPECT_EQ(t.content.get_allocator().resource(), arena);
+  }
+}
+
+TEST(ParseResult, MoveKeepsTokensValid) {
+  am::Aethermark md("commonmark");
+  am::ParseResult first = md.Parse("a paragraph too long for sso\n", {});
+  const am::Token* inline_token = &first[1];
+
+  am::ParseResult second = std::move(first);
+  ASSERT_EQ(second.size(), 4u);
+  EXPECT_EQ(&second[1], inline_token);
+  EXPECT_EQ(second[1].content, "a paragraph too long for sso");
+}
+
+TEST(ParseResult, HoldsOnlyTokensOfTheTree) {
+  am::Aethermark md("commonmark");
+  // Escape and entity rules each emit a text token, merged by text_join
+  am::ParseResult result = md.Parse("a\\*b&amp;c\n", {});
+
+  std::size_t walked = 0;
+  result.Tokens().Walk([&](const am::Token&, int) { walked++; });
+  EXPECT_EQ(walked, 4u);
+  ASSERT_EQ(result.size(), walked);
+  EXPECT_EQ(result[3].type, am::TokenKind::kText);
+  EXPECT_EQ(result[3].content, "a*b&c");
+}
+
+TEST(ParseResult, ArenaBlocksComeFromUpstream) {
+  CountingResource upstream;
+  {
+    am::ParseResult result(0, &upstream);
+    for (int i = 0; i < 1000; i++) {
+      am::Token& t =
+          result.Tokens().emplace_back("text", "", am::Nesting::kSelfClosing);
+      t.content = std::string(100, 'x');
+    }
+    // A thousand tokens with heap-sized content, but only a few arena blocks.
+    EXPECT_GT(upstream.allocations, 0);
+    EXPECT_LT(upstream.allocations, 20);
+  }
+  EXPECT_EQ(upstream.live, 0);
+}
+
+TEST(ParseResult, TokenArrayComesFromUpstream) {
+  CountingResource upstream;
+  am::ParseResult result(0, &upstream);
+  EXPECT_EQ(result.Tokens().BufferResource(), &upstream);
+
+  for (int i = 0; i < 1000; i++) {
+    result.Tokens().emplace_back("hr", "hr", am::Nesting::kSelfClosing);
+  }
+  // Every growth gave the old array back: only the token array and the root
+  // runs are live, and tokens owning nothing left the arena untouched
+  EXPECT_EQ(upstream.live, 2);
+
+  result.Reset();
+  EXPECT_TRUE(result.empty());
+  EXPECT_EQ(upstream.live, 2);
+}
+
+// ---------- Source spans ----------
+
+TEST(ParseResult, ContiguousContentBorrowsSource) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("  first line\nsecond line  \n", {});
+
+  // Paragraph open, inline and close, then text, softbreak and text
+  ASSERT_EQ(result.size(), 6u);
+  const am::TokenString& content = result[1].content;
+  EXPECT_TRUE(content.IsBorrowed());
+  EXPECT_EQ(content, "first line\nsecond line");
+
+  const std::string& source = result.Source();
+  EXPECT_GE(content.View().data(), source.data());
+  EXPECT_LE(content.View().data() + content.size(),
+            source.data() + source.size());
+
+  // Text children borrow the same source
+  for (const am::Token& child : result.Tokens().Children(result[1])) {
+    if (child.type != am::TokenKind::kText) continue;
+    EXPECT_TRUE(child.content.IsBorrowed());
+    EXPECT_GE(child.content.View().data(), source.data());
+  }
+}
+
+TEST(ParseResult, SingleLineCodeBlockBorrowsSource) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("    code\n", {});
+
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_TRUE(result[0].content.IsBorrowed());
+  EXPECT_EQ(result[0].content, "code\n");
+}
+
+TEST(ParseResult, NonContiguousContentIsOwned) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("    one\n    two\n\n> a\n> b\n", {});
+
+  ASSERT_EQ(result[0].type, "code_block");
+  EXPECT_FALSE(result[0].content.IsBorrowed());
+  EXPECT_EQ(result[0].content, "one\ntwo\n");
+
+  ASSERT_EQ(result[3].type, "inline");
+  EXPECT_FALSE(result[3].content.IsBorrowed());
+  EXPECT_EQ(result[3].content, "a\nb");
+}
+
+TEST(ParseResult, BorrowedContentSurvivesMove) {
+  am::Aethermark md("commonmark");
+  am::ParseResult first = md.Parse("x\n", {});
+  am::ParseResult second = std::move(first);
+
+  ASSERT_TRUE(second[1].content.IsBorrowed());
+  EXPECT_EQ(second[1].content.View().data(), second.Source().data());
+}
+
+// ---------- Fences ----------
+
+TEST(ParseResult, FenceBodyBorrowsSource) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("```js\none\ntwo\n```\n", {});
+
+  ASSERT_EQ(result[0].type, "fence");
+  ASSERT_TRUE(result[0].content.IsBorrowed());
+  EXPECT_EQ(result[0].content.View().data(), result.Source().data() + 6);
+
+  am::ParseResult moved = std::move(result);
+  EXPECT_EQ(moved[0].content.View().data(), moved.Source().data() + 6);
+  EXPECT_EQ(moved[0].content, "one\ntwo\n");
+}
+
+// ---------- Allocator-aware tokens ----------
+
+TEST(ParseResult, TokenCopyAdoptsTargetAllocator) {
+  am::Token source("inline", "", am::Nesting::kSelfClosing);
+  source.content = "content that is too long for small string storage";
+  source.AttrSet("class", "lead");
+
+  am::ParseResult result;
+  am::Token& copy = result.Tokens().emplace_back(source);
+  std::pmr::memory_resource* arena = result.Allocator().resource();
+
+  EXPECT_EQ(copy.content, source.content);
+  EXPECT_EQ(copy.content.get_allocator().resource(), arena);
+  ASSERT_FALSE(copy.attrs.empty());
+  EXPECT_EQ(copy.attrs.get_allocator().resource(), arena);
+  EXPECT_EQ(copy.AttrGet("class").value(), "lead");
+}
+
+TEST(ParseResult, ListCopyAdoptsTargetAllocator) {
+  am::TokenList source;
+  source.emplace_back("inline", "", am::Nesting::kSelfClosing);
+  source.BeginChildren(0);
+  source.emplace_back("text", "", am::Nesting::kSelfClosing).content =
+      "child content that is too long for small string storage";
+  source.EndChildren();
+
+  am::ParseResult result;
+  result.Tokens() = am::TokenList(source, result.Allocator());
+  const am::TokenList& copy = result.Tokens();
+  std::pmr::memory_resource* arena = result.Allocator().resource();
+
+  ASSERT_EQ(copy.size(), 2u);
+  EXPECT_EQ(copy.get_allocator().resource(), arena);
+  ASSERT_EQ(copy.Children(copy[0]).size(), 1u);
+  EXPECT_EQ(copy.Children(copy[0])[0].content.get_allocator().resource(),
+            arena);
+}
+
+}  // namespace
@@ -0,0 +1,447 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/parser_inline.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/rules_inline/rules_inline.hpp"
+#include "aethermark/token.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Children of the inline token of a single inline string, as
+// `type:content` strings. Text joining is off so the tokens are the ones the
+// rules pushed.
+std::vector<std::string> Children(am::Aethermark& md,  // NOLINT
+                                  const std::string& src) {
+  md.Disable({"text_join"}, true);
+  const am::ParseResult result = md.ParseInline(src, {});
+
+  std::vector<std::string> out;
+  for (const am::Token& t : result.Tokens().Children(result[0])) {
+    out.push_back(std::string(t.type.Name()) + ":" +
+                  std::string(t.content.View()));
+  }
+  return out;
+}
+
+using Tokens = std::vector<std::string>;
+
+// ---------- Text ----------
+
+TEST(ParserInline, PlainTextIsOneToken) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "hello world"), Tokens({"text:hello world"}));
+}
+
+TEST(ParserInline, TerminatorsWithoutRuleStayText) {
+  am::Aethermark md("commonmark");
+  // `+`, `=` and `~` end text runs but nothing matches them, so the pending
+  // text keeps growing and ends up in one token
+  EXPECT_EQ(Children(md, "a+b=c~d"), Tokens({"text:a+b=c~d"}));
+}
+
+TEST(ParserInline, TextBorrowsSource) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.Parse("some text\n", {});
+
+  const auto children = result.Tokens().Children(result[1]);
+  ASSERT_EQ(children.size(), 1u);
+  EXPECT_TRUE(children[0].content.IsBorrowed());
+  EXPECT_EQ(children[0].content, "some text");
+}
+
+TEST(ParserInline, OwnedParentContentIsCopied) {
+  am::Aethermark md("commonmark");
+  // Blockquote markers make the paragraph content non-contiguous
+  const am::ParseResult result = md.Parse("> first\n> second\n", {});
+
+  std::size_t texts = 0;
+  for (const am::Token& t : result) {
+    if (t.type != am::TokenKind::kInline) continue;
+    ASSERT_FALSE(t.content.IsBorrowed());
+    for (const am::Token& child : result.Tokens().Children(t)) {
+      if (child.type != am::TokenKind::kText) continue;
+      EXPECT_FALSE(child.content.IsBorrowed());
+      texts++;
+    }
+  }
+  EXPECT_EQ(texts, 2u);
+}
+
+TEST(ParserInline, ChildrenLiveUnderTheInlineToken) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.Parse("one\n\ntwo\n", {});
+
+  std::vector<std::string> texts;
+  for (const am::Token& root : result.Tokens().Roots()) {
+    for (const am::Token& child : result.Tokens().Children(root)) {
+      EXPECT_EQ(child.type, am::TokenKind::kText);
+      texts.emplace_back(child.content.View());
+    }
+  }
+  EXPECT_EQ(texts, Tokens({"one", "two"}));
+}
+
+// ---------- Newline ----------
+
+TEST(ParserInline, NewlineIsSoftbreak) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a \n   b"),
+            Tokens({"text:a", "softbreak:", "text:b"}));
+}
+
+TEST(ParserInline, TrailingSpacesMakeHardbreak) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a   \nb"),
+            Tokens({"text:a", "hardbreak:", "text:b"}));
+}
+
+// ---------- Escape ----------
+
+TEST(ParserInline, EscapedPunctuationIsTextSpecial) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a\\*b"),
+            Tokens({"text:a", "text_special:*", "text:b"}));
+}
+
+TEST(ParserInline, EscapeKeepsBackslashBeforeOtherCharacters) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "\\a\\\xC3\xA9"),
+            Tokens({"text_special:\\a", "text_special:\\\xC3\xA9"}));
+}
+
+TEST(ParserInline, BackslashNewlineIsHardbreak) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a\\\n b"),
+            Tokens({"text:a", "hardbreak:", "text:b"}));
+}
+
+TEST(ParserInline, TextJoinMergesEscapes) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.ParseInline("a\\*b", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  ASSERT_EQ(children.size(), 1u);
+  EXPECT_EQ(children[0].content, "a*b");
+}
+
+// ---------- Entity ----------
+
+TEST(ParserInline, NamedAndNumericEntitiesAreTextSpecial) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a &amp; &#35; &#X22; b"),
+            Tokens({"text:a ", "text_special:&", "text: ",
+                    "text_special:#", "text: ", "text_special:\"",
+                    "text: b"}));
+}
+
+TEST(ParserInline, UnknownEntitiesAreText) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "&nosuch; &amp &#; &#12345678;"),
+            Tokens({"text:&nosuch; &amp &#; &#12345678;"}));
+}
+
+TEST(ParserInline, EntityKeepsItsMarkup) {
+  am::Aethermark md("commonmark");
+  md.Disable({"text_join"}, true);
+  const am::ParseResult result = md.ParseInline("&copy;", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  ASSERT_EQ(children.size(), 1u);
+  EXPECT_EQ(children[0].content, "\xC2\xA9");
+  EXPECT_EQ(children[0].markup, "&copy;");
+  EXPECT_EQ(children[0].info, "entity");
+}
+
+// ---------- Backticks ----------
+
+TEST(ParserInline, CodeSpan) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a `b` c"),
+            Tokens({"text:a ", "code_inline:b", "text: c"}));
+}
+
+TEST(ParserInline, CodeSpanStripsOneSpaceAndFoldsNewlines) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "`` a\nb ``"), Tokens({"code_inline:a b"}));
+  EXPECT_EQ(Children(md, "` a`"), Tokens({"code_inline: a"}));
+}
+
+TEST(ParserInline, UnmatchedBackticksAreText) {
+  am::Aethermark md("commonmark");
+  // No closer of length 2; the last single backtick has no closer either
+  EXPECT_EQ(Children(md, "``a` b``` `c`"),
+            Tokens({"text:``a", "code_inline:b```", "text:c`"}));
+}
+
+// ---------- Emphasis ----------
+
+TEST(ParserInline, EmphasisAndStrong) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "*a* __b__"),
+            Tokens({"em_open:", "text:a", "em_close:", "text: ",
+                    "strong_open:", "text:b", "strong_close:", "text:"}));
+}
+
+TEST(ParserInline, TripleMarkersNestEmphasisInStrong) {
+  am::Aethermark md("commonmark");
+  // The markers merged into strong leave empty text tokens, as in
+  // markdown-it
+  EXPECT_EQ(Children(md, "***a***"),
+            Tokens({"em_open:", "text:", "strong_open:", "text:a",
+                    "strong_close:", "text:", "em_close:"}));
+}
+
+TEST(ParserInline, EmphasisMarkupAndLevels) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.ParseInline("**a *b***", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  // "", strong_open, "a ", em_open, "b", em_close, strong_close, ""
+  ASSERT_EQ(children.size(), 8u);
+  EXPECT_EQ(children[1].type, am::TokenKind::kStrongOpen);
+  EXPECT_EQ(children[1].markup, "**");
+  EXPECT_EQ(children[1].level, 0);
+  EXPECT_EQ(children[3].type, am::TokenKind::kEmOpen);
+  EXPECT_EQ(children[3].markup, "*");
+  EXPECT_EQ(children[4].level, 2);
+  EXPECT_EQ(children[6].type, am::TokenKind::kStrongClose);
+  EXPECT_EQ(children[6].markup, "**");
+}
+
+TEST(ParserInline, UnderscoreDoesNotSplitWords) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "snake_case_name"),
+            Tokens({"text:snake_case_name"}));
+  EXPECT_EQ(Children(md, "a*b*c"),
+            Tokens({"text:a", "em_open:", "text:b", "em_close:", "text:c"}));
+}
+
+TEST(ParserInline, RuleOfThreeRejectsOddMatches) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "*foo**bar**baz*"),
+            Tokens({"em_open:", "text:foo", "strong_open:", "text:bar",
+                    "strong_close:", "text:baz", "em_close:"}));
+  EXPECT_EQ(Children(md, "*foo**bar*"),
+            Tokens({"em_open:", "text:foo**bar", "em_close:"}));
+}
+
+TEST(ParserInline, UnmatchedDelimitersStayText) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "**a *b"), Tokens({"text:**a *b"}));
+  EXPECT_EQ(Children(md, "a * b *"), Tokens({"text:a * b *"}));
+}
+
+TEST(ParserInline, UnicodePunctuationFlanks) {
+  am::Aethermark md("commonmark");
+  // Left and right of the markers are curly quotes, which are punctuation
+  EXPECT_EQ(Children(md, "\xE2\x80\x9C*a*\xE2\x80\x9D"),
+            Tokens({"text:\xE2\x80\x9C", "em_open:", "text:a", "em_close:",
+                    "text:\xE2\x80\x9D"}));
+  // No-break space counts as whitespace, so the closer does not close
+  EXPECT_EQ(Children(md, "*a\xC2\xA0*"), Tokens({"text:*a\xC2\xA0*"}));
+}
+
+TEST(ParserInline, PunctuationCoversEveryScript) {
+  am::Aethermark md("commonmark");
+  // Arabic comma, Armenian comma and a Greek math symbol are punctuation,
+  // so a closer between them and a letter is not right-flanking
+  for (const std::string mark : {"\xD8\x8C", "\xD5\x9D", "\xCF\xB6"}) {
+    EXPECT_EQ(Children(md, "*a" + mark + "*b"),
+              Tokens({"text:*a" + mark + "*b"}));
+  }
+  EXPECT_EQ(Children(md, "*a\xD8\xA8*b"),
+            Tokens({"em_open:", "text:a\xD8\xA8", "em_close:", "text:b"}));
+}
+
+TEST(ParserInline, PathologicalDelimitersStayLinear) {
+  am::Aethermark md("commonmark");
+  std::string src;
+  for (int i = 0; i < 20000; i++) src += "*a **a ";
+
+  // Quadratic matching takes seconds here; only the result is checked
+  const am::ParseResult result = md.ParseInline(src, {});
+  ASSERT_FALSE(result.empty());
+  EXPECT_FALSE(result.Tokens().Children(result[0]).empty());
+}
+
+// ---------- Links ----------
+
+TEST(ParserInline, InlineLink) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a [b *c*](/url \"t\") d"),
+            Tokens({"text:a ", "link_open:", "text:b ", "em_open:", "text:c",
+                    "em_close:", "link_close:", "text: d"}));
+
+  const am::ParseResult result = md.ParseInline("[b](<\\(/url\\)> 't')", {});
+  const am::Token& open = result.Tokens().Children(result[0])[0];
+  EXPECT_EQ(open.AttrGet(am::AttrKind::kHref), "(/url)");
+  EXPECT_EQ(open.AttrGet(am::AttrKind::kTitle), "t");
+}
+
+TEST(ParserInline, LinkLabelSkipsCodeSpans) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "[`]`](/u)"),
+            Tokens({"link_open:", "code_inline:]", "link_close:"}));
+}
+
+TEST(ParserInline, LinksDoNotNest) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "[a [b](/x)](/y)"),
+            Tokens({"text:[a ", "link_open:", "text:b", "link_close:",
+                    "text:](/y)"}));
+}
+
+TEST(ParserInline, ReferenceLinks) {
+  am::Aethermark md("commonmark");
+  md.Disable({"text_join"}, true);
+  am::ParseEnv env;
+  env.AddReference("Foo Bar", {"/url", "title"});
+  const am::ParseResult result = md.ParseInline(
+      "[foo  bar] [x][FOO BAR] [foo bar][] [nope]", std::move(env));
+
+  std::vector<std::string> hrefs;
+  for (const am::Token& t : result.Tokens().Children(result[0])) {
+    if (t.type == am::TokenKind::kLinkOpen) {
+      hrefs.emplace_back(t.AttrGet(am::AttrKind::kHref).value_or(""));
+      EXPECT_EQ(t.AttrGet(am::AttrKind::kTitle), "title");
+    }
+  }
+  EXPECT_EQ(hrefs, std::vector<std::string>({"/url", "/url", "/url"}));
+  EXPECT_EQ(std::string(result.Tokens().Children(result[0]).back().content),
+            " [nope]");
+}
+
+TEST(ParserInline, ImageDescriptionIsParsedIntoChildren) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result =
+      md.ParseInline("![a *b*](/img.png \"T\") c", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  ASSERT_EQ(children.size(), 2u);
+  const am::Token& image = children[0];
+  EXPECT_EQ(image.type, am::TokenKind::kImage);
+  EXPECT_EQ(image.content, "a *b*");
+  EXPECT_EQ(image.AttrGet(am::AttrKind::kSrc), "/img.png");
+  EXPECT_EQ(image.AttrGet(am::AttrKind::kTitle), "T");
+
+  std::vector<std::string> alt;
+  for (const am::Token& t : result.Tokens().Children(image)) {
+    alt.push_back(std::string(t.type.Name()) + ":" +
+                  std::string(t.content.View()));
+  }
+  EXPECT_EQ(alt, Tokens({"text:a ", "em_open:", "text:b", "em_close:"}));
+}
+
+// ---------- Autolink ----------
+
+TEST(ParserInline, UrlAutolink) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.ParseInline("<https://a.b/c>", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  ASSERT_EQ(children.size(), 3u);
+  EXPECT_EQ(children[0].type, am::TokenKind::kLinkOpen);
+  EXPECT_EQ(children[0].AttrGet(am::AttrKind::kHref), "https://a.b/c");
+  EXPECT_EQ(children[0].markup, "autolink");
+  EXPECT_EQ(children[1].content, "https://a.b/c");
+  EXPECT_EQ(children[1].level, 1);
+  EXPECT_EQ(children[2].type, am::TokenKind::kLinkClose);
+}
+
+TEST(ParserInline, EmailAutolink) {
+  am::Aethermark md("commonmark");
+  const am::ParseResult result = md.ParseInline("<foo@bar.example>", {});
+
+  const auto children = result.Tokens().Children(result[0]);
+  ASSERT_EQ(children.size(), 3u);
+  EXPECT_EQ(children[0].AttrGet(am::AttrKind::kHref),
+            "mailto:foo@bar.example");
+  EXPECT_EQ(children[1].content, "foo@bar.example");
+}
+
+TEST(ParserInline, InvalidAutolinksAreText) {
+  am::Aethermark md("zero");
+  md.Enable({"autolink"});
+  EXPECT_EQ(Children(md, "<a b:c> <javascript:x> <m:x>"),
+            Tokens({"text:<a b:c> <javascript:x> <m:x>"}));
+}
+
+// ---------- HTML ----------
+
+TEST(ParserInline, HtmlInlineNeedsTheOption) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "a <b class=\"x\">c</b> <!-- d -->"),
+            Tokens({"text:a ", "html_inline:<b class=\"x\">", "text:c",
+                    "html_inline:</b>", "text: ",
+                    "html_inline:<!-- d -->"}));
+
+  am::Options options;
+  options.html = false;
+  am::Aethermark plain("commonmark", options);
+  EXPECT_EQ(Children(plain, "a <b>"), Tokens({"text:a <b>"}));
+}
+
+TEST(ParserInline, MalformedHtmlIsText) {
+  am::Aethermark md("commonmark");
+  EXPECT_EQ(Children(md, "<b x=> <!-- a --->"),
+            Tokens({"text:<b x=> <!-- a --->"}));
+}
+
+// ---------- Rules ----------
+
+TEST(ParserInline, PresetRuleNamesAreKnown) {
+  am::Aethermark md("zero");
+  EXPECT_NO_THROW(md.Enable({"autolink", "backticks", "emphasis", "entity",
+                             "escape", "html_inline", "image", "link",
+                             "newline", "text", "balance_pairs",
+                             "fragments_join"}));
+}
+
+TEST(ParserInline, DisabledRuleLeavesItsMarkupAsText) {
+  am::Aethermark md("commonmark");
+  md.Disable({"backticks"});
+  EXPECT_EQ(Children(md, "`a`"), Tokens({"text:`a`"}));
+}
+
+// ---------- SkipText ----------
+
+TEST(ParserInline, SkipTextMatchesTheTerminatorTable) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> letter('a', 'z');
+
+  for (int round = 0; round < 200; round++) {
+    // Mostly letters with a few arbitrary bytes, to get long runs
+    std::string src(1 + round * 3, 'x');
+    for (char& c : src) {
+      c = static_cast<char>(byte(rng) < 16 ? byte(rng) : letter(rng));
+    }
+
+    for (std::size_t pos = 0; pos <= src.size(); pos++) {
+      std::size_t expected = pos;
+      while (expected < src.size() &&
+             !am::InlineRules::IsTerminator(
+                 static_cast<unsigned char>(src[expected]))) {
+        expected++;
+      }
+      ASSERT_EQ(am::InlineRules::SkipText(src, pos), expected)
+          << "round " << round << " pos " << pos;
+    }
+  }
+}
+
+}  // namespace
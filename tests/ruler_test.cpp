@@ -5,7 +5,10 @@
 #include <gtest/gtest.h>
 
 #include <functional>
+#include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
 using Fn = std::function<void(int&)>;
@@ -139,9 +142,9 @@ TEST(Ruler, IgnoredInvalidDisable) {
 TEST(Ruler, AltChainsWork) {
   am::Ruler<Fn> r;
 
-  r.Push("a", add1, {{"alt1"}});
-  r.Push("b", add2, {{"alt2"}});
-  r.Push("c", mul2, {{"alt1"}});
+  r.Push("a", add1, {{"alt1"}, ""});
+  r.Push("b", add2, {{"alt2"}, ""});
+  r.Push("c", mul2, {{"alt1"}, ""});
 
   auto alt1 = r.GetRules("alt1");
   auto alt2 = r.GetRules("alt2");
@@ -156,6 +159,160 @@ TEST(Ruler, AltChainsWork) {
   EXPECT_EQ(x, (1 + 1) * 2);
 }
 
+// ---------- Frozen chains ----------
+
+TEST(Ruler, GetChainReturnsFrozenFunctions) {
+  am::Ruler<Fn> r;
+
+  r.Push("a", add1, {{"alt1"}, ""});
+  r.Push("b", mul2);
+
+  am::RuleChain<Fn> def = r.GetChain(am::kDefaultChain);
+  ASSERT_EQ(def.size(), 2);
+  EXPECT_EQ(r.GetChain(am::kDefaultChain).data(), def.data());
+
+  int x = 1;
+  for (const Fn& fn : def) fn(x);
+  EXPECT_EQ(x, 4);
+
+  am::RuleSnapshot<Fn> frozen = r.Snapshot();
+  am::RuleChainId alt1 = r.ChainId("alt1");
+  ASSERT_EQ(frozen->Get(alt1).size(), 1);
+  EXPECT_EQ(frozen->Names(alt1)[0], "a");
+  EXPECT_EQ(frozen->Find("alt1"), alt1);
+}
+
+TEST(Ruler, ChainIdsSurviveRuleChanges) {
+  am::Ruler<Fn> r;
+
+  am::RuleChainId alt = r.ChainId("alt");
+  EXPECT_TRUE(r.GetChain(alt).empty());
+  EXPECT_EQ(r.ChainId("alt"), alt);
+
+  r.Push("a", add1, {{"alt"}, ""});
+  ASSERT_EQ(r.GetChain(alt).size(), 1);
+
+  r.Disable("a");
+  EXPECT_TRUE(r.GetChain(alt).empty());
+  EXPECT_TRUE(r.GetChain("unknown").empty());
+  EXPECT_TRUE(r.GetRules("unknown").empty());
+}
+
+TEST(Ruler, GetChainKeepsItsSnapshotAlive) {
+  am::Ruler<Fn> r;
+  r.Push("a", add1);
+  r.Push("b", mul2);
+
+  am::RuleChain<Fn> chain = r.GetChain(am::kDefaultChain, 'x');
+  r.Disable("a");
+  r.Push("c", add2);
+
+  // the chain still runs the rules it was taken with
+  int x = 1;
+  for (const Fn& fn : chain) fn(x);
+  EXPECT_EQ(x, 4);
+  EXPECT_EQ(r.GetChain(am::kDefaultChain).size(), 2);
+}
+
+TEST(Ruler, SnapshotIsUnaffectedByLaterChanges) {
+  am::Ruler<Fn> r;
+  r.Push("a", add1);
+
+  am::RuleSnapshot<Fn> before = r.Snapshot();
+  r.Push("b", add2);
+  r.Disable("a");
+
+  EXPECT_EQ(before->Get(am::kDefaultChain).size(), 1);
+  EXPECT_EQ(before->Names(am::kDefaultChain)[0], "a");
+  ASSERT_EQ(r.Snapshot()->Names(am::kDefaultChain).size(), 1);
+  EXPECT_EQ(r.Snapshot()->Names(am::kDefaultChain)[0], "b");
+}
+
+TEST(Ruler, LastReaderFreesReplacedSnapshots) {
+  // Copies of the rule function live exactly as long as the snapshots
+  // holding them
+  auto marker = std::make_shared<int>(0);
+  am::Ruler<Fn> r;
+  r.Push("a", [marker](int& x) { x += *marker; });
+
+  std::optional<am::RuleSnapshot<Fn>> reader(r.Snapshot());
+  r.At("a", add1);
+  r.Push("b", add2);
+  EXPECT_GT(marker.use_count(), 1);
+
+  // No modification follows, the release alone frees them
+  reader.reset();
+  EXPECT_EQ(marker.use_count(), 1);
+}
+
+TEST(Ruler, SnapshotsAreFreedWhileOtherReadersAreAlive) {
+  am::Ruler<Fn> r;
+  r.Push("a", add1);
+
+  // Readers overlap, so some snapshot is held at every moment
+  std::vector<std::weak_ptr<const am::RuleChains<Fn>>> released;
+  am::RuleSnapshot<Fn> reader = r.Snapshot();
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      r.Disable("a");
+    } else {
+      r.Enable("a");
+    }
+    am::RuleSnapshot<Fn> next = r.Snapshot();
+    released.emplace_back(reader);
+    reader = std::move(next);
+  }
+
+  for (const auto& snapshot : released) EXPECT_TRUE(snapshot.expired());
+  EXPECT_EQ(reader, r.Snapshot());
+}
+
+TEST(Ruler, CopyIsIndependent) {
+  am::Ruler<Fn> r;
+  r.Push("a", add1);
+
+  am::Ruler<Fn> copy(r);
+  ASSERT_EQ(copy.GetChain(am::kDefaultChain).size(), 1);
+
+  copy.Disable("a");
+  EXPECT_TRUE(copy.GetChain(am::kDefaultChain).empty());
+  EXPECT_EQ(r.GetChain(am::kDefaultChain).size(), 1);
+}
+
+TEST(Ruler, DispatchListsRulesByTriggerCharacter) {
+  am::Ruler<Fn> r;
+
+  r.Push("hash", add1, {{"alt"}, "#"});
+  r.Push("any", add2, {{"alt"}, ""});
+  r.Push("dash", mul2, {{}, "-*"});
+
+  int x = 1;
+  for (const Fn& fn : r.GetChain(am::kDefaultChain, '#')) fn(x);
+  EXPECT_EQ(x, 1 + 1 + 2);
+
+  x = 1;
+  for (const Fn& fn : r.GetChain(am::kDefaultChain, '*')) fn(x);
+  EXPECT_EQ(x, (1 + 2) * 2);
+
+  EXPECT_EQ(r.GetChain(am::kDefaultChain, 'a').size(), 1);
+  EXPECT_EQ(r.GetChain(r.ChainId("alt"), '-').size(), 1);
+  EXPECT_EQ(r.GetChain(r.ChainId("alt"), '#').size(), 2);
+}
+
+TEST(Ruler, DispatchFollowsAtAndDisable) {
+  am::Ruler<Fn> r;
+
+  r.Push("a", add1, {{}, "x"});
+  r.Push("b", add2);
+  EXPECT_EQ(r.GetChain(am::kDefaultChain, 'y').size(), 1);
+
+  r.At("a", add1);
+  EXPECT_EQ(r.GetChain(am::kDefaultChain, 'y').size(), 2);
+
+  r.Disable("b");
+  EXPECT_EQ(r.GetChain(am::kDefaultChain, 'y').size(), 1);
+}
+
 // ---------- Lookup ----------
 
 TEST(Ruler, FindRuleWorks) {
@@ -192,4 +349,22 @@ TEST(Ruler, ThrowsOnMissingAfter) {
   EXPECT_THROW(r.After("nope", "b", add2), std::runtime_error);
 }
 
+TEST(Ruler, InvalidNamesChangeNothing) {
+  am::Ruler<Fn> r;
+  r.Push("a", add1);
+  r.Push("b", add2);
+  r.Disable("b");
+  am::RuleSnapshot<Fn> before = r.Snapshot();
+
+  const std::vector<std::string> disable = {"a", "nope"};
+  const std::vector<std::string> enable = {"b", "nope"};
+  EXPECT_THROW(r.Disable(disable), std::runtime_error);
+  EXPECT_THROW(r.Enable(enable), std::runtime_error);
+  EXPECT_THROW(r.EnableOnly(enable), std::runtime_error);
+
+  EXPECT_TRUE(r.FindRule("a")->enabled);
+  EXPECT_FALSE(r.FindRule("b")->enabled);
+  EXPECT_EQ(r.Snapshot(), before);
+}
+
 }  // namespace
@@ -0,0 +1,242 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/rules_block/rules_block.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+am::ParseResult ParseTable(const std::string& src) {
+  am::Aethermark md("commonmark");
+  md.Enable({"table"});
+  return md.Parse(src, {});
+}
+
+// Contents of the cell inline tokens of each row, header included.
+std::vector<std::vector<std::string>> Cells(const am::ParseResult& result) {
+  std::vector<std::vector<std::string>> rows;
+  for (std::size_t i = 0; i < result.size(); i++) {
+    const am::Token& token = result[i];
+    if (token.type == am::TokenKind::kTrOpen) rows.emplace_back();
+    if (token.type == am::TokenKind::kInline && !rows.empty()) {
+      rows.back().emplace_back(token.content.View());
+    }
+  }
+  return rows;
+}
+
+// markdown-it's `escapedSplit`, dropping an empty first and last cell.
+std::vector<std::string> ReferenceSplit(std::string_view row) {
+  std::vector<std::string> cells;
+  std::string current;
+  bool escaped = false;
+  for (char c : row) {
+    if (c == '|' && !escaped) {
+      cells.push_back(current);
+      current.clear();
+    } else if (c == '|') {
+      current.back() = '|';
+    } else {
+      current += c;
+    }
+    escaped = c == '\\';
+  }
+  cells.push_back(current);
+  if (!cells.empty() && cells.front().empty()) cells.erase(cells.begin());
+  if (!cells.empty() && cells.back().empty()) cells.pop_back();
+  return cells;
+}
+
+std::string Trim(const std::string& s) {
+  const std::size_t begin = s.find_first_not_of(' ');
+  if (begin == std::string::npos) return "";
+  return s.substr(begin, s.find_last_not_of(' ') - begin + 1);
+}
+
+// ---------- Tables ----------
+
+TEST(RuleTable, EmitsHeaderAndBodyWithAlignment) {
+  am::ParseResult result =
+      ParseTable("| a | b | c |\n|:-|:-:|--:|\n| 1 | 2 |\n");
+
+  ASSERT_EQ(result[0].type, am::TokenKind::kTableOpen);
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 3.0f));
+  EXPECT_EQ(result[3].type, am::TokenKind::kThOpen);
+  EXPECT_EQ(result[3].AttrGet(am::AttrKind::kStyle), "text-align:left");
+  EXPECT_EQ(result[6].AttrGet(am::AttrKind::kStyle), "text-align:center");
+  EXPECT_EQ(result[9].AttrGet(am::AttrKind::kStyle), "text-align:right");
+
+  // Short rows are filled with empty cells
+  const std::vector<std::vector<std::string>> expected = {{"a", "b", "c"},
+                                                          {"1", "2", ""}};
+  EXPECT_EQ(Cells(result), expected);
+}
+
+TEST(RuleTable, CellsBorrowSourceUnlessPipesAreEscaped) {
+  am::ParseResult result = ParseTable("a | b \\| c\n--|--\nx\\|y | z\n");
+
+  const std::vector<std::vector<std::string>> expected = {{"a", "b | c"},
+                                                          {"x|y", "z"}};
+  EXPECT_EQ(Cells(result), expected);
+
+  for (std::size_t i = 0; i < result.size(); i++) {
+    const am::Token& token = result[i];
+    if (token.type != am::TokenKind::kInline) continue;
+    EXPECT_EQ(token.content.IsBorrowed(),
+              token.content.View().find('|') == std::string_view::npos);
+  }
+}
+
+TEST(RuleTable, ExtraCellsAreDropped) {
+  am::ParseResult result = ParseTable("a|b\n-|-\n1|2|3|4\n");
+  const std::vector<std::vector<std::string>> expected = {{"a", "b"},
+                                                          {"1", "2"}};
+  EXPECT_EQ(Cells(result), expected);
+}
+
+TEST(RuleTable, HeaderMustMatchDelimiterRow) {
+  EXPECT_EQ(ParseTable("a|b|c\n-|-\n")[0].type, am::TokenKind::kParagraphOpen);
+  EXPECT_EQ(ParseTable("a\n-|-\n")[0].type, am::TokenKind::kParagraphOpen);
+  EXPECT_EQ(ParseTable("a|b\n-||-\n")[0].type, am::TokenKind::kParagraphOpen);
+  EXPECT_EQ(ParseTable("a|b\n- |-\n")[0].type, am::TokenKind::kParagraphOpen);
+  EXPECT_EQ(ParseTable("a|b\n-|-\n")[0].type, am::TokenKind::kTableOpen);
+}
+
+TEST(RuleTable, EndsAtBlankLineOrTerminator) {
+  am::ParseResult result = ParseTable("a|b\n-|-\n1|2\n> q\n");
+  std::size_t close = 0;
+  while (result[close].type != am::TokenKind::kTableClose) close++;
+  EXPECT_EQ(result[close + 1].type, am::TokenKind::kBlockquoteOpen);
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 3.0f));
+
+  result = ParseTable("a|b\n-|-\n1|2\n\npara\n");
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 3.0f));
+}
+
+TEST(RuleTable, LinesAfterTheTableDoNotGrowTheTokenBuffer) {
+  am::Aethermark md("commonmark");
+  md.Enable({"table"});
+  std::string src = "a|b|c\n-|-|-\n```\n";
+  for (int i = 0; i < 10000; i++) src += "log line\n";
+  src += "```\n";
+
+  am::ParseEnv env;
+  am::TokenList tokens;
+  md.block_parser.Parse(src, md, env, tokens);
+  ASSERT_EQ(tokens[0].type, am::TokenKind::kTableOpen);
+  EXPECT_EQ(tokens[tokens.size() - 1].type, am::TokenKind::kFence);
+  EXPECT_LT(tokens.capacity(), 64u);
+}
+
+TEST(RuleTable, SplitsLongRowsLikeTheByteLoop) {
+  // Enough columns that no generated row is cut short
+  std::string header, delimiter;
+  for (int i = 0; i < 300; i++) {
+    header += "h|";
+    delimiter += "-|";
+  }
+
+  std::mt19937 rng(7);
+  const std::string_view alphabet = "ab |\\\\";
+  for (int round = 0; round < 200; round++) {
+    std::string row = "a";
+    const std::size_t size = rng() % 200;
+    for (std::size_t i = 0; i < size; i++) row += alphabet[rng() % 6];
+    row = Trim(row);
+
+    std::vector<std::string> expected;
+    for (const std::string& cell : ReferenceSplit(row)) {
+      expected.push_back(Trim(cell));
+    }
+    expected.resize(300);
+
+    const auto rows = Cells(ParseTable(header + "\n" + delimiter + "\n" + row));
+    ASSERT_EQ(rows.size(), 2u) << row;
+    EXPECT_EQ(rows[1], expected) << row;
+  }
+}
+
+// ---------- Fences ----------
+
+TEST(RuleFence, EmitsInfoMarkupAndBody) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("```js\none\ntwo\n```\n", {});
+
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_EQ(result[0].type, am::TokenKind::kFence);
+  EXPECT_EQ(result[0].info, "js");
+  EXPECT_EQ(result[0].markup, "```");
+  EXPECT_EQ(result[0].content, "one\ntwo\n");
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 4.0f));
+}
+
+TEST(RuleFence, ClosesOnlyOnALongEnoughMarkerLine) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result =
+      md.Parse("````\na ```` b\n```\n ~~~~\n  ````  \nafter\n", {});
+
+  ASSERT_EQ(result[0].type, am::TokenKind::kFence);
+  EXPECT_EQ(result[0].content, "a ```` b\n```\n ~~~~\n");
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 5.0f));
+  EXPECT_EQ(result[1].type, am::TokenKind::kParagraphOpen);
+}
+
+TEST(RuleFence, WithoutEndRunsToTheEndOfTheBlock) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("~~~\nx\n", {});
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_EQ(result[0].content, "x\n");
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 2.0f));
+
+  result = md.Parse("```", {});
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_EQ(result[0].content, "");
+
+  result = md.Parse("> ```\n> a\nb\n", {});
+  ASSERT_EQ(result[1].type, am::TokenKind::kFence);
+  EXPECT_EQ(result[1].content, "a\n");
+  EXPECT_EQ(result[2].type, am::TokenKind::kBlockquoteClose);
+}
+
+TEST(RuleFence, BacktickInInfoIsNotAFence) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("``` a`b\nfoo\n```\n", {});
+  EXPECT_EQ(result[0].type, am::TokenKind::kParagraphOpen);
+}
+
+TEST(RuleFence, IndentedFenceStripsItsIndent) {
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("  ```\n  a\n b\nc\n   ```\n", {});
+
+  ASSERT_EQ(result.size(), 1u);
+  EXPECT_FALSE(result[0].content.IsBorrowed());
+  EXPECT_EQ(result[0].content, "a\nb\nc\n");
+}
+
+TEST(RuleFence, LongFenceWithMarkersInsideLines) {
+  std::string body;
+  for (int i = 0; i < 10000; i++) body += "log ``` line ~~~\n";
+  am::Aethermark md("commonmark");
+  am::ParseResult result = md.Parse("```\n" + body + "```\nend\n", {});
+
+  ASSERT_EQ(result[0].type, am::TokenKind::kFence);
+  EXPECT_TRUE(result[0].content.IsBorrowed());
+  EXPECT_EQ(result[0].content, body);
+  EXPECT_EQ(result[0].map, std::make_pair(0.0f, 10002.0f));
+}
+
+}  // namespace
@@ -0,0 +1,167 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/rules_core/rules_core.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/rules_core/state_core.hpp"
+#include "aethermark/token.hpp"
+#include "aethermark/token_list.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Run the normalize rule on `src` in place.
+void Normalize(std::string& src) {  // NOLINT(runtime/references)
+  am::Aethermark md("commonmark");
+  am::TokenList tokens;
+  am::ParseEnv env;
+  am::StateCore state(src, md, env, tokens);
+  am::CoreRules::RuleNormalize(state);
+}
+
+// Byte at a time reference for the normalize rule.
+std::string ReferenceNormalize(const std::string& src) {
+  std::string out;
+  for (std::size_t i = 0; i < src.size(); i++) {
+    if (src[i] == '\r') {
+      out += '\n';
+      if (i + 1 < src.size() && src[i + 1] == '\n') i++;
+    } else if (src[i] == '\0') {
+      out += "\xEF\xBF\xBD";
+    } else {
+      out += src[i];
+    }
+  }
+  return out;
+}
+
+// ---------- RuleNormalize ----------
+
+TEST(CoreRules, NormalizeRewritesLineEndingsAndNul) {
+  std::string src = "a\r\nb\rc\n\r\r\nd";
+  src += std::string("e\0f\r", 4);
+  Normalize(src);
+  EXPECT_EQ(src, "a\nb\nc\n\n\nde\xEF\xBF\xBD" "f\n");
+}
+
+TEST(CoreRules, NormalizeLeavesCleanInputUntouched) {
+  std::string src(1000, 'x');
+  src[500] = '\n';
+  const char* data = src.data();
+
+  Normalize(src);
+  EXPECT_EQ(src.data(), data);
+  EXPECT_EQ(src.size(), 1000u);
+}
+
+TEST(CoreRules, NormalizeHandlesBlockBoundaries) {
+  // CRLF and NUL placed across and around every 64-byte boundary
+  for (std::size_t at = 0; at < 200; at++) {
+    std::string src(200, 'a');
+    src[at] = '\r';
+    if (at + 1 < src.size()) src[at + 1] = '\n';
+    src[(at * 7) % src.size()] = '\0';
+
+    const std::string expected = ReferenceNormalize(src);
+    Normalize(src);
+    ASSERT_EQ(src, expected) << "at " << at;
+  }
+}
+
+TEST(CoreRules, NormalizeMatchesReferenceOnRandomInput) {
+  std::mt19937 rng(42);
+  const char alphabet[] = {'a', ' ', '\n', '\r', '\0'};
+  for (int round = 0; round < 200; round++) {
+    std::string src(rng() % 300, 'a');
+    for (char& c : src) c = alphabet[rng() % sizeof(alphabet)];
+
+    const std::string expected = ReferenceNormalize(src);
+    Normalize(src);
+    ASSERT_EQ(src, expected) << "round " << round;
+  }
+}
+
+// Run the text join rule on `tokens`.
+void TextJoin(am::TokenList& tokens) {  // NOLINT(runtime/references)
+  am::Aethermark md("commonmark");
+  std::string src;
+  am::ParseEnv env;
+  am::StateCore state(src, md, env, tokens);
+  am::CoreRules::RuleTextJoin(state);
+}
+
+// Paragraph whose inline token has children of the given types and texts.
+am::TokenList MakeInline(
+    const std::vector<std::pair<am::TokenKind, std::string_view>>& children) {
+  am::TokenList list;
+  list.emplace_back(am::TokenKind::kParagraphOpen, am::HtmlTag::kP,
+                    am::Nesting::kOpening);
+  list.emplace_back(am::TokenKind::kInline, am::HtmlTag::kNone,
+                    am::Nesting::kSelfClosing);
+  list.emplace_back(am::TokenKind::kParagraphClose, am::HtmlTag::kP,
+                    am::Nesting::kClosing);
+
+  list.BeginChildren(1);
+  for (const auto& [type, text] : children) {
+    list.emplace_back(type, am::HtmlTag::kNone, am::Nesting::kSelfClosing)
+        .content.Borrow(text);
+  }
+  list.EndChildren();
+  return list;
+}
+
+// ---------- RuleTextJoin ----------
+
+TEST(CoreRules, TextJoinMergesRunsInPlace) {
+  am::TokenList list = MakeInline({{am::TokenKind::kText, "a"},
+                                   {am::TokenKind::kTextSpecial, "*"},
+                                   {am::TokenKind::kText, "b"},
+                                   {am::TokenKind::kSoftbreak, ""},
+                                   {am::TokenKind::kText, "c"},
+                                   {am::TokenKind::kText, "d"}});
+  TextJoin(list);
+
+  std::span<const am::Token> children = list.Children(list[1]);
+  ASSERT_EQ(children.size(), 3u);
+  EXPECT_EQ(children[0].type, am::TokenKind::kText);
+  EXPECT_EQ(children[0].content, "a*b");
+  EXPECT_EQ(children[1].type, am::TokenKind::kSoftbreak);
+  EXPECT_EQ(children[2].content, "cd");
+}
+
+TEST(CoreRules, TextJoinKeepsContiguousSourceBorrowed) {
+  const std::string_view src = "abc def";
+  am::TokenList list = MakeInline({{am::TokenKind::kText, src.substr(0, 3)},
+                                   {am::TokenKind::kText, src.substr(3, 4)}});
+  TextJoin(list);
+
+  std::span<const am::Token> children = list.Children(list[1]);
+  ASSERT_EQ(children.size(), 1u);
+  EXPECT_TRUE(children[0].content.IsBorrowed());
+  EXPECT_EQ(children[0].content.View().data(), src.data());
+  EXPECT_EQ(children[0].content, "abc def");
+}
+
+TEST(CoreRules, TextJoinLeavesBlockTokensAlone) {
+  am::TokenList list = MakeInline({{am::TokenKind::kText, "a"}});
+  const std::size_t size = list.size();
+  TextJoin(list);
+
+  EXPECT_EQ(list.size(), size);
+  EXPECT_EQ(list.Children(list[1]).size(), 1u);
+  EXPECT_TRUE(list.Children(list[0]).empty());
+}
+
+}  // namespace
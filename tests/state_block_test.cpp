@@ -0,0 +1,267 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/rules_block/state_block.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_env.hpp"
+#include "aethermark/token.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Owns everything a StateBlock refers to.
+struct BlockFixture {
+  explicit BlockFixture(std::string text) : src(std::move(text)) {}
+
+  std::string src;
+  am::Aethermark md{"commonmark"};
+  am::TokenList tokens;
+  am::ParseEnv env;
+  am::StateBlock state{src, md, env, tokens};
+};
+
+// Line metadata as the original byte-at-a-time indexer computed it.
+struct LineMarks {
+  std::vector<int> b_marks, e_marks, t_shift, s_count;
+};
+
+LineMarks ReferenceLineMarks(const std::string& s) {
+  LineMarks marks;
+  int len = static_cast<int>(s.size());
+  int start = 0, pos = 0, indent = 0, offset = 0;
+  bool indent_found = false;
+
+  while (pos < len) {
+    unsigned char ch = s[pos];
+    if (!indent_found) {
+      if (ch == ' ' || ch == '\t') {
+        indent++;
+        offset += ch == '\t' ? 4 - (offset % 4) : 1;
+        pos++;
+        continue;
+      }
+      indent_found = true;
+    }
+    if (ch == '\n' || pos == len - 1) {
+      if (ch != '\n') pos++;
+      marks.b_marks.push_back(start);
+      marks.e_marks.push_back(pos);
+      marks.t_shift.push_back(indent);
+      marks.s_count.push_back(offset);
+      indent_found = false;
+      indent = offset = 0;
+      start = pos + 1;
+    }
+    pos++;
+  }
+
+  marks.b_marks.push_back(len);
+  marks.e_marks.push_back(len);
+  marks.t_shift.push_back(0);
+  marks.s_count.push_back(0);
+  return marks;
+}
+
+void ExpectReferenceLineMarks(const std::string& src) {
+  BlockFixture f(src);
+  LineMarks expected = ReferenceLineMarks(src);
+
+  LineMarks actual;
+  for (const am::LineInfo& info : f.state.lines) {
+    actual.b_marks.push_back(static_cast<int>(info.b_mark));
+    actual.e_marks.push_back(static_cast<int>(info.e_mark));
+    actual.t_shift.push_back(info.t_shift);
+    actual.s_count.push_back(info.s_count);
+    EXPECT_EQ(info.bs_count, 0);
+  }
+
+  EXPECT_EQ(actual.b_marks, expected.b_marks) << src;
+  EXPECT_EQ(actual.e_marks, expected.e_marks) << src;
+  EXPECT_EQ(actual.t_shift, expected.t_shift) << src;
+  EXPECT_EQ(actual.s_count, expected.s_count) << src;
+  EXPECT_EQ(f.state.line_max, static_cast<int>(expected.b_marks.size()) - 1);
+}
+
+// ---------- Line indexing ----------
+
+TEST(StateBlock, IndexesEdgeCasesLikeTheByteLoop) {
+  for (const char* src :
+       {"", "\n", "a", "a\n", "\n\n", "  ", "a\n  ", "a\n \t", "\tx\n",
+        " \t  \tx\n", "\t\t\n  \n", "x\ny\n\nz"}) {
+    ExpectReferenceLineMarks(src);
+  }
+}
+
+TEST(StateBlock, IndexesLongRunsLikeTheByteLoop) {
+  // runs straddling the 16- and 32-byte blocks of the vector scanner
+  for (int n : {15, 16, 17, 31, 32, 33, 64, 100}) {
+    ExpectReferenceLineMarks(std::string(n, ' ') + "x\n");
+    ExpectReferenceLineMarks(std::string(n, '\t') + "x");
+    ExpectReferenceLineMarks(std::string(n, 'x') + "\n" + std::string(n, 'y'));
+    ExpectReferenceLineMarks("a\n" + std::string(n, ' '));
+  }
+}
+
+TEST(StateBlock, IndexesRandomInputLikeTheByteLoop) {
+  std::mt19937 rng(42);
+  const std::string alphabet = "  \t\nab>";
+  std::uniform_int_distribution<std::size_t> pick(0, alphabet.size() - 1);
+
+  for (int i = 0; i < 300; i++) {
+    std::string src(rng() % 200, ' ');
+    for (char& c : src) c = alphabet[pick(rng)];
+    ExpectReferenceLineMarks(src);
+  }
+}
+
+// ---------- Line undo log ----------
+
+bool SameLine(const am::LineInfo& a, const am::LineInfo& b) {
+  return a.b_mark == b.b_mark && a.e_mark == b.e_mark &&
+         a.t_shift == b.t_shift && a.s_count == b.s_count &&
+         a.bs_count == b.bs_count;
+}
+
+TEST(StateBlock, RollbackRestoresSavedLines) {
+  BlockFixture f("one\ntwo\nthree\n");
+  const std::vector<am::LineInfo> before = f.state.lines;
+
+  am::LineCheckpoint outer = f.state.Checkpoint();
+  f.state.SaveLine(0).s_count = 7;
+  f.state.SaveLine(1).b_mark += 1;
+
+  am::LineCheckpoint inner = f.state.Checkpoint();
+  f.state.SaveLine(1).t_shift = 2;
+  f.state.SaveLine(2).s_count = -1;
+
+  f.state.Rollback(inner);
+  EXPECT_EQ(f.state.lines[1].t_shift, before[1].t_shift);
+  EXPECT_EQ(f.state.lines[1].b_mark, before[1].b_mark + 1);
+  EXPECT_TRUE(SameLine(f.state.lines[2], before[2]));
+  EXPECT_EQ(f.state.lines[0].s_count, 7);
+
+  f.state.Rollback(outer);
+  for (std::size_t i = 0; i < before.size(); i++) {
+    EXPECT_TRUE(SameLine(f.state.lines[i], before[i])) << "line " << i;
+  }
+  EXPECT_EQ(f.state.Checkpoint(), outer);
+}
+
+TEST(StateBlock, NestedBlockquotesRestoreLines) {
+  BlockFixture f("> a\n>> b\n> > > c\nlazy\n\n> d\n");
+  const std::vector<am::LineInfo> before = f.state.lines;
+
+  f.md.block_parser.Tokenize(f.state, 0, f.state.line_max);
+
+  EXPECT_EQ(f.state.Checkpoint(), 0u);
+  for (std::size_t i = 0; i < before.size(); i++) {
+    EXPECT_TRUE(SameLine(f.state.lines[i], before[i])) << "line " << i;
+  }
+}
+
+// ---------- GetLines & AppendLines ----------
+
+TEST(StateBlock, GetLinesStripsIndentAndExpandsTabs) {
+  BlockFixture f("    one\n\ttwo\n      three\n");
+
+  EXPECT_EQ(f.state.GetLines(0, 3, 4, false), "one\ntwo\n  three");
+  EXPECT_EQ(f.state.GetLines(0, 2, 2, true), "  one\n  two\n");
+  EXPECT_EQ(f.state.GetLines(1, 1, 0, true), "");
+}
+
+TEST(StateBlock, AppendLinesAppendsToTheBuffer) {
+  BlockFixture f("    one\n\ttwo\n");
+
+  std::string out = "prefix:";
+  f.state.AppendLines(0, 2, 2, false, out);
+  EXPECT_EQ(out, "prefix:  one\n  two");
+}
+
+TEST(StateBlock, AppendLinesGrowsThePmrBufferOnce) {
+  BlockFixture f("> a\n> b\n> c\n");
+  f.md.block_parser.Tokenize(f.state, 0, f.state.line_max);
+
+  std::pmr::monotonic_buffer_resource arena;
+  std::pmr::string out(&arena);
+  f.state.AppendLines(0, 3, 0, true, out);
+
+  EXPECT_EQ(std::string(out), f.state.GetLines(0, 3, 0, true));
+  const std::size_t sso = std::pmr::string().capacity();
+  EXPECT_EQ(out.capacity(), std::max(out.size(), sso));
+}
+
+TEST(StateBlock, AppendLinesClampsMissingFinalNewline) {
+  BlockFixture f("  no newline");
+
+  std::string out;
+  f.state.AppendLines(0, 1, 2, true, out);
+  EXPECT_EQ(out, "no newline");
+}
+
+// ---------- GetLinesView ----------
+
+TEST(StateBlock, LinesViewMatchesGetLinesWhenContiguous) {
+  BlockFixture f("first line\nsecond line\nthird\n");
+
+  std::optional<std::string_view> view = f.state.GetLinesView(0, 3, 0, false);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(*view, f.state.GetLines(0, 3, 0, false));
+  EXPECT_EQ(view->data(), f.src.data());
+
+  view = f.state.GetLinesView(1, 3, 0, true);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(*view, f.state.GetLines(1, 3, 0, true));
+}
+
+TEST(StateBlock, LinesViewStripsIndentOfFirstLineOnly) {
+  BlockFixture f("    code\nmore\n");
+
+  std::optional<std::string_view> view = f.state.GetLinesView(0, 1, 4, true);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(*view, "code\n");
+}
+
+TEST(StateBlock, LinesViewRejectsGapsBetweenLines) {
+  BlockFixture f("    one\n    two\n");
+
+  EXPECT_FALSE(f.state.GetLinesView(0, 2, 4, false).has_value());
+  EXPECT_EQ(f.state.GetLines(0, 2, 4, false), "one\ntwo");
+}
+
+TEST(StateBlock, LinesViewRejectsPartialTabExpansion) {
+  BlockFixture f("\tcode\n");
+
+  EXPECT_FALSE(f.state.GetLinesView(0, 1, 2, false).has_value());
+  EXPECT_EQ(f.state.GetLines(0, 1, 2, false), "  code");
+}
+
+TEST(StateBlock, LinesViewOfEmptyRangeIsEmpty) {
+  BlockFixture f("text\n");
+
+  std::optional<std::string_view> view = f.state.GetLinesView(1, 1, 0, false);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_TRUE(view->empty());
+}
+
+TEST(StateBlock, LinesViewClampsMissingFinalNewline) {
+  BlockFixture f("no newline");
+
+  std::optional<std::string_view> view = f.state.GetLinesView(0, 1, 0, true);
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(*view, "no newline");
+}
+
+}  // namespace
@@ -0,0 +1,115 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/static_aethermark.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "aethermark/aethermark.hpp"
+#include "aethermark/parse_context.hpp"
+#include "aethermark/parse_result.hpp"
+#include "aethermark/token.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// Covers every rule bound in `StaticPreset<PresetId::kCommonmark>::Block`,
+// with lines starting on each of their trigger characters.
+const std::vector<std::string> kDocuments = {
+    "",
+    "hello\nworld\n",
+    "para one\n\npara two\r\nstill two\n",
+    "> quote\n> more\nlazy\n\nafter\n",
+    "> outer\n>> inner\n\n    code\n    block\n\ntext\n",
+    "# a heading\n- a list\n\n---\n",
+    "\ttabbed code\n\n  indented para\n",
+    "a *b c\n",
+    "x ** y _ z\n\nq [r s\n",
+    "hello &amp; world\n",
+    "```js\nlet a = 1;\n```\n~~~\nunclosed\n",
+    "- item\n  ```\n  code\n  ```\n> ~~~\n> quoted\n",
+    "[foo]: /url \"title\"\n\n[foo] and [bar]\n\n[bar]: <b>\n",
+    "<div>\n*not* parsed\n</div>\n\n<!-- note -->\ntext\n",
+    "Title\n=====\n\nSub\ntitle\n---\n",
+    "1. one\n2. two\n\n3) three\n10. ten\n",
+    "* a\n+ b\n\n***\n___\n",
+};
+
+void ExpectSameTokens(const am::ParseResult& expected,
+                      const am::ParseResult& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    const am::Token& a = expected.Tokens()[i];
+    const am::Token& b = actual.Tokens()[i];
+    EXPECT_EQ(a.type, b.type) << "token " << i;
+    EXPECT_EQ(a.tag, b.tag) << "token " << i;
+    EXPECT_EQ(a.nesting, b.nesting) << "token " << i;
+    EXPECT_EQ(a.level, b.level) << "token " << i;
+    EXPECT_EQ(a.map, b.map) << "token " << i;
+    EXPECT_EQ(a.content, b.content) << "token " << i;
+    EXPECT_EQ(a.markup, b.markup) << "token " << i;
+    EXPECT_EQ(a.info, b.info) << "token " << i;
+    EXPECT_EQ(a.children, b.children) << "token " << i;
+  }
+}
+
+// ---------- Parity with Aethermark ----------
+
+TEST(StaticAethermark, CommonmarkMatchesDynamicParser) {
+  am::Aethermark dynamic("commonmark");
+  am::StaticAethermark<am::PresetId::kCommonmark> fixed;
+
+  for (const std::string& doc : kDocuments) {
+    SCOPED_TRACE(doc);
+    ExpectSameTokens(dynamic.Parse(doc, {}), fixed.Parse(doc, {}));
+  }
+}
+
+TEST(StaticAethermark, ZeroMatchesDynamicParser) {
+  am::Aethermark dynamic("zero");
+  am::StaticAethermark<am::PresetId::kZero> fixed;
+
+  for (const std::string& doc : kDocuments) {
+    SCOPED_TRACE(doc);
+    ExpectSameTokens(dynamic.Parse(doc, {}), fixed.Parse(doc, {}));
+  }
+}
+
+TEST(StaticAethermark, ParseInlineMatchesDynamicParser) {
+  am::Aethermark dynamic("commonmark");
+  am::StaticAethermark<am::PresetId::kCommonmark> fixed;
+
+  ExpectSameTokens(dynamic.ParseInline("some *inline* text", {}),
+                   fixed.ParseInline("some *inline* text", {}));
+}
+
+TEST(StaticAethermark, ParseInlineReusesResultsAndContexts) {
+  am::Aethermark dynamic("commonmark");
+  am::StaticAethermark<am::PresetId::kCommonmark> fixed;
+  const am::ParseResult expected = dynamic.ParseInline("a `b` *c*", {});
+
+  am::ParseResult out;
+  fixed.ParseInline("stale **text**", {}, out);
+  fixed.ParseInline("a `b` *c*", {}, out);
+  ExpectSameTokens(expected, out);
+
+  am::ParseContext context;
+  fixed.ParseInline("stale **text**", {}, context);
+  ExpectSameTokens(expected, fixed.ParseInline("a `b` *c*", {}, context));
+}
+
+TEST(StaticAethermark, UsesPresetOptions) {
+  am::StaticAethermark<am::PresetId::kCommonmark> fixed;
+  EXPECT_TRUE(fixed.options().html);
+  EXPECT_EQ(fixed.options().max_nesting, 20);
+
+  am::Options options;
+  options.max_nesting = 3;
+  am::StaticAethermark<am::PresetId::kCommonmark> custom(options);
+  EXPECT_EQ(custom.options().max_nesting, 3);
+}
+
+}  // namespace
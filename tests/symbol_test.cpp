@@ -0,0 +1,129 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/symbol.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "aethermark/token.hpp"
+#include "aethermark/token_type.hpp"
+
+namespace am = aethermark;
+
+namespace {
+
+// ---------- Built-in names ----------
+
+TEST(Symbol, BuiltinsResolveToTheirNames) {
+  EXPECT_EQ(am::TokenType(am::TokenKind::kParagraphOpen).Name(),
+            "paragraph_open");
+  EXPECT_EQ(am::TokenType(am::TokenKind::kInline).Name(), "inline");
+  EXPECT_EQ(am::TokenTag(am::HtmlTag::kBlockquote).Name(), "blockquote");
+  EXPECT_EQ(am::TokenTag(am::HtmlTag::kH6).Name(), "h6");
+}
+
+TEST(Symbol, InterningBuiltinNameYieldsBuiltinId) {
+  am::TokenType type("code_block");
+  EXPECT_EQ(type, am::TokenKind::kCodeBlock);
+  EXPECT_EQ(type.GetKind(), am::TokenKind::kCodeBlock);
+  EXPECT_EQ(am::TokenTag("p"), am::HtmlTag::kP);
+}
+
+TEST(Symbol, DefaultIsEmpty) {
+  am::TokenType type;
+  EXPECT_TRUE(type.empty());
+  EXPECT_EQ(type, am::TokenKind::kNone);
+  EXPECT_EQ(type.Name(), "");
+  EXPECT_FALSE(am::TokenType(am::TokenKind::kText).empty());
+}
+
+TEST(Symbol, ComparesWithNames) {
+  am::TokenType type(am::TokenKind::kText);
+  EXPECT_TRUE(type == "text");
+  EXPECT_FALSE(type == "inline");
+  EXPECT_TRUE("text" == type);
+}
+
+// ---------- Runtime registration ----------
+
+TEST(Symbol, RegistersPluginKinds) {
+  am::TokenType custom = am::TokenType::Register("container_warning_open");
+
+  EXPECT_GT(custom.Id(),
+            static_cast<std::uint16_t>(am::TokenKind::kHtmlInline));
+  EXPECT_EQ(custom.Name(), "container_warning_open");
+  EXPECT_EQ(am::TokenType::Register("container_warning_open"), custom);
+  EXPECT_EQ(am::TokenType("container_warning_open"), custom);
+}
+
+TEST(Symbol, FindDoesNotRegister) {
+  EXPECT_FALSE(am::TokenType::Find("never_registered_kind").has_value());
+  EXPECT_FALSE(am::TokenType::Find("never_registered_kind").has_value());
+
+  std::optional<am::TokenType> found = am::TokenType::Find("fence");
+  ASSERT_TRUE(found.has_value());
+  EXPECT_EQ(*found, am::TokenKind::kFence);
+}
+
+TEST(Symbol, DomainsAreIndependent) {
+  am::TokenTag tag = am::TokenTag::Register("aside");
+  EXPECT_FALSE(am::TokenType::Find("aside").has_value());
+  EXPECT_EQ(tag.Name(), "aside");
+}
+
+TEST(Symbol, ConcurrentRegistrationIsConsistent) {
+  const int kThreads = 8;
+  const int kNames = 200;
+  std::vector<std::vector<std::uint16_t>> ids(kThreads);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([t, &ids] {
+      for (int i = 0; i < kNames; i++) {
+        std::string name = "concurrent_" + std::to_string(i);
+        ids[t].push_back(am::TokenType::Register(name).Id());
+      }
+    });
+  }
+  for (std::thread& th : threads) th.join();
+
+  for (int t = 1; t < kThreads; t++) EXPECT_EQ(ids[t], ids[0]);
+  std::unordered_set<std::uint16_t> unique(ids[0].begin(), ids[0].end());
+  EXPECT_EQ(unique.size(), static_cast<std::size_t>(kNames));
+}
+
+// ---------- Tokens ----------
+
+TEST(Symbol, TokensCarryInternedTypeAndTag) {
+  am::Token t(am::TokenKind::kHeadingOpen, am::HtmlTag::kH2,
+              am::Nesting::kOpening);
+  EXPECT_EQ(t.type, "heading_open");
+  EXPECT_EQ(t.tag, "h2");
+
+  am::Token named("heading_open", "h2", am::Nesting::kOpening);
+  EXPECT_EQ(named.type, t.type);
+  EXPECT_EQ(named.tag, t.tag);
+}
+
+TEST(Symbol, TypeDispatchSwitchesOnKind) {
+  am::Token t(am::TokenKind::kCodeBlock, am::HtmlTag::kCode,
+              am::Nesting::kSelfClosing);
+  int hit = 0;
+  switch (t.type.GetKind()) {
+    case am::TokenKind::kCodeBlock:
+      hit = 1;
+      break;
+    default:
+      hit = 2;
+      break;
+  }
+  EXPECT_EQ(hit, 1);
+}
+
+}  // namespace
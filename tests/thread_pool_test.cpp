@@ -0,0 +1,91 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/thread_pool.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace am = aethermark;
+
+namespace {
+
+// ---------- ParallelFor ----------
+
+TEST(ThreadPool, RunsEveryTaskOnce) {
+  am::ThreadPool pool(3);
+  std::vector<std::atomic<int>> runs(1000);
+
+  const std::size_t slots =
+      pool.ParallelFor(runs.size(), 0, [&](std::size_t task, std::size_t) {
+        runs[task]++;
+      });
+
+  EXPECT_EQ(slots, 4u);
+  for (const std::atomic<int>& count : runs) EXPECT_EQ(count, 1);
+}
+
+TEST(ThreadPool, SlotsStayBelowTheLimit) {
+  am::ThreadPool pool(3);
+  std::atomic<std::size_t> max_slot = 0;
+
+  const std::size_t slots =
+      pool.ParallelFor(100, 2, [&](std::size_t, std::size_t slot) {
+        std::size_t seen = max_slot;
+        while (slot > seen && !max_slot.compare_exchange_weak(seen, slot)) {
+        }
+      });
+
+  EXPECT_EQ(slots, 2u);
+  EXPECT_LT(max_slot, 2u);
+}
+
+TEST(ThreadPool, WithoutWorkersRunsOnTheCaller) {
+  am::ThreadPool pool(0);
+  std::vector<std::size_t> order;
+
+  pool.ParallelFor(5, 0, [&](std::size_t task, std::size_t slot) {
+    EXPECT_EQ(slot, 0u);
+    order.push_back(task);
+  });
+
+  EXPECT_EQ(order, std::vector<std::size_t>({0, 1, 2, 3, 4}));
+}
+
+TEST(ThreadPool, NestedLoopRunsOnTheCallingThread) {
+  am::ThreadPool pool(2);
+  std::atomic<int> inner = 0;
+
+  pool.ParallelFor(4, 0, [&](std::size_t, std::size_t) {
+    const std::size_t slots = pool.ParallelFor(
+        10, 0, [&](std::size_t, std::size_t slot) {
+          EXPECT_EQ(slot, 0u);
+          inner++;
+        });
+    EXPECT_EQ(slots, 1u);
+  });
+
+  EXPECT_EQ(inner, 40);
+}
+
+TEST(ThreadPool, RethrowsTaskExceptions) {
+  am::ThreadPool pool(2);
+
+  EXPECT_THROW(pool.ParallelFor(100, 0,
+                                [](std::size_t task, std::size_t) {
+                                  if (task == 42) {
+                                    throw std::runtime_error("task failed");
+                                  }
+                                }),
+               std::runtime_error);
+
+  // The pool is still usable afterwards
+  std::atomic<int> runs = 0;
+  pool.ParallelFor(10, 0, [&](std::size_t, std::size_t) { runs++; });
+  EXPECT_EQ(runs, 10);
+}
+
+}  // namespace
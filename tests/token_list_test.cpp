@@ -0,0 +1,155 @@
+// NOLINT (copyright/legal)
+
+#include "aethermark/token_list.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace am = aethermark;
+
+namespace {
+
+// Builds `paragraph_open, inline, paragraph_close` with two text children of
+// the inline token appended after the roots, like the core chain does.
+am::TokenList MakeParagraph() {
+  am::TokenList list;
+  list.emplace_back("paragraph_open", "p", am::Nesting::kOpening);
+  list.emplace_back("inline", "", am::Nesting::kSelfClosing);
+  list.emplace_back("paragraph_close", "p", am::Nesting::kClosing);
+
+  list.BeginChildren(1);
+  list.emplace_back("text", "", am::Nesting::kSelfClosing).content = "a";
+  list.emplace_back("text", "", am::Nesting::kSelfClosing).content = "b";
+  list.EndChildren();
+  return list;
+}
+
+// ---------- Roots & Children ----------
+
+TEST(TokenList, ChildrenAreIndexRangesIntoTheSameBuffer) {
+  am::TokenList list = MakeParagraph();
+
+  ASSERT_EQ(list.size(), 5u);
+  EXPECT_EQ(list[1].children, (am::TokenRange{3, 5}));
+
+  auto children = list.Children(list[1]);
+  ASSERT_EQ(children.size(), 2u);
+  EXPECT_EQ(children.data(), &list[3]);
+  EXPECT_EQ(children[1].content, "b");
+  EXPECT_TRUE(list.Children(list[0]).empty());
+}
+
+TEST(TokenList, RootsSkipChildren) {
+  am::TokenList list = MakeParagraph();
+  list.emplace_back("hr", "hr", am::Nesting::kSelfClosing);
+
+  std::vector<std::string> types;
+  for (const am::Token& token : list.Roots()) {
+    types.emplace_back(token.type.Name());
+  }
+
+  EXPECT_EQ(types, (std::vector<std::string>{"paragraph_open", "inline",
+                                             "paragraph_close", "hr"}));
+  ASSERT_EQ(list.RootRuns().size(), 2u);
+  EXPECT_EQ(list.RootRuns()[1], (am::TokenRange{5, 6}));
+}
+
+TEST(TokenList, WalkVisitsChildrenAfterTheirParent) {
+  am::TokenList list = MakeParagraph();
+
+  std::vector<std::pair<std::string, int>> visited;
+  list.Walk([&](const am::Token& token, int depth) {
+    visited.emplace_back(std::string(token.type.Name()), depth);
+  });
+
+  std::vector<std::pair<std::string, int>> expected = {
+      {"paragraph_open", 0}, {"inline", 0},          {"text", 1},
+      {"text", 1},           {"paragraph_close", 0},
+  };
+  EXPECT_EQ(visited, expected);
+}
+
+TEST(TokenList, CopyingATokenDoesNotCopyItsChildren) {
+  am::TokenList list = MakeParagraph();
+
+  am::Token copy(list[1]);
+  EXPECT_EQ(copy.children, list[1].children);
+  EXPECT_EQ(list.size(), 5u);
+}
+
+// ---------- Mutation ----------
+
+TEST(TokenList, TruncateChildrenDropsTrailingChildren) {
+  am::TokenList list = MakeParagraph();
+
+  list.TruncateChildren(1, 1);
+  ASSERT_EQ(list.Children(list[1]).size(), 1u);
+  EXPECT_EQ(list.Children(list[1])[0].content, "a");
+
+  list.TruncateChildren(1, 5);
+  EXPECT_EQ(list.Children(list[1]).size(), 1u);
+}
+
+TEST(TokenList, JoinTextChildrenMergesRuns) {
+  am::TokenList list = MakeParagraph();
+
+  list.JoinTextChildren(1);
+  ASSERT_EQ(list.Children(list[1]).size(), 1u);
+  EXPECT_EQ(list.Children(list[1])[0].content, "ab");
+}
+
+TEST(TokenList, CompactRemovesDroppedChildren) {
+  am::TokenList list = MakeParagraph();
+  list.emplace_back("hr", "hr", am::Nesting::kSelfClosing);
+
+  list.JoinTextChildren(1);
+  ASSERT_EQ(list.size(), 6u);
+  list.Compact();
+
+  ASSERT_EQ(list.size(), 5u);
+  EXPECT_EQ(list[1].children, (am::TokenRange{3, 4}));
+  EXPECT_EQ(list[3].content, "ab");
+  EXPECT_EQ(list[4].type, am::TokenKind::kHr);
+  const std::vector<am::TokenRange> runs = {{0, 3}, {4, 5}};
+  EXPECT_EQ(std::vector<am::TokenRange>(list.RootRuns().begin(),
+                                        list.RootRuns().end()),
+            runs);
+}
+
+TEST(TokenList, CompactDropsReplacedChildren) {
+  am::TokenList list = MakeParagraph();
+
+  list.BeginChildren(1);
+  list.emplace_back("text", "", am::Nesting::kSelfClosing).content = "c";
+  list.EndChildren();
+  list.Compact();
+
+  ASSERT_EQ(list.size(), 4u);
+  EXPECT_EQ(list[1].children, (am::TokenRange{3, 4}));
+  EXPECT_EQ(list[3].content, "c");
+}
+
+TEST(TokenList, NestedBeginChildrenThrows) {
+  am::TokenList list = MakeParagraph();
+
+  list.BeginChildren(1);
+  EXPECT_THROW(list.BeginChildren(0), std::runtime_error);
+  list.EndChildren();
+  EXPECT_THROW(list.EndChildren(), std::runtime_error);
+  EXPECT_THROW(list.BeginChildren(99), std::runtime_error);
+}
+
+TEST(TokenList, ClearResetsTree) {
+  am::TokenList list = MakeParagraph();
+
+  list.clear();
+  EXPECT_TRUE(list.empty());
+  EXPECT_TRUE(list.RootRuns().empty());
+  EXPECT_EQ(list.Roots().begin(), list.Roots().end());
+}
+
+}  // namespace
@@ -4,7 +4,12 @@
 
 #include <gtest/gtest.h>
 
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -12,6 +17,27 @@ namespace am = aethermark;
 
 namespace {
 
+// Resource that counts the blocks requested from it.
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  int allocations = 0;
+  int live = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t align) override {
+    allocations++;
+    live++;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+    live--;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
 // ---------- Constructor & Basic State ----------
 
 TEST(Token, InitializesMembersCorrectly) {
@@ -25,9 +51,9 @@ TEST(Token, InitializesMembersCorrectly) {
 TEST(Token, DefaultOptionalsAndStringsAreEmpty) {
   am::Token t("a", "b", am::Nesting::kSelfClosing);
 
-  EXPECT_FALSE(t.attrs.has_value());
+  EXPECT_TRUE(t.attrs.empty());
   EXPECT_FALSE(t.map.has_value());
-  EXPECT_FALSE(t.children.has_value());
+  EXPECT_TRUE(t.children.empty());
 
   EXPECT_EQ(t.content, "");
   EXPECT_EQ(t.markup, "");
@@ -46,8 +72,8 @@ TEST(Token, AddsMultipleAttributes) {
       {"class", "lead"}, {"id", "first"}, {"data-x", "42"}};
   t.AttrPush(pushData);
 
-  ASSERT_TRUE(t.attrs.has_value());
-  auto attrs = t.attrs.value();
+  ASSERT_FALSE(t.attrs.empty());
+  const auto& attrs = t.attrs;
 
   // Ignore possible leading empty attribute
   size_t offset = (!attrs.empty() && attrs[0].first.empty()) ? 1 : 0;
@@ -70,7 +96,7 @@ TEST(Token, PreservesOrderAcrossMultiplePushes) {
   t.AttrPush({{"c", "3"}});
   t.AttrPush({{"a", "4"}});
 
-  auto attrs = t.attrs.value();
+  const auto& attrs = t.attrs;
   size_t offset = (!attrs.empty() && attrs[0].first.empty()) ? 1 : 0;
   ASSERT_GE(attrs.size(), 4u + offset);
 
@@ -83,8 +109,8 @@ TEST(Token, PreservesOrderAcrossMultiplePushes) {
 TEST(Token, HandlesEmptyVectorGracefully) {
   am::Token t("z", "z", am::Nesting::kOpening);
   t.AttrPush({});
-  EXPECT_TRUE(t.attrs.has_value());
-  EXPECT_TRUE(t.attrs->empty());
+  EXPECT_TRUE(t.attrs.empty());
+  EXPECT_EQ(t.attrs.data(), nullptr);
 }
 
 // ---------- AttrIndex ----------
@@ -135,7 +161,7 @@ TEST(Token, UpdatesExistingAttributeValue) {
   t.AttrPush({{"k", "v1"}, {"k", "v2"}, {"other", "o"}});
   t.AttrSet("k", "vNew");
 
-  auto attrs = t.attrs.value();
+  const auto& attrs = t.attrs;
 
   // Last duplicate may be updated or cleared
   bool found = false;
@@ -154,14 +180,8 @@ TEST(Token, AppendsIfAttributeDoesNotExist) {
   // Perform AttrSet
   t.AttrSet("new", "value");
 
-  // Safely get the optional first
-  auto optAttrs = t.attrs;
-  ASSERT_TRUE(optAttrs.has_value()) << "attrs should be initialized by AttrSet";
-
-  // Access the vector safely
-  const auto& attrs = optAttrs.value();
-
-  EXPECT_EQ(attrs.size(), 1u);
+  const auto& attrs = t.attrs;
+  ASSERT_EQ(attrs.size(), 1u);
   EXPECT_EQ(attrs[0].first, "new");
   EXPECT_EQ(attrs[0].second, "value");
 }
@@ -172,13 +192,7 @@ TEST(Token, HandlesEmptyKeyAndValue) {
   // Set attribute with empty key and value
   t.AttrSet("", "");
 
-  // Safely get the optional
-  auto optAttrs = t.attrs;
-  ASSERT_TRUE(optAttrs.has_value()) << "attrs should be initialized by AttrSet";
-
-  // Access the vector safely
-  const auto& attrs = optAttrs.value();
-
+  const auto& attrs = t.attrs;
   ASSERT_FALSE(attrs.empty()) << "attrs vector should have one element";
   EXPECT_EQ(attrs[0].first, "");
   EXPECT_EQ(attrs[0].second, "");
@@ -221,6 +235,85 @@ TEST(Token, HandlesTrailingSpaceInExistingValue) {
   EXPECT_TRUE(t.AttrGet("class").value().find("b") != std::string::npos);
 }
 
+// ---------- Interned names & inline storage ----------
+
+TEST(Token, BuiltinAttrNamesAreInterned) {
+  am::Token t("link_open", "a", am::Nesting::kOpening);
+  t.AttrSet(am::AttrKind::kHref, "https://example.com");
+
+  EXPECT_EQ(t.attrs.front().first, am::AttrKind::kHref);
+  EXPECT_EQ(t.AttrIndex("href"), 0);
+  EXPECT_EQ(t.AttrGet("href").value(), "https://example.com");
+  EXPECT_EQ(t.AttrGet(am::AttrKind::kHref).value(), "https://example.com");
+}
+
+TEST(Token, AttrGetReturnsViewOfStoredValue) {
+  am::Token t("image", "img", am::Nesting::kSelfClosing);
+  t.AttrSet(am::AttrKind::kSrc, "a-long-enough-image-path-to-skip-sso.png");
+
+  std::optional<std::string_view> src = t.AttrGet(am::AttrKind::kSrc);
+  ASSERT_TRUE(src.has_value());
+  EXPECT_EQ(src->data(), t.attrs.front().second.data());
+}
+
+TEST(Token, LookupOfUnknownNameDoesNotIntern) {
+  am::Token t("a", "b", am::Nesting::kOpening);
+
+  EXPECT_FALSE(t.AttrGet("never-set-anywhere").has_value());
+  EXPECT_FALSE(am::AttrName::Find("never-set-anywhere").has_value());
+}
+
+TEST(Token, AttributesAllocateOnFirstUse) {
+  CountingResource resource;
+  am::Token t("image", "img", am::Nesting::kSelfClosing,
+              am::TokenAllocator(&resource));
+  EXPECT_EQ(resource.allocations, 0);
+
+  // one array holds the attributes of a link or an image
+  t.AttrSet(am::AttrKind::kSrc, "a.png");
+  EXPECT_EQ(resource.allocations, 1);
+  EXPECT_EQ(t.attrs.capacity(), am::TokenAttrs::kInitialCapacity);
+  t.AttrSet(am::AttrKind::kAlt, "");
+  t.AttrSet(am::AttrKind::kTitle, "t");
+  EXPECT_EQ(resource.allocations, 1);
+
+  // a fourth moves them to a larger array and frees the first
+  const am::TokenAttr* data = t.attrs.data();
+  t.AttrSet(am::AttrKind::kClass, "wide");
+  EXPECT_EQ(resource.allocations, 2);
+  EXPECT_EQ(resource.live, 1);
+  EXPECT_NE(t.attrs.data(), data);
+  ASSERT_EQ(t.attrs.size(), 4u);
+  EXPECT_EQ(t.AttrGet(am::AttrKind::kSrc).value(), "a.png");
+  EXPECT_EQ(t.AttrGet(am::AttrKind::kClass).value(), "wide");
+}
+
+TEST(Token, EmptyAttrsDoNotAllocate) {
+  am::TokenAttrs attrs;
+  EXPECT_EQ(attrs.data(), nullptr);
+  EXPECT_EQ(attrs.capacity(), 0u);
+}
+
+TEST(Token, MovedAttrsKeepValues) {
+  am::TokenAttrs attrs;
+  attrs.emplace_back(am::AttrKind::kId, "x");
+  for (int i = 0; i < 5; ++i) attrs.emplace_back(am::AttrKind::kClass, "c");
+
+  am::TokenAttrs moved(std::move(attrs));
+  EXPECT_TRUE(attrs.empty());  // NOLINT(bugprone-use-after-move)
+  ASSERT_EQ(moved.size(), 6u);
+  EXPECT_EQ(moved[0].second, "x");
+
+  am::TokenAttrs small;
+  small.emplace_back(am::AttrKind::kId, "y");
+  const am::TokenAttr* data = small.data();
+  moved = std::move(small);
+  ASSERT_EQ(moved.size(), 1u);
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_EQ(moved.at(0).second, "y");
+  EXPECT_THROW(moved.at(1), std::out_of_range);
+}
+
 // ---------- Enum ----------
 
 TEST(Token, ValuesAndAccessorsCorrect) {
@@ -237,6 +330,62 @@ TEST(Token, ValuesAndAccessorsCorrect) {
   EXPECT_EQ(t3.nesting, am::Nesting::kOpening);
 }
 
+// ---------- TokenString ----------
+
+TEST(Token, ContentBorrowsWithoutCopy) {
+  const std::string source = "some source text";
+  am::Token t("text", "", am::Nesting::kSelfClosing);
+
+  t.content.Borrow(std::string_view(source).substr(5, 6));
+  EXPECT_TRUE(t.content.IsBorrowed());
+  EXPECT_EQ(t.content, "source");
+  EXPECT_EQ(t.content.View().data(), source.data() + 5);
+}
+
+TEST(Token, ContentAssignmentOwnsCopy) {
+  std::string text = "owned text";
+  am::Token t("text", "", am::Nesting::kSelfClosing);
+
+  t.content = text;
+  text[0] = 'X';
+  EXPECT_FALSE(t.content.IsBorrowed());
+  EXPECT_EQ(t.content, "owned text");
+}
+
+TEST(Token, ContentAppendConvertsBorrowedToOwned) {
+  const std::string source = "left";
+  am::Token t("text", "", am::Nesting::kSelfClosing);
+
+  t.content.Borrow(source);
+  t.content.Append(" right");
+  EXPECT_FALSE(t.content.IsBorrowed());
+  EXPECT_EQ(t.content, "left right");
+  EXPECT_EQ(source, "left");
+}
+
+TEST(Token, EmptyBorrowedContentStaysBorrowed) {
+  am::Token t("text", "", am::Nesting::kSelfClosing);
+  EXPECT_FALSE(t.content.IsBorrowed());
+
+  t.content.Borrow(std::string_view());
+  EXPECT_TRUE(t.content.IsBorrowed());
+  EXPECT_TRUE(t.content.empty());
+
+  t.content = "";
+  EXPECT_FALSE(t.content.IsBorrowed());
+}
+
+TEST(Token, CopiedTokenSharesBorrowedView) {
+  const std::string source = "shared";
+  am::Token t("text", "", am::Nesting::kSelfClosing);
+  t.content.Borrow(source);
+
+  am::Token copy = t;
+  EXPECT_TRUE(copy.content.IsBorrowed());
+  EXPECT_EQ(copy.content.View().data(), source.data());
+  EXPECT_EQ(copy.content, t.content);
+}
+
 // ---------- Stress & Robustness ----------
 
 TEST(Token, HandlesLargeNumberOfAttributes) {